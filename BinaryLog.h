@@ -0,0 +1,379 @@
+#ifndef BINARYLOG_H
+#define BINARYLOG_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+#include <stdexcept>
+
+#include "LogLevel.h"
+
+using namespace std;
+
+// Events that can be logged without formatting; the numbers are part of the file format
+enum class LogEvent : uint16_t {
+    SESSION = 0,              // wall clock and steady clock (ns) when a writer opened the file
+    TEXT = 1,                 // an already formatted message
+    DAY_STARTED = 2,
+    DAY_COMPLETED = 3,
+    BUILDING_ADDED = 4,
+    TRANSPORT_ADDED = 5,
+    CITIZEN_JOINED = 6,
+    HOUSING_ADDED = 7,
+    SERVICE_ADDED = 8,
+    MONITORED_BUILDING = 9,
+    MONITORED_TRANSPORT = 10,
+    MONITORED_CITIZEN = 11,
+    MONITORED_COHORT = 12,
+    MONITORED_SERVICE = 13,
+    MONITORED_HOUSING = 14,
+    AIR_THRESHOLD = 15,
+    WATER_THRESHOLD = 16,
+    NOISE_THRESHOLD = 17,
+    SOLID_WASTE_THRESHOLD = 18,
+    COUNT
+};
+
+struct LogEventInfo {
+    const char* name;
+    const char* format;   // "{}" stands for the next argument
+};
+
+// Severity and category of an event, constant so filtered call sites fold away
+constexpr LogLevel logEventLevel(LogEvent event) {
+    switch (event) {
+        case LogEvent::BUILDING_ADDED:
+        case LogEvent::TRANSPORT_ADDED:
+        case LogEvent::CITIZEN_JOINED:
+        case LogEvent::HOUSING_ADDED:
+        case LogEvent::SERVICE_ADDED:
+        case LogEvent::MONITORED_BUILDING:
+        case LogEvent::MONITORED_TRANSPORT:
+        case LogEvent::MONITORED_CITIZEN:
+        case LogEvent::MONITORED_COHORT:
+        case LogEvent::MONITORED_SERVICE:
+        case LogEvent::MONITORED_HOUSING:
+            return LogLevel::VERBOSE;
+        case LogEvent::AIR_THRESHOLD:
+        case LogEvent::WATER_THRESHOLD:
+        case LogEvent::NOISE_THRESHOLD:
+        case LogEvent::SOLID_WASTE_THRESHOLD:
+            return LogLevel::WARNING;
+        default:
+            return LogLevel::INFO;
+    }
+}
+
+constexpr LogCategory logEventCategory(LogEvent event) {
+    switch (event) {
+        case LogEvent::DAY_STARTED:
+        case LogEvent::DAY_COMPLETED:
+            return LogCategory::SIMULATION;
+        case LogEvent::BUILDING_ADDED:
+        case LogEvent::TRANSPORT_ADDED:
+        case LogEvent::CITIZEN_JOINED:
+        case LogEvent::HOUSING_ADDED:
+        case LogEvent::SERVICE_ADDED:
+            return LogCategory::ENTITIES;
+        case LogEvent::MONITORED_BUILDING:
+        case LogEvent::MONITORED_TRANSPORT:
+        case LogEvent::MONITORED_CITIZEN:
+        case LogEvent::MONITORED_COHORT:
+        case LogEvent::MONITORED_SERVICE:
+        case LogEvent::MONITORED_HOUSING:
+            return LogCategory::MONITORING;
+        case LogEvent::AIR_THRESHOLD:
+        case LogEvent::WATER_THRESHOLD:
+        case LogEvent::NOISE_THRESHOLD:
+        case LogEvent::SOLID_WASTE_THRESHOLD:
+            return LogCategory::POLLUTION;
+        default:
+            return LogCategory::GENERAL;
+    }
+}
+
+inline const LogEventInfo& logEventInfo(LogEvent event) {
+    static const LogEventInfo table[] = {
+        {"SESSION", "Log session opened"},
+        {"TEXT", "{}"},
+        {"DAY_STARTED", "Starting simulation for day {}"},
+        {"DAY_COMPLETED", "Day {} completed. Eco Score: {}"},
+        {"BUILDING_ADDED", "Added new building: {}"},
+        {"TRANSPORT_ADDED", "Added new transport: {}"},
+        {"CITIZEN_JOINED", "New citizen joined the city. Total population: {}"},
+        {"HOUSING_ADDED", "Added new housing scheme: {}"},
+        {"SERVICE_ADDED", "Added new service: {}"},
+        {"MONITORED_BUILDING", "Monitored building: {}, Impact: {}"},
+        {"MONITORED_TRANSPORT", "Monitored transport: {}, Emissions: {}"},
+        {"MONITORED_CITIZEN", "Monitored citizen with eco score: {}, Distance traveled: {}"},
+        {"MONITORED_COHORT", "Monitored cohort of {} citizens with eco score: {}, Distance traveled: {}"},
+        {"MONITORED_SERVICE", "Monitored service: {}, Reading: {}"},
+        {"MONITORED_HOUSING", "Monitored housing scheme: {}, Average pollution: {}"},
+        {"AIR_THRESHOLD", "WARNING: Air pollution level exceeded threshold: {}"},
+        {"WATER_THRESHOLD", "WARNING: Water pollution level exceeded threshold: {}"},
+        {"NOISE_THRESHOLD", "WARNING: Noise pollution level exceeded threshold: {}"},
+        {"SOLID_WASTE_THRESHOLD", "WARNING: Solid waste level exceeded threshold: {}"},
+    };
+    static const LogEventInfo unknown = {"UNKNOWN", "Unknown event"};
+    size_t index = static_cast<size_t>(event);
+    return index < sizeof(table) / sizeof(table[0]) ? table[index] : unknown;
+}
+
+// One typed argument of a decoded record
+struct LogArg {
+    char type;   // 'i' integer, 'd' real, 's' text, 't' text cut short to fit the record
+    int64_t integer;
+    double real;
+    string text;
+
+    string render() const {
+        if (type == 'i') return to_string(integer);
+        if (type == 'd') return to_string(real);
+        return text;
+    }
+};
+
+// Message text of an event, formatted exactly as the text logs write it
+inline string renderLogEvent(LogEvent event, const vector<LogArg>& args) {
+    const char* format = logEventInfo(event).format;
+    string text;
+    size_t next = 0;
+    for (const char* p = format; *p; p++) {
+        if (p[0] == '{' && p[1] == '}') {
+            if (next < args.size()) text += args[next++].render();
+            p++;
+        } else {
+            text += *p;
+        }
+    }
+    return text;
+}
+
+/**
+ * Binary log writer.
+ * A record is a steady-clock timestamp in nanoseconds, the event id and the
+ * raw arguments (8-byte integers and reals, length-prefixed text); nothing
+ * is formatted when logging. Records collect in a fixed buffer that is
+ * written to the file when full, so a log call is a clock read and a few
+ * copies. Each writer starts with a SESSION record tying the steady clock to
+ * the wall clock; logdecode renders the text offline.
+ *
+ * Record layout (little endian):
+ *   u64 timestamp, u16 event, u16 payload bytes, payload
+ *   payload = per argument: u8 type, then i64 / f64 / (u16 length, bytes)
+ * Text longer than MAX_PAYLOAD / 2 bytes keeps its first MAX_PAYLOAD / 2
+ * bytes and is written with type 't' instead of 's'.
+ */
+class BinaryLog {
+public:
+    static constexpr char MAGIC[8] = {'C', 'I', 'T', 'Y', 'L', 'O', 'G', '1'};
+    static constexpr size_t RECORD_HEADER = 12;
+    static constexpr size_t MAX_PAYLOAD = 65535;
+
+private:
+    ofstream file;
+    unique_ptr<char[]> buffer;
+    size_t capacity;
+    size_t used;
+    uint64_t records;
+
+    // Argument encoding, chosen at compile time from the argument's type
+    template<typename T>
+    static size_t encodedSize(const T&, typename enable_if<is_arithmetic<T>::value>::type* = nullptr) { return 9; }
+    static size_t encodedSize(const string& s) { return 3 + min(s.size(), size_t(MAX_PAYLOAD / 2)); }
+    static size_t encodedSize(const char* s) { return 3 + min(strlen(s), size_t(MAX_PAYLOAD / 2)); }
+
+    template<typename T>
+    static char* encode(char* out, const T& value, typename enable_if<is_integral<T>::value>::type* = nullptr) {
+        int64_t v = static_cast<int64_t>(value);
+        *out = 'i';
+        memcpy(out + 1, &v, 8);
+        return out + 9;
+    }
+    template<typename T>
+    static char* encode(char* out, const T& value, typename enable_if<is_floating_point<T>::value>::type* = nullptr) {
+        double v = static_cast<double>(value);
+        *out = 'd';
+        memcpy(out + 1, &v, 8);
+        return out + 9;
+    }
+    static char* encodeText(char* out, const char* s, size_t length) {
+        uint16_t n = static_cast<uint16_t>(min(length, size_t(MAX_PAYLOAD / 2)));
+        *out = (n < length) ? 't' : 's';
+        memcpy(out + 1, &n, 2);
+        memcpy(out + 3, s, n);
+        return out + 3 + n;
+    }
+    static char* encode(char* out, const string& s) { return encodeText(out, s.data(), s.size()); }
+    static char* encode(char* out, const char* s) { return encodeText(out, s, strlen(s)); }
+
+    static char* encodeAll(char* out) { return out; }
+    template<typename First, typename... Rest>
+    static char* encodeAll(char* out, const First& first, const Rest&... rest) {
+        return encodeAll(encode(out, first), rest...);
+    }
+
+    static size_t sizeAll() { return 0; }
+    template<typename First, typename... Rest>
+    static size_t sizeAll(const First& first, const Rest&... rest) { return encodedSize(first) + sizeAll(rest...); }
+
+    // To a LogArg, for formatting without a writer
+    template<typename T>
+    static LogArg toArg(const T& value, typename enable_if<is_integral<T>::value>::type* = nullptr) {
+        return {'i', static_cast<int64_t>(value), 0.0, string()};
+    }
+    template<typename T>
+    static LogArg toArg(const T& value, typename enable_if<is_floating_point<T>::value>::type* = nullptr) {
+        return {'d', 0, static_cast<double>(value), string()};
+    }
+    static LogArg toArg(const string& s) { return {'s', 0, 0.0, s}; }
+    static LogArg toArg(const char* s) { return {'s', 0, 0.0, string(s)}; }
+
+public:
+    static int64_t steadyNanoseconds() {
+        return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    explicit BinaryLog(const string& filename, size_t bufferBytes = 1 << 16)
+        : buffer(new char[max(bufferBytes, RECORD_HEADER + MAX_PAYLOAD)]),
+          capacity(max(bufferBytes, RECORD_HEADER + MAX_PAYLOAD)), used(0), records(0) {
+        file.open(filename, ios::binary | ios::app);
+        if (!file.is_open()) {
+            throw runtime_error("Could not open binary log file: " + filename);
+        }
+        if (file.tellp() == 0) file.write(MAGIC, sizeof(MAGIC));
+        int64_t wall = chrono::duration_cast<chrono::nanoseconds>(chrono::system_clock::now().time_since_epoch()).count();
+        write(LogEvent::SESSION, wall, steadyNanoseconds());
+    }
+
+    BinaryLog(const BinaryLog&) = delete;
+    BinaryLog& operator=(const BinaryLog&) = delete;
+
+    ~BinaryLog() { flush(); }
+
+    template<typename... Args>
+    void write(LogEvent event, const Args&... args) {
+        size_t payload = sizeAll(args...);
+        if (payload > MAX_PAYLOAD) {
+            throw invalid_argument("Log record arguments are too large");
+        }
+        if (used + RECORD_HEADER + payload > capacity) flush();
+
+        char* out = buffer.get() + used;
+        int64_t timestamp = steadyNanoseconds();
+        uint16_t id = static_cast<uint16_t>(event), bytes = static_cast<uint16_t>(payload);
+        memcpy(out, &timestamp, 8);
+        memcpy(out + 8, &id, 2);
+        memcpy(out + 10, &bytes, 2);
+        encodeAll(out + RECORD_HEADER, args...);
+        used += RECORD_HEADER + payload;
+        records++;
+    }
+
+    void flush() {
+        if (used == 0) return;
+        file.write(buffer.get(), used);
+        file.flush();
+        used = 0;
+    }
+
+    uint64_t getRecordCount() const { return records; }
+
+    // The text a record of this event would decode to
+    template<typename... Args>
+    static string format(LogEvent event, const Args&... args) {
+        return renderLogEvent(event, {toArg(args)...});
+    }
+};
+
+struct LogRecord {
+    int64_t wallNanoseconds;   // since the Unix epoch
+    LogEvent event;
+    vector<LogArg> args;
+
+    string text() const { return renderLogEvent(event, args); }
+
+    bool truncated() const {
+        for (const LogArg& arg : args) {
+            if (arg.type == 't') return true;
+        }
+        return false;
+    }
+};
+
+/**
+ * Reads a binary log back, record by record. SESSION records only move the
+ * clock anchor and are not returned. A record cut short at the end of the
+ * file (a writer that did not flush) ends the log.
+ */
+class BinaryLogReader {
+private:
+    vector<char> data;
+    size_t position;
+    int64_t wallAnchor;
+    int64_t steadyAnchor;
+
+public:
+    explicit BinaryLogReader(const string& filename) : position(sizeof(BinaryLog::MAGIC)), wallAnchor(0), steadyAnchor(0) {
+        ifstream in(filename, ios::binary);
+        if (!in.is_open()) {
+            throw runtime_error("Could not open binary log file: " + filename);
+        }
+        data.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+        if (data.size() < sizeof(BinaryLog::MAGIC) || memcmp(data.data(), BinaryLog::MAGIC, sizeof(BinaryLog::MAGIC)) != 0) {
+            throw runtime_error(filename + " is not a city binary log");
+        }
+    }
+
+    bool next(LogRecord& record) {
+        while (position + BinaryLog::RECORD_HEADER <= data.size()) {
+            const char* in = data.data() + position;
+            int64_t timestamp;
+            uint16_t id, bytes;
+            memcpy(&timestamp, in, 8);
+            memcpy(&id, in + 8, 2);
+            memcpy(&bytes, in + 10, 2);
+            if (position + BinaryLog::RECORD_HEADER + bytes > data.size()) break;
+            position += BinaryLog::RECORD_HEADER + bytes;
+
+            record.event = static_cast<LogEvent>(id);
+            record.args.clear();
+            const char* p = in + BinaryLog::RECORD_HEADER;
+            const char* end = p + bytes;
+            while (p < end) {
+                LogArg arg{*p, 0, 0.0, string()};
+                if ((arg.type == 'i' || arg.type == 'd') && p + 9 <= end) {
+                    memcpy(arg.type == 'i' ? static_cast<void*>(&arg.integer) : static_cast<void*>(&arg.real), p + 1, 8);
+                    p += 9;
+                } else if ((arg.type == 's' || arg.type == 't') && p + 3 <= end) {
+                    uint16_t n;
+                    memcpy(&n, p + 1, 2);
+                    if (p + 3 + n > end) {
+                        throw runtime_error("Corrupt binary log record");
+                    }
+                    arg.text.assign(p + 3, n);
+                    p += 3 + n;
+                } else {
+                    throw runtime_error("Corrupt binary log record");
+                }
+                record.args.push_back(move(arg));
+            }
+
+            if (record.event == LogEvent::SESSION && record.args.size() == 2) {
+                wallAnchor = record.args[0].integer;
+                steadyAnchor = record.args[1].integer;
+                continue;
+            }
+            record.wallNanoseconds = wallAnchor + (timestamp - steadyAnchor);
+            return true;
+        }
+        return false;
+    }
+};
+
+#endif // BINARYLOG_H
@@ -0,0 +1,120 @@
+#ifndef BLOCKCOMPRESSOR_H
+#define BLOCKCOMPRESSOR_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+
+/**
+ * Byte-oriented LZ77 block compression for log segments.
+ * A block is a run of sequences: a varint literal count, the literals, and
+ * (unless the block ends there) a varint match offset and a varint match
+ * length less the 4-byte minimum. Matches are found through a hash of the
+ * next four bytes, so compression is one pass and decompression is a copy
+ * loop; repetitive log text shrinks several times over. Decompression
+ * copies in 8-byte words and may write up to SLACK bytes past the output.
+ */
+class BlockCompressor {
+private:
+    static constexpr size_t MIN_MATCH = 4;
+    static constexpr size_t MAX_OFFSET = 65535;
+    static constexpr int HASH_BITS = 14;
+
+    static uint32_t load4(const char* p) {
+        uint32_t v;
+        memcpy(&v, p, 4);
+        return v;
+    }
+
+    static void putVarint(string& out, size_t v) {
+        while (v >= 0x80) {
+            out.push_back(static_cast<char>((v & 0x7F) | 0x80));
+            v >>= 7;
+        }
+        out.push_back(static_cast<char>(v));
+    }
+
+    static size_t getVarint(const char*& in, const char* end) {
+        size_t v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (in == end) break;
+            uint8_t byte = static_cast<uint8_t>(*in++);
+            v |= size_t(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return v;
+        }
+        throw runtime_error("Corrupt compressed block");
+    }
+
+    // Copies length bytes in 8-byte words; the source may overlap the output if it is 8 or more bytes behind
+    static void wordCopy(char* out, const char* from, size_t length) {
+        for (size_t k = 0; k < length; k += 8) memcpy(out + k, from + k, 8);
+    }
+
+public:
+    static constexpr size_t SLACK = 8;
+
+    static string compress(const char* data, size_t size) {
+        string out;
+        out.reserve(size / 2 + 16);
+        vector<int64_t> table(size_t(1) << HASH_BITS, -1);
+        size_t anchor = 0, i = 0;
+        while (i + MIN_MATCH <= size) {
+            uint32_t sequence = load4(data + i);
+            size_t slot = (sequence * 2654435761u) >> (32 - HASH_BITS);
+            int64_t candidate = table[slot];
+            table[slot] = static_cast<int64_t>(i);
+            if (candidate < 0 || i - candidate > MAX_OFFSET || load4(data + candidate) != sequence) {
+                i++;
+                continue;
+            }
+            size_t length = MIN_MATCH;
+            while (i + length < size && data[candidate + length] == data[i + length]) length++;
+
+            putVarint(out, i - anchor);
+            out.append(data + anchor, i - anchor);
+            putVarint(out, i - candidate);
+            putVarint(out, length - MIN_MATCH);
+            i += length;
+            anchor = i;
+        }
+        putVarint(out, size - anchor);
+        out.append(data + anchor, size - anchor);
+        return out;
+    }
+
+    // Decompresses size bytes to out, which must have room for size + SLACK bytes
+    static void decompress(const char* in, size_t inSize, char* out, size_t size) {
+        const char* end = in + inSize;
+        size_t written = 0;
+        while (true) {
+            size_t literals = getVarint(in, end);
+            if (literals > size - written || literals > size_t(end - in)) {
+                throw runtime_error("Corrupt compressed block");
+            }
+            if (size_t(end - in) >= literals + SLACK) wordCopy(out + written, in, literals);
+            else memcpy(out + written, in, literals);
+            in += literals;
+            written += literals;
+            if (written == size) return;
+
+            size_t offset = getVarint(in, end);
+            size_t length = getVarint(in, end) + MIN_MATCH;
+            if (offset == 0 || offset > written || length > size - written) {
+                throw runtime_error("Corrupt compressed block");
+            }
+            if (offset >= 8) {
+                wordCopy(out + written, out + written - offset, length);
+                written += length;
+            } else {
+                // Byte by byte, the match overlaps its own output
+                for (size_t k = 0; k < length; k++, written++) out[written] = out[written - offset];
+            }
+        }
+    }
+};
+
+#endif // BLOCKCOMPRESSOR_H
@@ -0,0 +1,55 @@
+#ifndef CITIZENCOHORT_H
+#define CITIZENCOHORT_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <tuple>
+#include <memory>
+
+#include "Citizens.h"
+
+using namespace std;
+
+/**
+ * A cohort is a weighted group of citizens with identical profile and state.
+ * Citizen::simulateDay() is deterministic, so identical citizens stay identical:
+ * only the representative is simulated and the other members share its state
+ * until they are synced back or split off into their own cohort.
+ */
+struct CitizenCohort {
+    size_t representative;   // index of the simulated member in the city's citizen list
+    vector<size_t> members;  // all member indices in ascending order, representative included
+
+    size_t getWeight() const { return members.size(); }
+};
+
+// Everything that decides how a citizen evolves during a day
+typedef tuple<int, double, string, double, const Building*, const Transport*, int, bool, double> CohortKey;
+
+inline CohortKey makeCohortKey(const Citizen& citizen) {
+    return make_tuple(citizen.getAge(), citizen.getEcoAwareness(), citizen.getOccupation(),
+                      citizen.getDailyTravelDistance(), citizen.getBuilding(), citizen.getTransport(),
+                      citizen.getEcoFriendlyDays(), citizen.getHasGreenBadge(),
+                      citizen.getTotalDistanceTraveled());
+}
+
+// Group citizens into cohorts of identical members (first member becomes representative)
+inline vector<CitizenCohort> buildCohorts(const vector<shared_ptr<Citizen>>& citizens) {
+    vector<CitizenCohort> cohorts;
+    map<CohortKey, size_t> lookup;
+
+    for (size_t i = 0; i < citizens.size(); i++) {
+        CohortKey key = makeCohortKey(*citizens[i]);
+        auto it = lookup.find(key);
+        if (it == lookup.end()) {
+            lookup[key] = cohorts.size();
+            cohorts.push_back(CitizenCohort{i, {i}});
+        } else {
+            cohorts[it->second].members.push_back(i);
+        }
+    }
+    return cohorts;
+}
+
+#endif // CITIZENCOHORT_H
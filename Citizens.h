@@ -7,6 +7,7 @@
 #include <stdexcept>
 #include "buildings.h"
 #include "transport.h"
+#include "Address.h"
 
 using namespace std;
 
@@ -22,11 +23,15 @@ private:
     double totalDistanceTraveled;
     Building* building;
     Transport* transport;
+    Address home;
+    Address work;
+    bool commutes;               // home and work are set and the daily distance comes from the route
 
 public:
     Citizen(string n, int a, double e, string job = "Unemployed", double distance = 10.0)
         : name(n), age(a), ecoAwareness(e), occupation(job), dailyTravelDistance(distance),
-         ecoFriendlyDays(0), hasGreenBadge(false), totalDistanceTraveled(0.0), building(nullptr), transport(nullptr) {
+         ecoFriendlyDays(0), hasGreenBadge(false), totalDistanceTraveled(0.0), building(nullptr), transport(nullptr),
+         commutes(false) {
         if (e < 0.0 || e > 1.0) {
             throw invalid_argument("Eco-awareness must be between 0.0 and 1.0");
         }
@@ -34,13 +39,32 @@ public:
 
     void assignBuilding(Building* b) { building = b; }
     void chooseTransport(Transport* t) { transport = t; }
+    
+    // Commute between two addresses; the city routes it over its streets each day
+    void setCommute(const Address& homeAddress, const Address& workAddress) {
+        home = homeAddress;
+        work = workAddress;
+        commutes = true;
+    }
+    
+    void clearCommute() { commutes = false; }
+    
+    // Set from the routed commute (both ways)
+    void setDailyTravelDistance(double km) {
+        if (km < 0) {
+            throw invalid_argument("Travel distance cannot be negative");
+        }
+        dailyTravelDistance = km;
+    }
 
-    void simulateDay() {
+    // consoleOutput = false keeps the vehicle from printing its emissions
+    void simulateDay(bool consoleOutput = true) {
         if (building) building->updateEcoScore();
         
         double emissions = 0;
         if (transport) {
-            transport->calculateCarbonEmissions();
+            if (consoleOutput) transport->calculateCarbonEmissions();
+            else transport->updateCarbonEmissions();
             emissions = transport->getCarbonEmissions() * dailyTravelDistance;
         }
         
@@ -60,6 +84,13 @@ public:
         if (ecoFriendlyDays >= 7 && !hasGreenBadge) hasGreenBadge = true;
     }
 
+    // An extra trip outside the daily routine; returns the eco-adjusted emissions of the trip
+    double takeTrip(double km) {
+        totalDistanceTraveled += km;
+        double emissions = transport ? transport->getCarbonEmissions() * km : 0.0;
+        return emissions * (1 - ecoAwareness);
+    }
+
     double calculateEcoScore() const {
         double buildingScore = building ? building->getEcoScoreImpact() : 0;
         double transportScore = transport ? transport->getCarbonEmissions() * dailyTravelDistance : 0;
@@ -98,10 +129,28 @@ public:
         cout << "Total distance traveled: " << totalDistanceTraveled << " km\n";
     }
 
+    // Copy the day-to-day simulation state from another citizen (used by cohorts)
+    void copyStateFrom(const Citizen& other) {
+        ecoAwareness = other.ecoAwareness;
+        ecoFriendlyDays = other.ecoFriendlyDays;
+        hasGreenBadge = other.hasGreenBadge;
+        totalDistanceTraveled = other.totalDistanceTraveled;
+    }
+
     // Getters
     double getTotalDistanceTraveled() const { return totalDistanceTraveled; }
     string getName() const { return name; }
     double getEcoAwareness() const { return ecoAwareness; }
+    int getAge() const { return age; }
+    const string& getOccupation() const { return occupation; }
+    double getDailyTravelDistance() const { return dailyTravelDistance; }
+    int getEcoFriendlyDays() const { return ecoFriendlyDays; }
+    bool getHasGreenBadge() const { return hasGreenBadge; }
+    Building* getBuilding() const { return building; }
+    Transport* getTransport() const { return transport; }
+    bool hasCommute() const { return commutes; }
+    const Address& getHome() const { return home; }
+    const Address& getWork() const { return work; }
 };
 
 #endif  // CITIZENS_H
\ No newline at end of file
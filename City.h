@@ -11,6 +11,9 @@
 #include <random>
 #include <algorithm>
 #include <numeric>
+#include <map>
+#include <mutex>
+#include <array>
 
 #include "buildings.h"
 #include "transport.h"
@@ -19,6 +22,28 @@
 #include "Services.h"
 #include "PollutionControl.h"
 #include "CityLogger.h"
+#include "BinaryLog.h"
+#include "LogLevel.h"
+#include "LogSink.h"
+#include "CitizenCohort.h"
+#include "EventScheduler.h"
+#include "HourlyProfiles.h"
+#include "EnergyBalance.h"
+#include "WaterManagement.h"
+#include "WaterNetwork.h"
+#include "GasManagement.h"
+#include "GasNetwork.h"
+#include "InternetManagement.h"
+#include "InternetContention.h"
+#include "StreetNetwork.h"
+#include "StreetNoise.h"
+#include "CommuteRouter.h"
+#include "TrafficAssignment.h"
+#include "ThreadPool.h"
+#include "CitySummary.h"
+#include "CityReport.h"
+#include "TimeSeries.h"
+#include "EntityHistory.h"
 
 using namespace std;
 
@@ -39,29 +64,1013 @@ private:
     double budget;
     double ecoScore;
     int day;
-    vector<unique_ptr<Building>> buildings;
-    vector<unique_ptr<Transport>> vehicles;
-    vector<unique_ptr<Citizen>> citizens;
-    vector<unique_ptr<HousingScheme>> housingSchemes;
-    vector<unique_ptr<Services>> services;
+    // Entities are shared with forked cities until one side modifies them (copy-on-write)
+    vector<shared_ptr<Building>> buildings;
+    vector<shared_ptr<Transport>> vehicles;
+    vector<shared_ptr<Citizen>> citizens;
+    vector<shared_ptr<HousingScheme>> housingSchemes;
+    vector<shared_ptr<Services>> services;
     unique_ptr<PollutionControl> pollutionControl;
     unique_ptr<CityLogger<string>> logger;
+    shared_ptr<BinaryLog> binaryLog;   // hot-path events, unformatted (opt-in; shared with pollution control, not with copies)
+    LogFilter logFilter;               // levels and categories written, shared with pollution control
+    
+    // Cohort mode (opt-in): identical citizens are simulated once per tick
+    bool cohortMode;
+    bool cohortMembersStale;        // members have not been synced since the last tick
+    vector<CitizenCohort> cohorts;
+    vector<size_t> cohortOf;        // citizen index -> cohort index
+    map<CohortKey, size_t> cohortLookup;
+    bool cohortLookupValid;
+    
+    // Timestamped sub-day events, fired at the start of each simulated day
+    EventScheduler scheduler;
+    
+    // Hourly resolution (opt-in): the day's activity is also spread over 24 hourly steps
+    bool hourlyResolution;
+    HourlyProfile travelProfile;
+    HourlyProfile commercialProfile;
+    HourlyProfile serviceProfile;
+    HourlyTotals hourlyTotals;
+    
+    // Per-entity daily activity gathered into contiguous arrays for the hourly kernels
+    struct HourlyInputs {
+        vector<double> travelKm;
+        vector<double> travelEmissions;
+        vector<double> travelWeight;     // cohort weight of each simulated citizen
+        vector<double> vehicleEmissions;
+        vector<double> commercialEnergy;
+        vector<double> serviceUsage;
+    } hourlyInputs;
+    
+    // Energy balance (opt-in); the engine is shared with clones and forks
+    shared_ptr<EnergyBalance> energyBalance;
+    EnergyReport energyReport;
+    
+    // Water mains model (opt-in); each city solves its own copy since solves keep warm-start state
+    unique_ptr<WaterNetwork> waterNetwork;
+    WaterNetworkReport waterReport;
+    vector<double> waterMeterBaseline;   // service index -> consumption after the previous tick
+    
+    // Gas distribution model (opt-in), copied like the water network
+    unique_ptr<GasNetwork> gasNetwork;
+    GasNetworkReport gasReport;
+    vector<double> gasMeterBaseline;
+    
+    // Internet backhaul contention (opt-in); the engine is shared like the energy balance
+    shared_ptr<InternetContention> internetContention;
+    ContentionReport contentionReport;
+    map<string, double> neighborhoodCapacity;   // neighborhoodKey -> backhaul Mbps
+    double defaultNeighborhoodCapacity;
+    vector<double> internetMeterBaseline;
+    
+    // Street network and traffic noise (opt-in); the network and the noise index never change
+    // once attached, so both are shared with clones and forks
+    struct VehicleRoute {
+        vector<size_t> segments;
+        double tripsPerDay;
+    };
+    shared_ptr<const StreetNetwork> streetNetwork;
+    shared_ptr<StreetNoise> streetNoise;
+    map<size_t, VehicleRoute> vehicleRoutes;   // vehicle index -> segments it drives
+    vector<double> segmentNoiseEnergy;         // weighted passages per segment on the last simulated day
+    StreetNoiseReport noiseReport;
+    
+    // Commute routing over the street network (opt-in); the router and its route cache are shared
+    shared_ptr<CommuteRouter> commuteRouter;
+    vector<shared_ptr<const CommuteRoute>> commuteRoutes;   // citizen index -> today's route (null if not routed)
+    
+    // Peak-hour traffic assignment (opt-in); the engine is shared until a city changes its settings
+    shared_ptr<TrafficAssignment> trafficAssignment;
+    TrafficReport trafficReport;
+    
+    // Aggregates read by the eco score and every report, recomputed on the first read after entities change
+    mutable CitySummary summary;
+    mutable bool summaryStale;
+    mutable mutex summaryLock;
+    shared_ptr<ThreadPool> summaryPool;   // parallel summary pass (opt-in), shared with clones and forks
+    
+    // Background report rendering (opt-in, not copied); reports are rendered from snapshots
+    unique_ptr<AsyncReportRenderer> reportRenderer;
+    
+    // Daily history appended to a columnar file (opt-in, not copied)
+    unique_ptr<TimeSeriesWriter> timeSeries;
+    
+    // Per-entity daily history (opt-in per field, not copied)
+    array<unique_ptr<EntityHistory>, static_cast<size_t>(HistoryField::COUNT)> histories;
+    
+    // Entities print their daily messages to cout; forks run side by side turn this off
+    bool consoleOutput;
     
     // Random number generator
     mt19937 rng;
+    
+    // Copy used by clone() and fork(); the copy only keeps its log in memory.
+    // A fork shares every entity with the original, a clone copies all of them.
+    City(const string& copyName, const City& other, bool shareEntities)
+        : name(copyName), mayor(other.mayor), budget(other.budget), ecoScore(other.ecoScore), day(other.day),
+          cohortMode(other.cohortMode), cohortMembersStale(other.cohortMembersStale), cohorts(other.cohorts),
+          cohortOf(other.cohortOf), cohortLookupValid(false), scheduler(other.scheduler),
+          hourlyResolution(other.hourlyResolution), travelProfile(other.travelProfile),
+          commercialProfile(other.commercialProfile), serviceProfile(other.serviceProfile),
+          hourlyTotals(other.hourlyTotals), energyBalance(other.energyBalance), energyReport(other.energyReport),
+          waterNetwork(other.waterNetwork ? make_unique<WaterNetwork>(*other.waterNetwork) : nullptr),
+          waterReport(other.waterReport), waterMeterBaseline(other.waterMeterBaseline),
+          gasNetwork(other.gasNetwork ? make_unique<GasNetwork>(*other.gasNetwork) : nullptr),
+          gasReport(other.gasReport), gasMeterBaseline(other.gasMeterBaseline),
+          internetContention(other.internetContention), contentionReport(other.contentionReport),
+          neighborhoodCapacity(other.neighborhoodCapacity), defaultNeighborhoodCapacity(other.defaultNeighborhoodCapacity),
+          internetMeterBaseline(other.internetMeterBaseline), streetNetwork(other.streetNetwork),
+          streetNoise(other.streetNoise), vehicleRoutes(other.vehicleRoutes),
+          segmentNoiseEnergy(other.segmentNoiseEnergy), noiseReport(other.noiseReport),
+          commuteRouter(other.commuteRouter), commuteRoutes(other.commuteRoutes),
+          trafficAssignment(other.trafficAssignment), trafficReport(other.trafficReport),
+          summary(), summaryStale(true), summaryPool(other.summaryPool), consoleOutput(other.consoleOutput), rng(other.rng) {
+        
+        if (shareEntities) {
+            buildings = other.buildings;
+            vehicles = other.vehicles;
+            citizens = other.citizens;
+            housingSchemes = other.housingSchemes;
+            services = other.services;
+        } else {
+            // Citizens point at buildings and vehicles, so remember where each one was copied to
+            map<const Building*, Building*> buildingCopies;
+            map<const Transport*, Transport*> vehicleCopies;
+            for (const auto& building : other.buildings) {
+                buildings.push_back(building->clone());
+                buildingCopies[building.get()] = buildings.back().get();
+            }
+            for (const auto& vehicle : other.vehicles) {
+                vehicles.push_back(vehicle->clone());
+                vehicleCopies[vehicle.get()] = vehicles.back().get();
+            }
+            for (const auto& citizen : other.citizens) {
+                citizens.push_back(make_shared<Citizen>(*citizen));
+            }
+            redirectCitizens(buildingCopies, vehicleCopies);
+            for (const auto& housing : other.housingSchemes) {
+                housingSchemes.push_back(housing->clone());
+            }
+            for (const auto& service : other.services) {
+                services.push_back(service->clone());
+            }
+        }
+        
+        logFilter = other.logFilter;
+        pollutionControl = make_unique<PollutionControl>(*other.pollutionControl);
+        logger = make_unique<CityLogger<string>>(copyName);
+        if (logging(LogLevel::INFO, LogCategory::GENERAL)) {
+            logger->log("City " + copyName + (shareEntities ? " forked" : " cloned") + " from " + other.name +
+                        " on day " + to_string(day));
+        }
+    }
+    
+    // Copy-on-write accessors: an entity still shared with another city is copied before it is modified
+    Citizen* mutableCitizen(size_t index) {
+        shared_ptr<Citizen>& slot = citizens[index];
+        if (slot.use_count() > 1) slot = make_shared<Citizen>(*slot);
+        return slot.get();
+    }
+    
+    Building* mutableBuilding(size_t index) {
+        shared_ptr<Building>& slot = buildings[index];
+        if (slot.use_count() > 1) {
+            const Building* original = slot.get();
+            slot = slot->clone();
+            redirectCitizens({{original, slot.get()}}, {});
+        }
+        return slot.get();
+    }
+    
+    Transport* mutableVehicle(size_t index) {
+        shared_ptr<Transport>& slot = vehicles[index];
+        if (slot.use_count() > 1) {
+            const Transport* original = slot.get();
+            slot = slot->clone();
+            redirectCitizens({}, {{original, slot.get()}});
+        }
+        return slot.get();
+    }
+    
+    HousingScheme* mutableHousingScheme(size_t index) {
+        shared_ptr<HousingScheme>& slot = housingSchemes[index];
+        if (slot.use_count() > 1) slot = slot->clone();
+        return slot.get();
+    }
+    
+    Services* mutableService(size_t index) {
+        shared_ptr<Services>& slot = services[index];
+        if (slot.use_count() > 1) slot = slot->clone();
+        return slot.get();
+    }
+    
+    // Point citizens at the copies of buildings and vehicles that were just made;
+    // a citizen still shared with another city is copied first
+    void redirectCitizens(const map<const Building*, Building*>& buildingCopies,
+                          const map<const Transport*, Transport*>& vehicleCopies) {
+        if (buildingCopies.empty() && vehicleCopies.empty()) return;
+        
+        for (size_t i = 0; i < citizens.size(); i++) {
+            auto b = buildingCopies.find(citizens[i]->getBuilding());
+            auto t = vehicleCopies.find(citizens[i]->getTransport());
+            if (b == buildingCopies.end() && t == vehicleCopies.end()) continue;
+            
+            Citizen* citizen = mutableCitizen(i);
+            if (b != buildingCopies.end()) citizen->assignBuilding(b->second);
+            if (t != vehicleCopies.end()) citizen->chooseTransport(t->second);
+        }
+    }
+    
+    // Call sites test these before building a message, so filtered messages cost no string work
+    bool logging(LogLevel level, LogCategory category) const {
+        return logFilter.enabled(level, category);
+    }
+    
+    bool logging(LogEvent event) const {
+        return logFilter.enabled(logEventLevel(event), logEventCategory(event));
+    }
+    
+    // Hot-path event: raw arguments to the binary log when it is enabled, otherwise formatted for the text log
+    template<typename... Args>
+    void logEvent(LogEvent event, const Args&... args) {
+        if (binaryLog) {
+            binaryLog->write(event, args...);
+        } else {
+            logger->log(BinaryLog::format(event, args...));
+        }
+    }
+    
+    // Before a day runs, copy the shared buildings and vehicles whose derived values
+    // (eco score impact, carbon emissions) are about to change
+    void detachChangingEntities() {
+        map<const Building*, Building*> buildingCopies;
+        map<const Transport*, Transport*> vehicleCopies;
+        for (auto& slot : buildings) {
+            if (slot.use_count() > 1 && slot->computeEcoScoreImpact() != slot->getEcoScoreImpact()) {
+                const Building* original = slot.get();
+                slot = slot->clone();
+                buildingCopies[original] = slot.get();
+            }
+        }
+        for (auto& slot : vehicles) {
+            if (slot.use_count() > 1 && slot->computeCarbonEmissions() != slot->getCarbonEmissions()) {
+                const Transport* original = slot.get();
+                slot = slot->clone();
+                vehicleCopies[original] = slot.get();
+            }
+        }
+        redirectCitizens(buildingCopies, vehicleCopies);
+    }
+    
+    // Copy the representative's state into every member of each cohort
+    void syncCohortMembers() {
+        if (!cohortMembersStale) return;
+        for (const auto& cohort : cohorts) {
+            const Citizen& rep = *citizens[cohort.representative];
+            for (size_t member : cohort.members) {
+                if (member != cohort.representative) {
+                    mutableCitizen(member)->copyStateFrom(rep);
+                }
+            }
+        }
+        cohortMembersStale = false;
+    }
+    
+    // Rebuild the key -> cohort lookup from the representatives' current state
+    void rebuildCohortLookup() {
+        cohortLookup.clear();
+        for (size_t c = 0; c < cohorts.size(); c++) {
+            cohortLookup.emplace(makeCohortKey(*citizens[cohorts[c].representative]), c);
+        }
+        cohortLookupValid = true;
+    }
+    
+    // Move a citizen out of its cohort into a cohort of its own
+    void splitFromCohort(size_t index) {
+        CitizenCohort& cohort = cohorts[cohortOf[index]];
+        if (cohort.getWeight() == 1) return;
+        
+        const Citizen& rep = *citizens[cohort.representative];
+        if (index != cohort.representative) {
+            mutableCitizen(index)->copyStateFrom(rep);
+        }
+        cohort.members.erase(find(cohort.members.begin(), cohort.members.end(), index));
+        if (index == cohort.representative) {
+            cohort.representative = cohort.members.front();
+            mutableCitizen(cohort.representative)->copyStateFrom(*citizens[index]);
+        }
+        
+        cohortOf[index] = cohorts.size();
+        cohorts.push_back(CitizenCohort{index, {index}});
+        cohortLookupValid = false;
+    }
+    
+    // Add citizens (ascending) to a cohort whose representative they now match
+    void joinCohort(size_t target, const vector<size_t>& joining) {
+        vector<size_t>& members = cohorts[target].members;
+        vector<size_t> merged;
+        merged.reserve(members.size() + joining.size());
+        merge(members.begin(), members.end(), joining.begin(), joining.end(), back_inserter(merged));
+        members.swap(merged);
+        for (size_t index : joining) cohortOf[index] = target;
+        cohortMembersStale = true;
+    }
+    
+    // Give some members of a cohort (ascending) a new daily distance and move them to the cohort
+    // of their new key, which may be an existing one; a cohort that moves whole is left empty
+    void rekeyCohortMembers(size_t c, const vector<size_t>& moving, double km) {
+        if (!cohortLookupValid) rebuildCohortLookup();
+        size_t rep = cohorts[c].representative;
+        
+        if (moving.size() == cohorts[c].members.size()) {
+            auto old = cohortLookup.find(makeCohortKey(*citizens[rep]));
+            if (old != cohortLookup.end() && old->second == c) cohortLookup.erase(old);
+            for (size_t index : moving) mutableCitizen(index)->setDailyTravelDistance(km);
+            auto inserted = cohortLookup.emplace(makeCohortKey(*citizens[rep]), c);
+            if (!inserted.second && inserted.first->second != c) {
+                joinCohort(inserted.first->second, moving);
+                cohorts[c].members.clear();
+            }
+            return;
+        }
+        
+        // The moving members leave with the cohort's current state
+        size_t lead = moving.front();
+        if (lead != rep) mutableCitizen(lead)->copyStateFrom(*citizens[rep]);
+        vector<size_t> staying;
+        set_difference(cohorts[c].members.begin(), cohorts[c].members.end(), moving.begin(), moving.end(),
+                       back_inserter(staying));
+        if (binary_search(moving.begin(), moving.end(), rep)) {
+            cohorts[c].representative = staying.front();
+            mutableCitizen(staying.front())->copyStateFrom(*citizens[rep]);
+        }
+        cohorts[c].members.swap(staying);
+        
+        for (size_t index : moving) mutableCitizen(index)->setDailyTravelDistance(km);
+        auto inserted = cohortLookup.emplace(makeCohortKey(*citizens[lead]), cohorts.size());
+        if (inserted.second) {
+            for (size_t index : moving) cohortOf[index] = cohorts.size();
+            cohorts.push_back(CitizenCohort{lead, moving});
+            cohortMembersStale = true;
+        } else {
+            joinCohort(inserted.first->second, moving);
+        }
+    }
+    
+    // Drop cohorts left empty by rekeyCohortMembers and renumber the rest
+    void removeEmptyCohorts() {
+        vector<size_t> renumbered(cohorts.size());
+        size_t kept = 0;
+        for (size_t c = 0; c < cohorts.size(); c++) {
+            renumbered[c] = kept;
+            if (!cohorts[c].members.empty()) {
+                if (kept != c) cohorts[kept] = move(cohorts[c]);
+                kept++;
+            }
+        }
+        if (kept == cohorts.size()) return;
+        cohorts.resize(kept);
+        for (size_t& c : cohortOf) c = renumbered[c];
+        cohortLookupValid = false;
+    }
+    
+    // Apply one event to the entity it targets; idle entities are never visited
+    void fireEvent(const CityEvent& event) {
+        budget -= event.cost;
+        
+        switch (event.type) {
+            case CityEventType::COMMUTE: {
+                if (cohortMode) splitFromCohort(event.target);
+                double emissions = mutableCitizen(event.target)->takeTrip(event.amount);
+                pollutionControl->addDeposit(PollutionControl::emissionsDeposit(emissions));
+                break;
+            }
+            case CityEventType::SERVICE_OUTAGE: {
+                Services* service = mutableService(event.target);
+                service->setActive(false);
+                scheduler.schedule({event.time + static_cast<long long>(event.amount), CityEventType::SERVICE_RESTORE,
+                                    event.target, event.amount, 0.0});
+                if (logging(LogLevel::WARNING, LogCategory::SIMULATION)) {
+                    logger->log("Service outage: " + service->getServiceType() + " down for " +
+                                to_string(static_cast<int>(event.amount)) + " minutes");
+                }
+                break;
+            }
+            case CityEventType::SERVICE_RESTORE: {
+                // Reliability drops by the share of a day the service was down
+                Services* service = mutableService(event.target);
+                service->setActive(true);
+                double lost = 100.0 * event.amount / CityEvent::MINUTES_PER_DAY;
+                service->setReliabilityScore(max(0.0, service->getReliabilityScore() - lost));
+                if (logging(LogLevel::INFO, LogCategory::SIMULATION)) {
+                    logger->log("Service restored: " + service->getServiceType());
+                }
+                break;
+            }
+            case CityEventType::POLLUTION_SPIKE: {
+                PollutionDeposit spike = {0.0, 0.0, 0.0, 0.0};
+                switch (static_cast<PollutionKind>(event.target)) {
+                    case PollutionKind::AIR: spike.air = event.amount; break;
+                    case PollutionKind::WATER: spike.water = event.amount; break;
+                    case PollutionKind::NOISE: spike.noise = event.amount; break;
+                    case PollutionKind::SOLID_WASTE: spike.solidWaste = event.amount; break;
+                }
+                pollutionControl->addDeposit(spike);
+                if (logging(LogLevel::WARNING, LogCategory::POLLUTION)) {
+                    logger->log("Pollution spike of " + to_string(event.amount) + " units");
+                }
+                break;
+            }
+        }
+    }
+    
+    // Eco score of a citizen, read through its cohort representative when cohorts are on
+    double citizenEcoScore(size_t index) const {
+        if (cohortMode) {
+            return citizens[cohorts[cohortOf[index]].representative]->calculateEcoScore();
+        }
+        return citizens[index]->calculateEcoScore();
+    }
+
+    // Summary pass: entities are reduced in fixed blocks, so totals do not depend on the thread count
+    static constexpr size_t SUMMARY_BLOCK = 4096;
+
+    struct CitizenPartial {
+        double impact = 0.0;
+        double score = 0.0;
+        vector<pair<size_t, double>> top;   // citizen index and eco score, best first
+    };
+
+    struct BuildingPartial {
+        double impact = 0.0;
+        array<size_t, static_cast<size_t>(BuildingKind::COUNT)> kinds{};
+    };
+
+    struct VehiclePartial {
+        double impact = 0.0;
+        double emissions = 0.0;
+        vector<pair<const string*, size_t>> types;   // a city has a handful of vehicle types
+    };
+
+    // Keep the best TOP_CITIZENS by score, then by lower citizen index, whatever order they are offered in
+    static void offerTopCitizen(vector<pair<size_t, double>>& top, size_t index, double score) {
+        auto ahead = [index, score](const pair<size_t, double>& entry) {
+            return entry.second > score || (entry.second == score && entry.first < index);
+        };
+        if (top.size() == CitySummary::TOP_CITIZENS && ahead(top.back())) return;
+        auto at = top.begin();
+        while (at != top.end() && ahead(*at)) ++at;
+        top.insert(at, make_pair(index, score));
+        if (top.size() > CitySummary::TOP_CITIZENS) top.pop_back();
+    }
+
+    static void countVehicleType(vector<pair<const string*, size_t>>& types, const string& type, size_t count) {
+        for (auto& entry : types) {
+            if (*entry.first == type) {
+                entry.second += count;
+                return;
+            }
+        }
+        types.push_back(make_pair(&type, count));
+    }
+
+    // Run body(partial, i) over [0, count), one partial per block
+    template <typename Partial, typename Body>
+    vector<Partial> summaryBlocks(size_t count, const Body& body) const {
+        size_t blocks = (count + SUMMARY_BLOCK - 1) / SUMMARY_BLOCK;
+        vector<Partial> partials(blocks);
+        auto run = [&](size_t first, size_t last) {
+            for (size_t b = first; b < last; b++) {
+                size_t end = min(count, (b + 1) * SUMMARY_BLOCK);
+                for (size_t i = b * SUMMARY_BLOCK; i < end; i++) body(partials[b], i);
+            }
+        };
+        if (summaryPool && blocks > 1) summaryPool->parallelFor(0, blocks, run);
+        else run(0, blocks);
+        return partials;
+    }
 
+    // One pass over every entity list for everything the eco score and the reports need
+    CitySummary computeSummary() const {
+        CitySummary s{};
+        s.day = day;
+        s.population = citizens.size();
+        s.buildingCount = buildings.size();
+        s.vehicleCount = vehicles.size();
+        s.housingCount = housingSchemes.size();
+        s.serviceCount = services.size();
+
+        // Citizens; in cohort mode each cohort is scored once through its representative
+        size_t citizenUnits = cohortMode ? cohorts.size() : citizens.size();
+        vector<CitizenPartial> citizenParts = summaryBlocks<CitizenPartial>(citizenUnits,
+            [this](CitizenPartial& part, size_t i) {
+                if (cohortMode) {
+                    const CitizenCohort& cohort = cohorts[i];
+                    double score = citizens[cohort.representative]->calculateEcoScore();
+                    double weight = cohort.getWeight();
+                    part.impact += citizenEcoImpact(score) * weight;
+                    part.score += score * weight;
+                    // Members share the score, so only the lowest-indexed few can make the list
+                    size_t offered = min(cohort.members.size(), CitySummary::TOP_CITIZENS);
+                    for (size_t k = 0; k < offered; k++) offerTopCitizen(part.top, cohort.members[k], score);
+                } else {
+                    double score = citizens[i]->calculateEcoScore();
+                    part.impact += citizenEcoImpact(score);
+                    part.score += score;
+                    offerTopCitizen(part.top, i, score);
+                }
+            });
+        vector<pair<size_t, double>> top;
+        for (const CitizenPartial& part : citizenParts) {
+            s.citizenImpact += part.impact;
+            s.averageCitizenEcoScore += part.score;
+            for (const auto& entry : part.top) offerTopCitizen(top, entry.first, entry.second);
+        }
+        for (const auto& entry : top) {
+            s.topCitizens.push_back(make_pair(citizens[entry.first]->getName(), entry.second));
+        }
+
+        // Buildings
+        vector<BuildingPartial> buildingParts = summaryBlocks<BuildingPartial>(buildings.size(),
+            [this](BuildingPartial& part, size_t i) {
+                part.impact += buildings[i]->getEcoScoreImpact();
+                part.kinds[static_cast<size_t>(buildings[i]->getKind())]++;
+            });
+        for (const BuildingPartial& part : buildingParts) {
+            s.buildingImpact += part.impact;
+            for (size_t k = 0; k < part.kinds.size(); k++) s.buildingsByKind[k] += part.kinds[k];
+        }
+
+        // Vehicles
+        vector<VehiclePartial> vehicleParts = summaryBlocks<VehiclePartial>(vehicles.size(),
+            [this](VehiclePartial& part, size_t i) {
+                part.impact += transportEcoImpact(*vehicles[i]);
+                part.emissions += vehicles[i]->getCarbonEmissions();
+                countVehicleType(part.types, vehicles[i]->getType(), 1);
+            });
+        vector<pair<const string*, size_t>> types;
+        for (const VehiclePartial& part : vehicleParts) {
+            s.transportImpact += part.impact;
+            s.totalEmissions += part.emissions;
+            for (const auto& entry : part.types) countVehicleType(types, *entry.first, entry.second);
+        }
+        for (const auto& entry : types) s.vehiclesByType.push_back(make_pair(*entry.first, entry.second));
+        sort(s.vehiclesByType.begin(), s.vehiclesByType.end());
+
+        // Housing schemes and services are few, one sequential pass each
+        for (const auto& housing : housingSchemes) {
+            s.housingImpact += housingEcoImpact(*housing);
+            switch (housing->getKind()) {
+                case HousingKind::APARTMENT: s.apartments++; break;
+                case HousingKind::VILLA: s.villas++; break;
+                default: break;
+            }
+            s.averageSustainability += housing->getSustainabilityRating();
+            s.totalUnits += housing->getTotalUnits();
+            s.occupiedUnits += housing->getOccupiedUnits();
+        }
+
+        for (const auto& service : services) {
+            string type = service->getServiceType();
+            s.servicesImpact += serviceEcoImpact(*service);
+            s.serviceOperatingCost += serviceOperatingCost(type);
+            s.serviceReliability.push_back(make_pair(move(type), service->getReliabilityScore()));
+        }
+
+        // Normalize each impact per entity
+        if (!citizens.empty()) {
+            s.citizenImpact /= citizens.size();
+            s.averageCitizenEcoScore /= citizens.size();
+        }
+        if (!buildings.empty()) s.buildingImpact /= buildings.size();
+        if (!vehicles.empty()) s.transportImpact /= vehicles.size();
+        if (!housingSchemes.empty()) {
+            s.housingImpact /= housingSchemes.size();
+            s.averageSustainability /= housingSchemes.size();
+        }
+        if (!services.empty()) s.servicesImpact /= services.size();
+
+        return s;
+    }
+
+    // Append today's value of every tracked field; cohort members read their representative
+    void recordEntityHistory() {
+        for (size_t f = 0; f < histories.size(); f++) {
+            if (!histories[f]) continue;
+            switch (static_cast<HistoryField>(f)) {
+                case HistoryField::CITIZEN_ECO_SCORE:
+                    histories[f]->record(day, citizens.size(), [this](size_t i) { return citizenEcoScore(i); });
+                    break;
+                case HistoryField::CITIZEN_ECO_AWARENESS:
+                    histories[f]->record(day, citizens.size(), [this](size_t i) {
+                        size_t source = cohortMode ? cohorts[cohortOf[i]].representative : i;
+                        return citizens[source]->getEcoAwareness();
+                    });
+                    break;
+                case HistoryField::BUILDING_ECO_IMPACT:
+                    histories[f]->record(day, buildings.size(), [this](size_t i) { return buildings[i]->getEcoScoreImpact(); });
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+    
+    // Render now to cout, or hand a snapshot to the background renderer
+    void renderReport(ReportKind kind) const {
+        if (reportRenderer) {
+            reportRenderer->submit(make_shared<const CityReport>(takeReportSnapshot()), kind);
+        } else {
+            ReportWriter::write(cout, takeReportSnapshot(), kind);
+            cout.flush();
+        }
+    }
+
+    // Gather today's per-entity activity into flat arrays and run the hourly kernels
+    void computeHourlyTotals() {
+        HourlyInputs& in = hourlyInputs;
+        in.travelKm.clear();
+        in.travelEmissions.clear();
+        in.travelWeight.clear();
+        in.vehicleEmissions.clear();
+        in.commercialEnergy.clear();
+        in.serviceUsage.clear();
+        
+        auto addTraveller = [&in](const Citizen& citizen, double weight) {
+            const Transport* transport = citizen.getTransport();
+            double km = citizen.getDailyTravelDistance();
+            double emissions = transport ? transport->getCarbonEmissions() * km : 0.0;
+            in.travelKm.push_back(km);
+            in.travelEmissions.push_back(emissions * (1 - citizen.getEcoAwareness()));
+            in.travelWeight.push_back(weight);
+        };
+        if (cohortMode) {
+            for (const auto& cohort : cohorts) {
+                addTraveller(*citizens[cohort.representative], static_cast<double>(cohort.getWeight()));
+            }
+        } else {
+            for (const auto& citizen : citizens) {
+                addTraveller(*citizen, 1.0);
+            }
+        }
+        
+        for (const auto& vehicle : vehicles) {
+            in.vehicleEmissions.push_back(vehicle->getCarbonEmissions());
+        }
+        for (const auto& building : buildings) {
+            if (auto* commercial = dynamic_cast<const CommercialBuilding*>(building.get())) {
+                in.commercialEnergy.push_back(commercial->getEnergyUsage());
+            }
+        }
+        for (const auto& service : services) {
+            in.serviceUsage.push_back(service->getAverageReading());
+        }
+        
+        size_t travellers = in.travelKm.size();
+        hourlyTotals.day = day;
+        HourlyKernels::spread(HourlyKernels::weightedSum(in.travelKm.data(), in.travelWeight.data(), travellers),
+                              travelProfile, hourlyTotals.travelKm);
+        HourlyKernels::spread(HourlyKernels::weightedSum(in.travelEmissions.data(), in.travelWeight.data(), travellers),
+                              travelProfile, hourlyTotals.travelEmissions);
+        HourlyKernels::spread(HourlyKernels::sum(in.vehicleEmissions.data(), in.vehicleEmissions.size()),
+                              travelProfile, hourlyTotals.vehicleEmissions);
+        HourlyKernels::spread(HourlyKernels::sum(in.commercialEnergy.data(), in.commercialEnergy.size()),
+                              commercialProfile, hourlyTotals.commercialEnergyKWh);
+        HourlyKernels::spread(HourlyKernels::sum(in.serviceUsage.data(), in.serviceUsage.size()),
+                              serviceProfile, hourlyTotals.serviceUsage);
+    }
+    
+    // Compute today's energy balance and post each district's grid import to its electricity accounts
+    void balanceEnergy() {
+        energyReport = energyBalance->compute(day, buildings, housingSchemes, services,
+                                              hourlyResolution ? &commercialProfile : nullptr);
+        
+        for (auto& district : energyReport.districts) {
+            if (district.gridImportKWh <= 0) continue;
+            if (district.accounts.empty()) {
+                district.unmeteredKWh = district.gridImportKWh;
+                district.importCarbonKg = district.gridImportKWh * ElectricityManagement::STANDARD_EMISSION_FACTOR;
+                continue;
+            }
+            // Split evenly across the district's accounts; carbon is the growth of their footprints
+            double share = district.gridImportKWh / district.accounts.size();
+            for (size_t index : district.accounts) {
+                auto* account = static_cast<ElectricityManagement*>(mutableService(index));
+                double before = account->calculateCarbonFootprint();
+                account->addUsage(share);
+                district.importCarbonKg += account->calculateCarbonFootprint() - before;
+            }
+        }
+        
+        if (logging(LogLevel::VERBOSE, LogCategory::NETWORKS)) {
+            logger->log("Energy balance: " + to_string(energyReport.totalImport()) + " kWh imported, " +
+                        to_string(energyReport.totalExport()) + " kWh exported, " +
+                        to_string(energyReport.totalImportCarbon()) + " kg CO2");
+        }
+    }
+    
+    // Aggregate metered water demand and harvesting per zone, solve the mains,
+    // credit harvested water on the bills and report the supply to pollution control
+    void runWaterNetwork() {
+        unordered_map<string, double> zoneDemand, zoneHarvest;
+        vector<pair<size_t, double>> accountDemand;   // (service index, demand since last tick)
+        waterMeterBaseline.resize(services.size(), 0.0);
+        
+        for (size_t i = 0; i < services.size(); i++) {
+            auto* account = dynamic_cast<const WaterManagement*>(services[i].get());
+            if (!account || account->getCurrentPlanType() == WaterTariffPlan::NO_SUPPLY) continue;
+            // A plan change restarts the meter at zero
+            double reading = account->getConsumptionCubicMeters();
+            double demand = (reading >= waterMeterBaseline[i]) ? reading - waterMeterBaseline[i] : reading;
+            zoneDemand[account->getAddress().pin] += demand;
+            accountDemand.emplace_back(i, demand);
+        }
+        for (const auto& building : buildings) {
+            auto* green = dynamic_cast<const GreenBuilding*>(building.get());
+            if (green && green->hasRainwaterHarvesting()) {
+                zoneHarvest[building->getAddress().pin] += green->getGreenSpaceArea() * WaterNetwork::HARVEST_M3_PER_SQM;
+            }
+        }
+        
+        waterReport = waterNetwork->simulate(day, zoneDemand, zoneHarvest);
+        
+        // Harvested water is not billed: credit it to the zone's accounts in proportion to their demand
+        unordered_map<string, double> harvestShare;
+        for (const auto& zone : waterReport.zones) {
+            if (zone.demandM3 > 0) harvestShare[zone.zone] = zone.harvestedM3 / zone.demandM3;
+        }
+        for (const auto& entry : accountDemand) {
+            size_t index = entry.first;
+            const string& pin = static_cast<const WaterManagement&>(*services[index]).getAddress().pin;
+            auto share = harvestShare.find(pin);
+            if (share != harvestShare.end() && share->second > 0 && entry.second > 0) {
+                static_cast<WaterManagement*>(mutableService(index))->creditConsumption(entry.second * share->second);
+            }
+            waterMeterBaseline[index] = static_cast<const WaterManagement&>(*services[index]).getConsumptionCubicMeters();
+        }
+        
+        pollutionControl->monitorWaterNetwork(waterReport.totalSupplied, waterReport.lowPressureZones);
+        if (logging(LogLevel::VERBOSE, LogCategory::NETWORKS)) {
+            logger->log("Water network: " + to_string(waterReport.totalSupplied) + " m^3 supplied, " +
+                        to_string(waterReport.totalHarvested) + " m^3 harvested, " +
+                        to_string(waterReport.lowPressureZones) + " low-pressure zones");
+        }
+    }
+    
+    // Solve network pressures for the gas drawn since the last tick and flag low-pressure accounts
+    void runGasNetwork() {
+        unordered_map<string, double> addressDemand;
+        gasMeterBaseline.resize(services.size(), 0.0);
+        for (size_t i = 0; i < services.size(); i++) {
+            auto* account = dynamic_cast<const GasManagement*>(services[i].get());
+            if (!account) continue;
+            double reading = account->getTotalConsumption();
+            double demand = (reading >= gasMeterBaseline[i]) ? reading - gasMeterBaseline[i] : reading;
+            addressDemand[GasNetwork::nodeKey(account->getAddress())] += demand;
+            gasMeterBaseline[i] = reading;
+        }
+        
+        gasReport = gasNetwork->simulate(day, addressDemand);
+        
+        // Accounts only get copied (for forks) when their pressure actually changed
+        for (size_t i = 0; i < services.size(); i++) {
+            auto* account = dynamic_cast<const GasManagement*>(services[i].get());
+            if (!account) continue;
+            double pressure = gasNetwork->getPressure(account->getAddress());
+            bool low = pressure < gasNetwork->getMinimumPressure();
+            if (pressure != account->getSupplyPressure() || low != account->isLowPressure()) {
+                static_cast<GasManagement*>(mutableService(i))->setSupplyPressure(pressure, low);
+            }
+        }
+        
+        if (logging(LogLevel::VERBOSE, LogCategory::NETWORKS)) {
+            logger->log("Gas network solved in " + to_string(gasReport.solver.iterations) + " iterations, " +
+                        to_string(gasReport.lowPressureNodes.size()) + " addresses below minimum pressure");
+        }
+    }
+    
+    // Share each neighborhood's backhaul among its subscribers' busy-hour demand and
+    // let the resulting speed pull their reliability scores up or down
+    void runInternetContention() {
+        vector<size_t> accounts;                 // service indices of active subscribers
+        vector<double> demand;
+        vector<vector<size_t>> subscribersOf;
+        unordered_map<string, size_t> neighborhoodIndex;
+        internetMeterBaseline.resize(services.size(), 0.0);
+        
+        for (size_t i = 0; i < services.size(); i++) {
+            auto* account = dynamic_cast<const InternetManagement*>(services[i].get());
+            if (!account) continue;
+            double reading = account->getDataUsedGB();
+            double used = (reading >= internetMeterBaseline[i]) ? reading - internetMeterBaseline[i] : reading;
+            internetMeterBaseline[i] = reading;
+            if (!account->getIsActive() || account->getCurrentPlan() == InternetPlan::NO_SERVICE) continue;
+            
+            string key = InternetContention::neighborhoodKey(account->getAddress());
+            auto found = neighborhoodIndex.emplace(key, subscribersOf.size());
+            if (found.second) subscribersOf.emplace_back();
+            subscribersOf[found.first->second].push_back(demand.size());
+            accounts.push_back(i);
+            demand.push_back(InternetContention::busyHourDemandMbps(used, account->getCurrentSpeed()));
+        }
+        
+        vector<NeighborhoodLoad> loads(subscribersOf.size());
+        for (const auto& entry : neighborhoodIndex) {
+            auto capacity = neighborhoodCapacity.find(entry.first);
+            loads[entry.second].neighborhood = entry.first;
+            loads[entry.second].capacityMbps = (capacity != neighborhoodCapacity.end()) ? capacity->second : defaultNeighborhoodCapacity;
+        }
+        internetContention->allocate(subscribersOf, demand, loads);
+        
+        // A subscriber can get at most the neighborhood's fair share in the busy hour
+        for (size_t n = 0; n < subscribersOf.size(); n++) {
+            for (size_t k : subscribersOf[n]) {
+                size_t index = accounts[k];
+                auto* account = static_cast<const InternetManagement*>(services[index].get());
+                double planSpeed = account->getCurrentSpeed();
+                double effective = min(planSpeed, loads[n].fairShareMbps);
+                // Congestion scales the account's own reliability, which outages may already have lowered
+                double reliability = account->reliabilityAt(effective);
+                if (effective != account->getEffectiveSpeed() || reliability != account->getReliabilityScore()) {
+                    static_cast<InternetManagement*>(mutableService(index))->applyContention(effective);
+                }
+            }
+        }
+        
+        sort(loads.begin(), loads.end(), [](const NeighborhoodLoad& a, const NeighborhoodLoad& b) {
+            return a.neighborhood < b.neighborhood;
+        });
+        contentionReport.day = day;
+        contentionReport.neighborhoods = move(loads);
+        if (logging(LogLevel::VERBOSE, LogCategory::NETWORKS)) {
+            logger->log("Internet contention: " + to_string(contentionReport.getCongestedCount()) + " of " +
+                        to_string(contentionReport.neighborhoods.size()) + " neighborhoods congested");
+        }
+    }
+    
+    // Route every commuting citizen between home and work and take the daily distance from
+    // the route; rail and air commuters keep their own distance
+    void routeCommutes() {
+        vector<pair<Address, Address>> trips;
+        vector<size_t> commuters;
+        for (size_t i = 0; i < citizens.size(); i++) {
+            const Citizen& citizen = *citizens[i];
+            if (!citizen.hasCommute()) continue;
+            if (citizen.getTransport() && !CommuteRouter::usesStreets(citizen.getTransport()->getType())) continue;
+            trips.emplace_back(citizen.getHome(), citizen.getWork());
+            commuters.push_back(i);
+        }
+        
+        vector<shared_ptr<const CommuteRoute>> routes = commuteRouter->route(trips);
+        commuteRoutes.assign(citizens.size(), nullptr);
+        size_t unroutable = 0;
+        map<pair<size_t, double>, vector<size_t>> moves;   // (cohort, new distance) -> members, ascending
+        for (size_t k = 0; k < commuters.size(); k++) {
+            size_t index = commuters[k];
+            commuteRoutes[index] = routes[k];
+            if (!routes[k]->found) {
+                unroutable++;
+                continue;
+            }
+            double km = 2.0 * routes[k]->km;
+            if (citizens[index]->getDailyTravelDistance() != km) {
+                if (cohortMode) moves[make_pair(cohortOf[index], km)].push_back(index);
+                else mutableCitizen(index)->setDailyTravelDistance(km);
+            }
+        }
+        
+        // A changed distance changes how citizens evolve, so members sharing a new distance move
+        // together into the cohort that matches them
+        if (!moves.empty()) {
+            for (const auto& group : moves) rekeyCohortMembers(group.first.first, group.second, group.first.second);
+            removeEmptyCohorts();
+        }
+        
+        if (logging(LogLevel::VERBOSE, LogCategory::NETWORKS)) {
+            logger->log("Routed " + to_string(commuters.size()) + " commutes (" + to_string(unroutable) +
+                        " not on the street network), " + to_string(commuteRouter->getCacheSize()) + " routes cached");
+        }
+    }
+    
+    // Assign the peak hour of today's commutes to the streets and scale each commuting vehicle's
+    // emissions with the delay its riders meet
+    void runTraffic() {
+        const double* share = travelProfile.share;
+        double peakShare = *max_element(share, share + HOURS_PER_DAY);
+        unordered_map<const Transport*, size_t> vehicleIndex;
+        for (size_t v = 0; v < vehicles.size(); v++) vehicleIndex.emplace(vehicles[v].get(), v);
+        
+        vector<TrafficDemand> demand;
+        vector<size_t> riders;
+        for (size_t i = 0; i < citizens.size(); i++) {
+            const Citizen& citizen = *citizens[i];
+            if (!citizen.hasCommute() || !citizen.getTransport()) continue;
+            double perTrip = TrafficAssignment::commuterVehicles(citizen.getTransport()->getType());
+            uint32_t from = trafficAssignment->nodeOf(citizen.getHome());
+            uint32_t to = trafficAssignment->nodeOf(citizen.getWork());
+            if (perTrip == 0.0 || from == numeric_limits<uint32_t>::max() || to == numeric_limits<uint32_t>::max()) continue;
+            // Two trips a day, peakShare of all travel falls in the busiest hour
+            demand.push_back({from, to, 2.0 * peakShare * perTrip});
+            riders.push_back(i);
+        }
+        
+        vector<double> delay;
+        trafficReport = trafficAssignment->assign(demand, day, &delay);
+        
+        // Each vehicle's factor is the vehicle-weighted mean over its commuting riders
+        vector<double> weightedFactor(vehicles.size(), 0.0), weight(vehicles.size(), 0.0);
+        for (size_t k = 0; k < riders.size(); k++) {
+            auto v = vehicleIndex.find(citizens[riders[k]]->getTransport());
+            if (v == vehicleIndex.end()) continue;
+            weightedFactor[v->second] += demand[k].vehicles * TrafficAssignment::emissionFactor(delay[k]);
+            weight[v->second] += demand[k].vehicles;
+        }
+        for (size_t v = 0; v < vehicles.size(); v++) {
+            double factor = weight[v] > 0 ? weightedFactor[v] / weight[v] : 1.0;
+            if (vehicles[v]->getCongestionFactor() != factor) mutableVehicle(v)->setCongestionFactor(factor);
+        }
+        
+        if (logging(LogLevel::VERBOSE, LogCategory::NETWORKS)) {
+            logger->log("Traffic: " + to_string(trafficReport.peakVehicles) + " vehicles in the peak hour, " +
+                        to_string(trafficReport.congestedSegments) + " segments over capacity, trips at " +
+                        to_string(trafficReport.meanTripDelayRatio) + "x free-flow time");
+        }
+    }
+    
+    // Without traffic assignment vehicles emit at their free-flow rate
+    void resetCongestion() {
+        for (size_t v = 0; v < vehicles.size(); v++) {
+            if (vehicles[v]->getCongestionFactor() != 1.0) mutableVehicle(v)->setCongestionFactor(1.0);
+        }
+    }
+    
+    // Count today's passages per street segment (commutes past each citizen's building and
+    // the vehicles' routes), then derive segment noise and feed loud segments to pollution control
+    void runStreetNoise() {
+        segmentNoiseEnergy.assign(streetNetwork->getSegmentCount(), 0.0);
+        for (size_t i = 0; i < citizens.size(); i++) {
+            const Building* building = citizens[i]->getBuilding();
+            const Transport* transport = citizens[i]->getTransport();
+            if (!transport) continue;
+            // Out in the morning, back in the evening, as the rider's share of a vehicle (a bus is
+            // shared by its riders, trains and planes stay off the streets): along the route when
+            // there is one, otherwise just past the citizen's building
+            double energy = 2.0 * TrafficAssignment::commuterVehicles(transport->getType());
+            if (energy <= 0.0) continue;
+            if (i < commuteRoutes.size() && commuteRoutes[i] && commuteRoutes[i]->found) {
+                for (uint32_t segment : commuteRoutes[i]->segments) {
+                    segmentNoiseEnergy[segment] += energy;
+                }
+                continue;
+            }
+            if (!building) continue;
+            size_t segment = streetNetwork->segmentOf(building->getAddress());
+            if (segment != StreetNetwork::NONE) segmentNoiseEnergy[segment] += energy;
+        }
+        for (const auto& entry : vehicleRoutes) {
+            if (entry.first >= vehicles.size()) continue;
+            double energy = entry.second.tripsPerDay * StreetNoise::vehicleWeight(vehicles[entry.first]->getType());
+            for (size_t segment : entry.second.segments) {
+                segmentNoiseEnergy[segment] += energy;
+            }
+        }
+        
+        noiseReport = streetNoise->compute(day, segmentNoiseEnergy);
+        
+        for (size_t s = 0; s < noiseReport.levelDb.size(); s++) {
+            if (noiseReport.levelDb[s] < noiseReport.loudThresholdDb) continue;
+            const StreetSegment& segment = streetNetwork->getSegment(s);
+            Address location(segment.street, (segment.firstHouse + segment.lastHouse) / 2);
+            pollutionControl->addDeposit(PollutionControl::streetNoiseDeposit(noiseReport.levelDb[s], noiseReport.loudThresholdDb),
+                                         1.0, &location);
+        }
+        pollutionControl->monitorStreetNoise(noiseReport.loudSegments, noiseReport.maxLevelDb);
+        if (logging(LogLevel::VERBOSE, LogCategory::NETWORKS)) {
+            logger->log("Street noise: mean " + to_string(noiseReport.meanLevelDb) + " dB, " +
+                        to_string(noiseReport.loudSegments) + " loud segments");
+        }
+    }
+    
 public:
     // Constructor
-    City(const string& cityName, const string& mayorName, double initialBudget): name(cityName), mayor(mayorName), budget(initialBudget),ecoScore(100.0), day(0), rng(random_device{}()) {
+    City(const string& cityName, const string& mayorName, double initialBudget): name(cityName), mayor(mayorName), budget(initialBudget),ecoScore(100.0), day(0),
+        cohortMode(false), cohortMembersStale(false), cohortLookupValid(false),
+        hourlyResolution(false), travelProfile(HourlyProfile::commute()), commercialProfile(HourlyProfile::businessHours()),
+        serviceProfile(HourlyProfile::household()), hourlyTotals(), energyReport(), waterReport(), gasReport(),
+        contentionReport(), defaultNeighborhoodCapacity(1000.0), noiseReport(), trafficReport(),
+        summary(), summaryStale(true), consoleOutput(true), rng(random_device{}()) {
         
-        // Initialize pollution control
-        pollutionControl = make_unique<PollutionControl>();
+        // Initialize pollution control, with a log of its own per city
+        pollutionControl = make_unique<PollutionControl>(make_shared<FileLogSink>(cityName + "_pollution_log.txt"));
         
         // Initialize logger
         logger = make_unique<CityLogger<string>>(cityName, cityName + "_log.txt");
         
         // Log initialization
-        logger->log("City " + cityName + " established with Mayor " + mayorName);
+        if (logging(LogLevel::INFO, LogCategory::GENERAL)) {
+            logger->log("City " + cityName + " established with Mayor " + mayorName);
+        }
     }
     
     // Add a building to the city
@@ -70,109 +1079,582 @@ public:
             throw invalid_argument("Cannot add a null building");
         }
         
-        string buildingName = building->getName();
         buildings.push_back(move(building));
+        summaryStale = true;
+        
+        // Log the addition
+        if (logging(LogEvent::BUILDING_ADDED)) {
+            logEvent(LogEvent::BUILDING_ADDED, buildings.back()->getName());
+        }
+    }
+    
+    // Add a vehicle to the city
+    void addTransport(unique_ptr<Transport> vehicle) {
+        if (vehicle == nullptr) {
+            throw invalid_argument("Cannot add a null transport");
+        }
+        
+        vehicles.push_back(move(vehicle));
+        summaryStale = true;
+        
+        // Log the addition
+        if (logging(LogEvent::TRANSPORT_ADDED)) {
+            logEvent(LogEvent::TRANSPORT_ADDED, vehicles.back()->getType());
+        }
+    }
+    
+    // Add a citizen to the city
+    void addCitizen(unique_ptr<Citizen> citizen) {
+        if (citizen == nullptr) {
+            throw invalid_argument("Cannot add a null citizen");
+        }
+        
+        citizens.push_back(move(citizen));
+        summaryStale = true;
+        
+        // Join an identical cohort, or start a new one
+        if (cohortMode) {
+            if (!cohortLookupValid) rebuildCohortLookup();
+            size_t index = citizens.size() - 1;
+            auto inserted = cohortLookup.emplace(makeCohortKey(*citizens[index]), cohorts.size());
+            if (inserted.second) {
+                cohorts.push_back(CitizenCohort{index, {index}});
+            } else {
+                cohorts[inserted.first->second].members.push_back(index);
+            }
+            cohortOf.push_back(inserted.first->second);
+        }
+        
+        // Log the addition
+        if (logging(LogEvent::CITIZEN_JOINED)) {
+            logEvent(LogEvent::CITIZEN_JOINED, citizens.size());
+        }
+    }
+    
+    // Add a housing scheme to the city
+    void addHousingScheme(unique_ptr<HousingScheme> housing) {
+        if (housing == nullptr) {
+            throw invalid_argument("Cannot add a null housing scheme");
+        }
+        
+        housingSchemes.push_back(move(housing));
+        summaryStale = true;
+        
+        // Log the addition
+        if (logging(LogEvent::HOUSING_ADDED)) {
+            logEvent(LogEvent::HOUSING_ADDED, housingSchemes.back()->getSchemeName());
+        }
+    }
+    
+    // Add a service to the city
+    void addService(unique_ptr<Services> service) {
+        if (service == nullptr) {
+            throw invalid_argument("Cannot add a null service");
+        }
+        
+        services.push_back(move(service));
+        summaryStale = true;
         
         // Log the addition
-        logger->log("Added new building: " + buildingName);
+        if (logging(LogEvent::SERVICE_ADDED)) {
+            logEvent(LogEvent::SERVICE_ADDED, services.back()->getServiceType());
+        }
+    }
+    
+    // Simulate a single day in the city
+    void simulateDay() {
+        day++;
+        summaryStale = true;
+        if (logging(LogEvent::DAY_STARTED)) {
+            logEvent(LogEvent::DAY_STARTED, day);
+        }
+        
+        // Entities shared with a forked city are copied before the day changes them
+        detachChangingEntities();
+        
+        // Fire today's events in time order before the daily roll-up
+        size_t eventsFired = scheduler.runDay([this](const CityEvent& event) { fireEvent(event); });
+        if (eventsFired > 0) {
+            if (logging(LogLevel::VERBOSE, LogCategory::SIMULATION)) {
+                logger->log("Processed " + to_string(eventsFired) + " events on day " + to_string(day));
+            }
+        }
+        
+        // Route today's commutes so travel distances come from the streets
+        if (commuteRouter) {
+            routeCommutes();
+        }
+        
+        // Load the streets with the commuters; congestion raises vehicle emissions
+        if (trafficAssignment) {
+            runTraffic();
+        }
+        
+        // Calculate eco score before day activities
+        double previousEcoScore = ecoScore;
+        
+        // Simulate citizens (once per cohort in cohort mode)
+        if (cohortMode) {
+            for (const auto& cohort : cohorts) {
+                Citizen* rep = mutableCitizen(cohort.representative);
+                rep->simulateDay(consoleOutput);
+                pollutionControl->monitorCitizen(rep, cohort.getWeight());
+            }
+            cohortMembersStale = true;
+            cohortLookupValid = false;
+        } else {
+            for (size_t i = 0; i < citizens.size(); i++) {
+                Citizen* citizen = mutableCitizen(i);
+                citizen->simulateDay(consoleOutput);
+                pollutionControl->monitorCitizen(citizen);
+            }
+        }
+        
+        // Simulate buildings
+        for (auto& building : buildings) {
+            building->updateEcoScore();
+            pollutionControl->monitorBuilding(building.get());
+        }
+        
+        // Simulate vehicles
+        for (auto& vehicle : vehicles) {
+            pollutionControl->monitorTransport(vehicle.get());
+        }
+        
+        // Simulate services
+        for (auto& service : services) {
+            pollutionControl->monitorService(service.get());
+        }
+        
+        // Simulate housing
+        for (auto& housing : housingSchemes) {
+            pollutionControl->monitorHousingScheme(housing.get());
+        }
+        
+        // Spread the day's activity over its hours
+        if (hourlyResolution) {
+            computeHourlyTotals();
+        }
+        
+        // Net building demand against on-site generation and bill the import
+        if (energyBalance) {
+            balanceEnergy();
+        }
+        
+        // Draw today's water demand through the mains
+        if (waterNetwork) {
+            runWaterNetwork();
+        }
+        
+        // Solve gas pressures for today's draw
+        if (gasNetwork) {
+            runGasNetwork();
+        }
+        
+        // Share neighborhood backhaul among today's internet demand
+        if (internetContention) {
+            runInternetContention();
+        }
+        
+        // Traffic noise along the streets
+        if (streetNetwork) {
+            runStreetNoise();
+        }
+        
+        // Spread and decay the day's pollution over the city map
+        if (pollutionControl->hasGrid()) {
+            pollutionControl->advanceGrid();
+        }
+        
+        // Update eco score based on all components
+        updateEcoScore();
+        
+        // Apply budget changes
+        double dailyCost = calculateDailyOperationCost();
+        budget -= dailyCost;
+        
+        // Record the day's history
+        if (timeSeries) {
+            timeSeries->append(dailyRecord());
+        }
+        recordEntityHistory();
+        
+        // Log end of day
+        if (logging(LogEvent::DAY_COMPLETED)) {
+            logEvent(LogEvent::DAY_COMPLETED, day, ecoScore);
+        }
+    }
+    
+    // Queue an event; it fires during the simulateDay() call covering its time
+    void scheduleEvent(const CityEvent& event) {
+        switch (event.type) {
+            case CityEventType::COMMUTE:
+                if (event.target >= citizens.size()) throw out_of_range("Event targets an unknown citizen");
+                break;
+            case CityEventType::SERVICE_OUTAGE:
+            case CityEventType::SERVICE_RESTORE:
+                if (event.target >= services.size()) throw out_of_range("Event targets an unknown service");
+                break;
+            case CityEventType::POLLUTION_SPIKE:
+                if (event.target > static_cast<size_t>(PollutionKind::SOLID_WASTE)) {
+                    throw out_of_range("Unknown pollution kind");
+                }
+                break;
+        }
+        if (event.amount < 0) {
+            throw invalid_argument("Event amount cannot be negative");
+        }
+        scheduler.schedule(event);
+    }
+    
+    size_t getPendingEventCount() const { return scheduler.getPendingCount(); }
+    
+    // Hourly resolution: each simulated day also records its activity hour by hour
+    void setHourlyResolution(bool enabled) {
+        hourlyResolution = enabled;
+        if (logging(LogLevel::INFO, LogCategory::GENERAL)) {
+            logger->log(string("Hourly resolution ") + (enabled ? "enabled" : "disabled"));
+        }
+    }
+    
+    bool isHourlyResolution() const { return hourlyResolution; }
+    
+    void setHourlyProfiles(const HourlyProfile& travel, const HourlyProfile& commercial, const HourlyProfile& service) {
+        travelProfile = travel;
+        commercialProfile = commercial;
+        serviceProfile = service;
+    }
+    
+    // Hourly breakdown of the last simulated day
+    const HourlyTotals& getHourlyTotals() const {
+        if (!hourlyResolution || hourlyTotals.day == 0) {
+            throw runtime_error("No hourly data: enable hourly resolution and simulate a day first");
+        }
+        return hourlyTotals;
+    }
+    
+    // Energy balance: each simulated day nets demand against generation per district
+    // and bills the grid import to the district's electricity accounts
+    void enableEnergyBalance(size_t threadCount = 0) {
+        if (energyBalance) return;
+        energyBalance = make_shared<EnergyBalance>(threadCount);
+        if (logging(LogLevel::INFO, LogCategory::GENERAL)) {
+            logger->log("Energy balance enabled");
+        }
+    }
+    
+    void disableEnergyBalance() {
+        if (!energyBalance) return;
+        energyBalance.reset();
+        if (logging(LogLevel::INFO, LogCategory::GENERAL)) {
+            logger->log("Energy balance disabled");
+        }
+    }
+    
+    // Energy balance of the last simulated day
+    const EnergyReport& getEnergyReport() const {
+        if (!energyBalance || energyReport.day == 0) {
+            throw runtime_error("No energy balance: enable it and simulate a day first");
+        }
+        return energyReport;
+    }
+    
+    // Water network: each simulated day solves the mains for the metered demand
+    void setWaterNetwork(unique_ptr<WaterNetwork> network) {
+        waterNetwork = move(network);
+        pollutionControl->setWaterFromNetwork(waterNetwork != nullptr);
+        // Demand is counted from the meters' current readings onwards
+        waterMeterBaseline.assign(services.size(), 0.0);
+        for (size_t i = 0; i < services.size(); i++) {
+            if (auto* account = dynamic_cast<const WaterManagement*>(services[i].get())) {
+                waterMeterBaseline[i] = account->getConsumptionCubicMeters();
+            }
+        }
+        if (logging(LogLevel::INFO, LogCategory::GENERAL)) {
+            logger->log(waterNetwork ? "Water network attached" : "Water network removed");
+        }
+    }
+    
+    WaterNetwork* getWaterNetwork() { return waterNetwork.get(); }
+    
+    // Water network results of the last simulated day
+    const WaterNetworkReport& getWaterNetworkReport() const {
+        if (!waterNetwork || waterReport.day == 0) {
+            throw runtime_error("No water network results: attach a network and simulate a day first");
+        }
+        return waterReport;
+    }
+    
+    // Gas network: each simulated day solves pressures for the gas drawn at each address
+    void setGasNetwork(unique_ptr<GasNetwork> network) {
+        gasNetwork = move(network);
+        gasMeterBaseline.assign(services.size(), 0.0);
+        for (size_t i = 0; i < services.size(); i++) {
+            if (auto* account = dynamic_cast<const GasManagement*>(services[i].get())) {
+                gasMeterBaseline[i] = account->getTotalConsumption();
+            }
+        }
+        if (logging(LogLevel::INFO, LogCategory::GENERAL)) {
+            logger->log(gasNetwork ? "Gas network attached" : "Gas network removed");
+        }
+    }
+    
+    GasNetwork* getGasNetwork() { return gasNetwork.get(); }
+    
+    // Gas network results of the last simulated day
+    const GasNetworkReport& getGasNetworkReport() const {
+        if (!gasNetwork || gasReport.day == 0) {
+            throw runtime_error("No gas network results: attach a network and simulate a day first");
+        }
+        return gasReport;
+    }
+    
+    // Internet contention: each simulated day shares every neighborhood's backhaul
+    // (subscribers on the same street and pin) max-min fairly among its subscribers
+    void enableInternetContention(size_t threadCount = 0) {
+        if (internetContention) return;
+        internetContention = make_shared<InternetContention>(threadCount);
+        internetMeterBaseline.assign(services.size(), 0.0);
+        for (size_t i = 0; i < services.size(); i++) {
+            if (auto* account = dynamic_cast<const InternetManagement*>(services[i].get())) {
+                internetMeterBaseline[i] = account->getDataUsedGB();
+            }
+        }
+        if (logging(LogLevel::INFO, LogCategory::GENERAL)) {
+            logger->log("Internet contention enabled");
+        }
+    }
+    
+    void disableInternetContention() {
+        if (!internetContention) return;
+        internetContention.reset();
+        if (logging(LogLevel::INFO, LogCategory::GENERAL)) {
+            logger->log("Internet contention disabled");
+        }
+    }
+    
+    void setNeighborhoodCapacity(const Address& address, double mbps) {
+        if (mbps < 0) {
+            throw invalid_argument("Backhaul capacity cannot be negative");
+        }
+        neighborhoodCapacity[InternetContention::neighborhoodKey(address)] = mbps;
+    }
+    
+    // Capacity of neighborhoods without their own setting
+    void setDefaultNeighborhoodCapacity(double mbps) {
+        if (mbps < 0) {
+            throw invalid_argument("Backhaul capacity cannot be negative");
+        }
+        defaultNeighborhoodCapacity = mbps;
+    }
+    
+    // Pollution grid: deposits land in the cell of the entity's address (streets along x,
+    // house numbers along y) and the grid is diffused and decayed once per simulated day
+    void enablePollutionGrid(size_t width, size_t height, int streetsPerCell = 1, int housesPerCell = 1,
+                             size_t threadCount = 0) {
+        pollutionControl->attachGrid(make_unique<PollutionGrid>(width, height, streetsPerCell, housesPerCell, threadCount));
+        if (logging(LogLevel::INFO, LogCategory::GENERAL)) {
+            logger->log("Pollution grid enabled: " + to_string(width) + "x" + to_string(height));
+        }
+    }
+    
+    void disablePollutionGrid() {
+        if (!pollutionControl->hasGrid()) return;
+        pollutionControl->attachGrid(nullptr);
+        if (logging(LogLevel::INFO, LogCategory::GENERAL)) {
+            logger->log("Pollution grid disabled");
+        }
+    }
+    
+    // Street network: traffic noise is computed per segment from commutes and vehicle routes
+    // instead of from each vehicle's emissions. Building the noise index visits every pair of
+    // segments within cutoffRadius meters, so it is done once here.
+    void setStreetNetwork(const StreetNetwork& network, double cutoffRadius = 300.0, size_t threadCount = 0) {
+        streetNetwork = make_shared<const StreetNetwork>(network);
+        streetNoise = make_shared<StreetNoise>(streetNetwork, cutoffRadius, threadCount);
+        vehicleRoutes.clear();
+        segmentNoiseEnergy.clear();
+        noiseReport = StreetNoiseReport();
+        // Routes over the old network no longer apply
+        if (commuteRouter) {
+            commuteRouter.reset();
+            commuteRoutes.clear();
+            if (logging(LogLevel::INFO, LogCategory::GENERAL)) {
+                logger->log("Commute routing disabled: street network replaced");
+            }
+        }
+        if (trafficAssignment) {
+            trafficAssignment.reset();
+            trafficReport = TrafficReport();
+            resetCongestion();
+            if (logging(LogLevel::INFO, LogCategory::GENERAL)) {
+                logger->log("Traffic assignment disabled: street network replaced");
+            }
+        }
+        pollutionControl->setNoiseFromStreets(true);
+        if (logging(LogLevel::INFO, LogCategory::GENERAL)) {
+            logger->log("Street network attached: " + to_string(network.getSegmentCount()) + " segments");
+        }
+    }
+    
+    void removeStreetNetwork() {
+        if (!streetNetwork) return;
+        streetNetwork.reset();
+        streetNoise.reset();
+        vehicleRoutes.clear();
+        segmentNoiseEnergy.clear();
+        commuteRouter.reset();
+        commuteRoutes.clear();
+        if (trafficAssignment) {
+            trafficAssignment.reset();
+            trafficReport = TrafficReport();
+            resetCongestion();
+        }
+        pollutionControl->setNoiseFromStreets(false);
+        if (logging(LogLevel::INFO, LogCategory::GENERAL)) {
+            logger->log("Street network removed");
+        }
+    }
+    
+    const StreetNetwork* getStreetNetwork() const { return streetNetwork.get(); }
+    
+    // Commute routing: each simulated day, citizens with a commute are routed over the street
+    // network and their daily travel distance (and so their emissions) follows the route.
+    // Preprocessing the network for fast routing happens here, once.
+    void enableCommuteRouting(size_t threadCount = 0) {
+        if (!streetNetwork) {
+            throw runtime_error("Attach a street network before enabling commute routing");
+        }
+        if (commuteRouter) return;
+        commuteRouter = make_shared<CommuteRouter>(streetNetwork, threadCount);
+        if (logging(LogLevel::INFO, LogCategory::GENERAL)) {
+            logger->log("Commute routing enabled: " + to_string(commuteRouter->getHierarchy().getShortcutCount()) +
+                        " shortcuts over " + to_string(streetNetwork->getIntersectionCount()) + " intersections");
+        }
+    }
+    
+    void disableCommuteRouting() {
+        if (!commuteRouter) return;
+        commuteRouter.reset();
+        commuteRoutes.clear();
+        if (logging(LogLevel::INFO, LogCategory::GENERAL)) {
+            logger->log("Commute routing disabled");
+        }
+    }
+    
+    // Today's route of a citizen, or nullptr if the citizen was not routed
+    const CommuteRoute* getCommuteRoute(size_t citizen) const {
+        if (citizen >= citizens.size()) {
+            throw out_of_range("Citizen index out of range");
+        }
+        return (citizen < commuteRoutes.size()) ? commuteRoutes[citizen].get() : nullptr;
+    }
+    
+    // Traffic assignment: each simulated day the peak hour of the commutes is assigned to the
+    // streets at user equilibrium, and every commuting vehicle's emissions scale with the delay
+    void enableTrafficAssignment(size_t threadCount = 0) {
+        if (!streetNetwork) {
+            throw runtime_error("Attach a street network before enabling traffic assignment");
+        }
+        if (trafficAssignment) return;
+        trafficAssignment = make_shared<TrafficAssignment>(streetNetwork, threadCount);
+        if (logging(LogLevel::INFO, LogCategory::GENERAL)) {
+            logger->log("Traffic assignment enabled");
+        }
     }
     
-    // Add a vehicle to the city
-    void addTransport(unique_ptr<Transport> vehicle) {
-        if (vehicle == nullptr) {
-            throw invalid_argument("Cannot add a null transport");
+    void disableTrafficAssignment() {
+        if (!trafficAssignment) return;
+        trafficAssignment.reset();
+        trafficReport = TrafficReport();
+        resetCongestion();
+        if (logging(LogLevel::INFO, LogCategory::GENERAL)) {
+            logger->log("Traffic assignment disabled");
         }
-        
-        string vehicleType = vehicle->getType();
-        vehicles.push_back(move(vehicle));
-        
-        // Log the addition
-        logger->log("Added new transport: " + vehicleType);
     }
     
-    // Add a citizen to the city
-    void addCitizen(unique_ptr<Citizen> citizen) {
-        if (citizen == nullptr) {
-            throw invalid_argument("Cannot add a null citizen");
+    void setStreetCapacity(int street, double vehiclesPerHour) {
+        if (!trafficAssignment) {
+            throw runtime_error("Enable traffic assignment before setting street capacities");
         }
-        
-        string citizenName = citizen->getName();
-        citizens.push_back(move(citizen));
-        
-        // Log the addition
-        logger->log("New citizen joined the city. Total population: " + to_string(citizens.size()));
+        if (trafficAssignment.use_count() > 1) trafficAssignment = make_shared<TrafficAssignment>(*trafficAssignment);
+        trafficAssignment->setStreetCapacity(street, vehiclesPerHour);
     }
     
-    // Add a housing scheme to the city
-    void addHousingScheme(unique_ptr<HousingScheme> housing) {
-        if (housing == nullptr) {
-            throw invalid_argument("Cannot add a null housing scheme");
+    void setFreeFlowSpeed(double kmh) {
+        if (!trafficAssignment) {
+            throw runtime_error("Enable traffic assignment before setting the free-flow speed");
         }
-        
-        string schemeName = housing->getSchemeName();
-        housingSchemes.push_back(move(housing));
-        
-        // Log the addition
-        logger->log("Added new housing scheme: " + schemeName);
+        if (trafficAssignment.use_count() > 1) trafficAssignment = make_shared<TrafficAssignment>(*trafficAssignment);
+        trafficAssignment->setFreeFlowSpeed(kmh);
     }
     
-    // Add a service to the city
-    void addService(unique_ptr<Services> service) {
-        if (service == nullptr) {
-            throw invalid_argument("Cannot add a null service");
+    // Traffic of the last simulated day
+    const TrafficReport& getTrafficReport() const {
+        if (!trafficAssignment || trafficReport.day == 0) {
+            throw runtime_error("No traffic results: enable traffic assignment and simulate a day first");
         }
-        
-        string serviceType = service->getServiceType();
-        services.push_back(move(service));
-        
-        // Log the addition
-        logger->log("Added new service: " + serviceType);
+        return trafficReport;
     }
     
-    // Simulate a single day in the city
-    void simulateDay() {
-        day++;
-        logger->log("Starting simulation for day " + to_string(day));
-        
-        // Calculate eco score before day activities
-        double previousEcoScore = ecoScore;
-        
-        // Simulate citizens
-        for (auto& citizen : citizens) {
-            citizen->simulateDay();
-            pollutionControl->monitorCitizen(citizen.get());
+    // A vehicle drives past every stop's street segment tripsPerDay times a day
+    void setVehicleRoute(size_t vehicle, const vector<Address>& stops, double tripsPerDay = 1.0) {
+        if (!streetNetwork) {
+            throw runtime_error("Attach a street network before routing vehicles");
         }
-        
-        // Simulate buildings
-        for (auto& building : buildings) {
-            building->updateEcoScore();
-            pollutionControl->monitorBuilding(building.get());
+        if (vehicle >= vehicles.size()) {
+            throw out_of_range("Vehicle index out of range");
         }
-        
-        // Simulate vehicles
-        for (auto& vehicle : vehicles) {
-            pollutionControl->monitorTransport(vehicle.get());
+        if (tripsPerDay < 0) {
+            throw invalid_argument("Trips per day cannot be negative");
         }
-        
-        // Simulate services
-        for (auto& service : services) {
-            pollutionControl->monitorService(service.get());
+        VehicleRoute route{{}, tripsPerDay};
+        for (const auto& stop : stops) {
+            size_t segment = streetNetwork->segmentOf(stop);
+            if (segment == StreetNetwork::NONE) {
+                throw invalid_argument("Route stop [" + stop.display(false) + "] is not on the street network");
+            }
+            if (find(route.segments.begin(), route.segments.end(), segment) == route.segments.end()) {
+                route.segments.push_back(segment);
+            }
         }
-        
-        // Simulate housing
-        for (auto& housing : housingSchemes) {
-            pollutionControl->monitorHousingScheme(housing.get());
+        vehicleRoutes[vehicle] = move(route);
+    }
+    
+    // Street noise of the last simulated day
+    const StreetNoiseReport& getStreetNoiseReport() const {
+        if (!streetNetwork || noiseReport.day == 0) {
+            throw runtime_error("No street noise results: attach a street network and simulate a day first");
         }
-        
-        // Update eco score based on all components
-        updateEcoScore();
-        
-        // Apply budget changes
-        double dailyCost = calculateDailyOperationCost();
-        budget -= dailyCost;
-        
-        // Log end of day
-        logger->log("Day " + to_string(day) + " completed. Eco Score: " + to_string(ecoScore));
+        return noiseReport;
+    }
+    
+    // Traffic noise level in dB at an address on the last simulated day
+    double getNoiseExposure(const Address& address) const {
+        getStreetNoiseReport();
+        return streetNoise->exposureAt(segmentNoiseEnergy, address);
+    }
+    
+    // Contention results of the last simulated day
+    const ContentionReport& getContentionReport() const {
+        if (!internetContention || contentionReport.day == 0) {
+            throw runtime_error("No contention results: enable internet contention and simulate a day first");
+        }
+        return contentionReport;
+    }
+    
+    // Display the hourly breakdown of the last simulated day
+    void displayHourlyReport() const {
+        const HourlyTotals& totals = getHourlyTotals();
+        cout << "\n===== HOURLY ACTIVITY FOR DAY " << totals.day << " =====" << endl;
+        cout << "Hour  Travel(km)  Travel CO2  Vehicle CO2  Commercial kWh  Service usage" << endl;
+        for (int h = 0; h < HOURS_PER_DAY; h++) {
+            cout << (h < 10 ? " " : "") << h << ":00  "
+                 << totals.travelKm[h] << "  " << totals.travelEmissions[h] << "  "
+                 << totals.vehicleEmissions[h] << "  " << totals.commercialEnergyKWh[h] << "  "
+                 << totals.serviceUsage[h] << endl;
+        }
+        cout << "=============================================" << endl;
     }
     
     // Simulate multiple days
@@ -186,247 +1668,108 @@ public:
         }
     }
     
+    // Per-entity contributions to the eco score (averaged per category in the summary)
+    static double citizenEcoImpact(double ecoScore) {
+        // Convert 0-100 scale to impact (-50 to +50)
+        return (ecoScore - 50.0) / -1.0;
+    }
+    static double citizenEcoImpact(const Citizen& citizen) { return citizenEcoImpact(citizen.calculateEcoScore()); }
+    static double transportEcoImpact(const Transport& vehicle) { return vehicle.getCarbonEmissions() * 0.1; }
+    static double housingEcoImpact(const HousingScheme& housing) { return (100.0 - housing.getSustainabilityRating()) * 0.5; }
+    static double serviceEcoImpact(const Services& service) { return (100.0 - service.getReliabilityScore()) * 0.2; }
+    static double pollutionEcoImpact(double air, double water, double noise, double solidWaste) {
+        return air * 0.3 + water * 0.3 + noise * 0.2 + solidWaste * 0.2;
+    }
+    
+    // Daily operating cost of a service; different services have different costs
+    static double serviceOperatingCost(const string& type) {
+        if (type == "Water") return 75.0;
+        if (type == "Electricity") return 100.0;
+        if (type == "Gas") return 80.0;
+        if (type == "Internet") return 50.0;
+        return 0.0;
+    }
+    
+    // Aggregates of the current entities, computed in one pass the first time they are read after a change.
+    // Returned as a copy: the cache is recomputed in place, possibly by another thread.
+    CitySummary getSummary() const {
+        lock_guard<mutex> guard(summaryLock);
+        if (summaryStale) {
+            summary = computeSummary();
+            summaryStale = false;
+        }
+        return summary;
+    }
+    
+    // Compute the summary over blocks of entities in parallel; threadCount = 0 uses every hardware thread
+    void enableParallelSummary(size_t threadCount = 0) {
+        summaryPool = make_shared<ThreadPool>(threadCount);
+    }
+    
+    void disableParallelSummary() {
+        summaryPool.reset();
+    }
+    
     // Update the city's eco score
     void updateEcoScore() {
-        // Base score starting point
-        double newScore = 100.0;
-        
-        // Buildings impact
-        double buildingImpact = 0.0;
-        for (const auto& building : buildings) {
-            buildingImpact += building->getEcoScoreImpact();
-        }
-        // Normalize building impact
-        if (!buildings.empty()) {
-            buildingImpact /= buildings.size();
-        }
-        
-        // Citizens impact
-        double citizenImpact = 0.0;
-        for (const auto& citizen : citizens) {
-            // Convert 0-100 scale to impact (-50 to +50)
-            double impact = (citizen->calculateEcoScore() - 50.0) / -1.0;
-            citizenImpact += impact;
-        }
-        // Normalize citizen impact
-        if (!citizens.empty()) {
-            citizenImpact /= citizens.size();
-        }
-        
-        // Transport impact
-        double transportImpact = 0.0;
-        for (const auto& vehicle : vehicles) {
-            transportImpact += vehicle->getCarbonEmissions() * 0.1;
-        }
-        // Normalize transport impact
-        if (!vehicles.empty()) {
-            transportImpact /= vehicles.size();
-        }
-        
-        // Housing impact
-        double housingImpact = 0.0;
-        for (const auto& housing : housingSchemes) {
-            housingImpact += (100.0 - housing->getSustainabilityRating()) * 0.5;
-        }
-        // Normalize housing impact
-        if (!housingSchemes.empty()) {
-            housingImpact /= housingSchemes.size();
-        }
-        
-        // Services impact (lower reliability means higher impact)
-        double servicesImpact = 0.0;
-        for (const auto& service : services) {
-            servicesImpact += (100.0 - service->getReliabilityScore()) * 0.2;
-        }
-        // Normalize services impact
-        if (!services.empty()) {
-            servicesImpact /= services.size();
-        }
+        CitySummary s = getSummary();
         
         // Pollution impact
-        double pollutionImpact = pollutionControl->getAirPollutionLevel() * 0.3 +
-                                pollutionControl->getWaterPollutionLevel() * 0.3 +
-                                pollutionControl->getNoisePollutionLevel() * 0.2 +
-                                pollutionControl->getSolidWasteLevel() * 0.2;
+        double pollutionImpact = pollutionEcoImpact(pollutionControl->getAirPollutionLevel(),
+                                                   pollutionControl->getWaterPollutionLevel(),
+                                                   pollutionControl->getNoisePollutionLevel(),
+                                                   pollutionControl->getSolidWasteLevel());
         
-        // Calculate final score
-        newScore -= (buildingImpact + citizenImpact + transportImpact + housingImpact + servicesImpact + pollutionImpact);
+        // Calculate final score from a base of 100
+        double newScore = 100.0 - (s.buildingImpact + s.citizenImpact + s.transportImpact + s.housingImpact +
+                                   s.servicesImpact + pollutionImpact);
         
         // Ensure score is between 0 and 100
         ecoScore = max(0.0, min(100.0, newScore));
         
         // Log the updated score
-        logger->log("Updated eco score: " + to_string(ecoScore));
+        if (logging(LogLevel::VERBOSE, LogCategory::SIMULATION)) {
+            logger->log("Updated eco score: " + to_string(ecoScore));
+        }
     }
     
     // Calculate daily operation cost
     double calculateDailyOperationCost() const {
-        // Base city operation cost
-        double cost = 100.0;
-        
-        // Buildings maintenance cost
-        cost += buildings.size() * 50.0;
-        
-        // Services operation cost
-        for (const auto& service : services) {
-            // Different services have different costs
-            string type = service->getServiceType();
-            if (type == "Water") {
-                cost += 75.0;
-            } else if (type == "Electricity") {
-                cost += 100.0;
-            } else if (type == "Gas") {
-                cost += 80.0;
-            } else if (type == "Internet") {
-                cost += 50.0;
-            }
-        }
-        
-        // Transport maintenance cost
-        cost += vehicles.size() * 30.0;
-        
-        return cost;
+        CitySummary s = getSummary();
+        // Base city operation cost, buildings maintenance, services operation and transport maintenance
+        return 100.0 + s.buildingCount * 50.0 + s.serviceOperatingCost + s.vehicleCount * 30.0;
+    }
+    
+    // Copy of everything the reports show, safe to render on another thread
+    CityReport takeReportSnapshot() const {
+        return CityReport{name, mayor, day, budget, ecoScore, getSummary(), pollutionControl->getLevels()};
     }
     
     // Display city statistics
     void displayStatistics() const {
-        cout << "\n===== CITY STATISTICS: " << name << " =====" << endl;
-        cout << "Mayor: " << mayor << endl;
-        cout << "Day: " << day << endl;
-        cout << "Budget: $" << budget << endl;
-        cout << "Eco Score: " << ecoScore << "/100" << endl;
-        cout << "Population: " << citizens.size() << endl;
-        cout << "Buildings: " << buildings.size() << endl;
-        cout << "Housing Schemes: " << housingSchemes.size() << endl;
-        cout << "Vehicles: " << vehicles.size() << endl;
-        cout << "Services: " << services.size() << endl;
-        
-        // Show pollution levels
-        pollutionControl->generateReport();
+        renderReport(ReportKind::STATISTICS);
     }
     
     // Generate detailed report about city status
     void generateDetailedReport() const {
-        cout << "\n================ DETAILED CITY REPORT =================" << endl;
-        cout << "City: " << name << " | Mayor: " << mayor << " | Day: " << day << endl;
-        cout << "Budget: $" << budget << " | Eco Score: " << ecoScore << "/100" << endl;
-        
-        cout << "\n--- POPULATION (" << citizens.size() << " citizens) ---" << endl;
-        if (citizens.empty()) {
-            cout << "No citizens in the city." << endl;
-        } else {
-            // Display average eco score
-            double totalEcoScore = 0.0;
-            for (const auto& citizen : citizens) {
-                totalEcoScore += citizen->calculateEcoScore();
-            }
-            double avgEcoScore = totalEcoScore / citizens.size();
-            cout << "Average Citizen Eco Score: " << avgEcoScore << "/100" << endl;
-            
-            // Show top 5 citizens if available
-            cout << "Top Citizens by Eco Score:" << endl;
-            vector<const Citizen*> sortedCitizens;
-            for (const auto& citizen : citizens) {
-                sortedCitizens.push_back(citizen.get());
-            }
-            
-            sort(sortedCitizens.begin(), sortedCitizens.end(), 
-                 [](const Citizen* a, const Citizen* b) {
-                     return a->calculateEcoScore() > b->calculateEcoScore();
-                 });
-            
-            for (size_t i = 0; i < min(size_t(5), sortedCitizens.size()); i++) {
-                cout << i+1 << ". " << sortedCitizens[i]->getName() 
-                     << " (" << sortedCitizens[i]->calculateEcoScore() << "/100)" << endl;
-            }
-        }
-        
-        cout << "\n--- BUILDINGS (" << buildings.size() << " buildings) ---" << endl;
-        if (buildings.empty()) {
-            cout << "No buildings in the city." << endl;
-        } else {
-            // Count building types
-            int residential = 0, commercial = 0, green = 0, industrial = 0, recreational = 0, educational = 0;
-            
-            for (const auto& building : buildings) {
-                if (dynamic_cast<ResidentialBuilding*>(building.get())) residential++;
-                else if (dynamic_cast<CommercialBuilding*>(building.get())) commercial++;
-                else if (dynamic_cast<GreenBuilding*>(building.get())) green++;
-                else if (dynamic_cast<IndustrialBuilding*>(building.get())) industrial++;
-                else if (dynamic_cast<RecreationalBuilding*>(building.get())) recreational++;
-                else if (dynamic_cast<EducationalBuilding*>(building.get())) educational++;
-            }
-            
-            cout << "Residential: " << residential << endl;
-            cout << "Commercial: " << commercial << endl;
-            cout << "Green: " << green << endl;
-            cout << "Industrial: " << industrial << endl;
-            cout << "Recreational: " << recreational << endl;
-            cout << "Educational: " << educational << endl;
-        }
-        
-        cout << "\n--- HOUSING (" << housingSchemes.size() << " schemes) ---" << endl;
-        if (housingSchemes.empty()) {
-            cout << "No housing schemes in the city." << endl;
-        } else {
-            // Count housing types and calculate average sustainability
-            int apartments = 0, villas = 0;
-            double totalSustainability = 0.0;
-            int totalUnits = 0, occupiedUnits = 0;
-            
-            for (const auto& housing : housingSchemes) {
-                if (dynamic_cast<ApartmentComplex*>(housing.get())) apartments++;
-                else if (dynamic_cast<VillaComplex*>(housing.get())) villas++;
-                
-                totalSustainability += housing->getSustainabilityRating();
-                totalUnits += housing->getTotalUnits();
-                occupiedUnits += housing->getOccupiedUnits();
-            }
-            
-            double avgSustainability = totalSustainability / housingSchemes.size();
-            double occupancyRate = (totalUnits > 0) ? (double(occupiedUnits) / totalUnits * 100.0) : 0.0;
-            
-            cout << "Apartment Complexes: " << apartments << endl;
-            cout << "Villa Complexes: " << villas << endl;
-            cout << "Average Sustainability: " << avgSustainability << "/100" << endl;
-            cout << "Total Units: " << totalUnits << " (" << occupiedUnits << " occupied, " 
-                 << occupancyRate << "% occupancy)" << endl;
-        }
-        
-        cout << "\n--- SERVICES (" << services.size() << " services) ---" << endl;
-        if (services.empty()) {
-            cout << "No services in the city." << endl;
-        } else {
-            for (const auto& service : services) {
-                cout << "Service: " << service->getServiceType() 
-                     << " (Reliability: " << service->getReliabilityScore() << "%)" << endl;
-            }
-        }
-        
-        cout << "\n--- TRANSPORT (" << vehicles.size() << " vehicles) ---" << endl;
-        if (vehicles.empty()) {
-            cout << "No vehicles in the city." << endl;
-        } else {
-            // Count vehicle types
-            map<string, int> vehicleCounts;
-            double totalEmissions = 0.0;
-            
-            for (const auto& vehicle : vehicles) {
-                vehicleCounts[vehicle->getType()]++;
-                totalEmissions += vehicle->getCarbonEmissions();
-            }
-            
-            for (const auto& [type, count] : vehicleCounts) {
-                cout << type << "s: " << count << endl;
-            }
-            
-            cout << "Total Carbon Emissions: " << totalEmissions << " kg CO2" << endl;
-        }
-        
-        cout << "\n--- POLLUTION CONTROL ---" << endl;
-        pollutionControl->generateReport();
-        
-        cout << "\n=====================================================\n" << endl;
+        renderReport(ReportKind::DETAILED);
+    }
+    
+    // Render reports on a background thread into sink (cout when null); displayStatistics()
+    // and generateDetailedReport() then return as soon as the snapshot is taken
+    void enableAsyncReports(shared_ptr<LogSink> sink = nullptr) {
+        if (!sink) sink = make_shared<StreamLogSink>(cout);
+        reportRenderer = make_unique<AsyncReportRenderer>(move(sink));
+    }
+    
+    // Back to rendering on the calling thread, after the queued reports are written
+    void disableAsyncReports() {
+        reportRenderer.reset();
+    }
+    
+    // Wait until every report requested so far has been written
+    void flushReports() {
+        if (reportRenderer) reportRenderer->flush();
     }
     
     // Save statistics to a file
@@ -437,11 +1780,18 @@ public:
             return false;
         }
         
+        CitySummary s = getSummary();
+        
         // Current timestamp
         time_t now = time(0);
         struct tm tstruct;
         char buf[80];
-        tstruct = *localtime(&now);
+        // Reentrant variant, cities may be simulated on several threads
+#ifdef _WIN32
+        localtime_s(&tstruct, &now);
+#else
+        localtime_r(&now, &tstruct);
+#endif
         strftime(buf, sizeof(buf), "%Y-%m-%d %X", &tstruct);
         
         file << "===== CITY STATISTICS: " << name << " =====" << endl;
@@ -450,11 +1800,11 @@ public:
         file << "Day: " << day << endl;
         file << "Budget: $" << budget << endl;
         file << "Eco Score: " << ecoScore << "/100" << endl;
-        file << "Population: " << citizens.size() << endl;
-        file << "Buildings: " << buildings.size() << endl;
-        file << "Housing Schemes: " << housingSchemes.size() << endl;
-        file << "Vehicles: " << vehicles.size() << endl;
-        file << "Services: " << services.size() << endl;
+        file << "Population: " << s.population << endl;
+        file << "Buildings: " << s.buildingCount << endl;
+        file << "Housing Schemes: " << s.housingCount << endl;
+        file << "Vehicles: " << s.vehicleCount << endl;
+        file << "Services: " << s.serviceCount << endl;
         
         // Add pollution data to file
         file << "Air Pollution Level: " << pollutionControl->getAirPollutionLevel() << endl;
@@ -471,7 +1821,120 @@ public:
         pollutionControl->implementReductionMeasures();
         budget -= 200.0; // Cost of pollution measures
         updateEcoScore(); // Update eco score after measures
-        logger->log("Implemented pollution reduction measures");
+        if (logging(LogLevel::INFO, LogCategory::POLLUTION)) {
+            logger->log("Implemented pollution reduction measures");
+        }
+    }
+    
+    // Switch on cohort mode: identical citizens are grouped and simulated once per tick
+    void enableCohortMode() {
+        if (cohortMode) return;
+        
+        cohorts = buildCohorts(citizens);
+        cohortOf.assign(citizens.size(), 0);
+        for (size_t c = 0; c < cohorts.size(); c++) {
+            for (size_t member : cohorts[c].members) {
+                cohortOf[member] = c;
+            }
+        }
+        cohortMode = true;
+        cohortMembersStale = false;
+        cohortLookupValid = false;
+        summaryStale = true;
+        
+        if (logging(LogLevel::INFO, LogCategory::GENERAL)) {
+            logger->log("Cohort mode enabled: " + to_string(citizens.size()) + " citizens in " +
+                        to_string(cohorts.size()) + " cohorts");
+        }
+    }
+    
+    // Switch off cohort mode, writing the shared state back into every citizen
+    void disableCohortMode() {
+        if (!cohortMode) return;
+        
+        syncCohortMembers();
+        cohorts.clear();
+        cohortOf.clear();
+        cohortLookup.clear();
+        cohortMode = false;
+        summaryStale = true;
+        
+        if (logging(LogLevel::INFO, LogCategory::GENERAL)) {
+            logger->log("Cohort mode disabled");
+        }
+    }
+    
+    // Mutable access to a citizen; in cohort mode it is split off since its state may diverge.
+    // The caller may change the entity, so the summary is recomputed on its next read
+    Citizen& getCitizen(size_t index) {
+        if (index >= citizens.size()) {
+            throw out_of_range("Citizen index out of range");
+        }
+        if (cohortMode) {
+            splitFromCohort(index);
+        }
+        summaryStale = true;
+        return *mutableCitizen(index);
+    }
+    
+    // Mutable access to the other entities (copied first if shared with a fork)
+    Building& getBuilding(size_t index) {
+        if (index >= buildings.size()) {
+            throw out_of_range("Building index out of range");
+        }
+        summaryStale = true;
+        return *mutableBuilding(index);
+    }
+    
+    Transport& getTransport(size_t index) {
+        if (index >= vehicles.size()) {
+            throw out_of_range("Transport index out of range");
+        }
+        summaryStale = true;
+        return *mutableVehicle(index);
+    }
+    
+    HousingScheme& getHousingScheme(size_t index) {
+        if (index >= housingSchemes.size()) {
+            throw out_of_range("Housing scheme index out of range");
+        }
+        summaryStale = true;
+        return *mutableHousingScheme(index);
+    }
+    
+    Services& getService(size_t index) {
+        if (index >= services.size()) {
+            throw out_of_range("Service index out of range");
+        }
+        summaryStale = true;
+        return *mutableService(index);
+    }
+    
+    // Read-only access, never copies (in cohort mode members lag their representative until synced)
+    const Citizen& getCitizen(size_t index) const { return *citizens.at(index); }
+    const Building& getBuilding(size_t index) const { return *buildings.at(index); }
+    const Transport& getTransport(size_t index) const { return *vehicles.at(index); }
+    const HousingScheme& getHousingScheme(size_t index) const { return *housingSchemes.at(index); }
+    const Services& getService(size_t index) const { return *services.at(index); }
+    
+    size_t getBuildingCount() const { return buildings.size(); }
+    size_t getTransportCount() const { return vehicles.size(); }
+    size_t getHousingSchemeCount() const { return housingSchemes.size(); }
+    size_t getServiceCount() const { return services.size(); }
+    
+    bool isCohortMode() const { return cohortMode; }
+    size_t getCohortCount() const { return cohortMode ? cohorts.size() : citizens.size(); }
+    
+    // Independent deep copy of the whole city (entities, pollution levels, budget, day)
+    unique_ptr<City> clone(const string& cloneName) const {
+        return unique_ptr<City>(new City(cloneName, *this, false));
+    }
+    
+    // Logically independent copy that shares all entities with this city and copies
+    // each one only when either city modifies it, so the cost of a what-if branch
+    // follows what the branch changes rather than the size of the city
+    unique_ptr<City> fork(const string& forkName) const {
+        return unique_ptr<City>(new City(forkName, *this, true));
     }
     
     // Getters
@@ -481,6 +1944,134 @@ public:
     double getEcoScore() const { return ecoScore; }
     int getDay() const { return day; }
     int getPopulation() const { return citizens.size(); }
+    const PollutionControl& getPollutionControl() const { return *pollutionControl; }
+    
+    void setBudget(double newBudget) { budget = newBudget; }
+    
+    // Binary log: day, entity and monitoring events are written unformatted to filename
+    // (appended) instead of to the text logs; render them with logdecode
+    void enableBinaryLog(const string& filename) {
+        binaryLog = make_shared<BinaryLog>(filename);
+        pollutionControl->setBinaryLog(binaryLog);
+        if (logging(LogLevel::INFO, LogCategory::GENERAL)) {
+            logger->log("Binary log opened: " + filename);
+        }
+    }
+    
+    void disableBinaryLog() {
+        if (!binaryLog) return;
+        binaryLog->flush();
+        binaryLog.reset();
+        pollutionControl->setBinaryLog(nullptr);
+        if (logging(LogLevel::INFO, LogCategory::GENERAL)) {
+            logger->log("Binary log closed");
+        }
+    }
+    
+    void flushBinaryLog() {
+        if (binaryLog) binaryLog->flush();
+    }
+    
+    // Time series: after every simulated day its budget, eco score, pollution levels, population
+    // and eco score deductions are appended to filename; read it with TimeSeriesReader or tsexport
+    void enableTimeSeries(const string& filename, size_t daysPerChunk = 365) {
+        timeSeries = make_unique<TimeSeriesWriter>(filename, daysPerChunk);
+        if (logging(LogLevel::INFO, LogCategory::GENERAL)) {
+            logger->log("Time series opened: " + filename);
+        }
+    }
+    
+    void disableTimeSeries() {
+        if (!timeSeries) return;
+        timeSeries.reset();
+        if (logging(LogLevel::INFO, LogCategory::GENERAL)) {
+            logger->log("Time series closed");
+        }
+    }
+    
+    void flushTimeSeries() {
+        if (timeSeries) timeSeries->flush();
+    }
+    
+    // Entity history: after every simulated day the field's value for each citizen or building
+    // (by index) is kept in memory, packed, from the next simulated day on
+    void enableEntityHistory(HistoryField field) {
+        auto& history = histories.at(static_cast<size_t>(field));
+        if (history) return;
+        history = make_unique<EntityHistory>(historyFieldInfo(field).resolution);
+        if (logging(LogLevel::INFO, LogCategory::GENERAL)) {
+            logger->log(string("Entity history enabled: ") + historyFieldInfo(field).name);
+        }
+    }
+    
+    void disableEntityHistory(HistoryField field) {
+        histories.at(static_cast<size_t>(field)).reset();
+    }
+    
+    // Recorded values of one citizen or building over [fromDay, toDay]
+    HistorySeries getEntityHistory(HistoryField field, size_t entity, int fromDay = numeric_limits<int>::min(),
+                                   int toDay = numeric_limits<int>::max()) const {
+        const auto& history = histories.at(static_cast<size_t>(field));
+        if (!history) {
+            throw logic_error(string("No history is kept for ") + historyFieldInfo(field).name);
+        }
+        return history->getSeries(entity, fromDay, toDay);
+    }
+    
+    size_t getEntityHistoryMemory() const {
+        size_t bytes = 0;
+        for (const auto& history : histories) {
+            if (history) bytes += history->getMemoryUsage();
+        }
+        return bytes;
+    }
+    
+    // The row the time series gets for the current day
+    DailyRecord dailyRecord() const {
+        CitySummary s = getSummary();
+        PollutionLevels levels = pollutionControl->getLevels();
+        return DailyRecord{day, budget, ecoScore, levels.air, levels.water, levels.noise, levels.solidWaste,
+                           static_cast<int64_t>(s.population), s.buildingImpact, s.citizenImpact,
+                           s.transportImpact, s.housingImpact, s.servicesImpact,
+                           pollutionEcoImpact(levels.air, levels.water, levels.noise, levels.solidWaste)};
+    }
+    
+    // Messages below the level or in a disabled category are skipped, here and in pollution control
+    void setLogLevel(LogLevel level) {
+        logFilter.setLevel(level);
+        pollutionControl->setLogFilter(logFilter);
+    }
+    
+    void setLogCategory(LogCategory category, bool enabled) {
+        logFilter.setCategory(category, enabled);
+        pollutionControl->setLogFilter(logFilter);
+    }
+    
+    const LogFilter& getLogFilter() const { return logFilter; }
+    
+    // Daily console messages (vehicle emissions, pollution warnings and measures); the logs still get theirs
+    void setConsoleOutput(bool enabled) {
+        consoleOutput = enabled;
+        pollutionControl->setConsoleOutput(enabled);
+    }
+    
+    bool getConsoleOutput() const { return consoleOutput; }
+    
+    // Where the city log and the pollution log are written (file, memory, null or async sinks)
+    void setLogSink(shared_ptr<LogSink> sink) {
+        logger->setSink(move(sink));
+    }
+    
+    void setPollutionLogSink(shared_ptr<LogSink> sink) {
+        pollutionControl->setLogSink(move(sink));
+    }
+    
+    // Write out log lines the sinks still hold
+    void flushLogs() {
+        logger->flush();
+        pollutionControl->flushLog();
+        if (binaryLog) binaryLog->flush();
+    }
     
     // Display log entries
     void displayLogs() const {
@@ -488,6 +2079,27 @@ public:
             logger->displayAllLogs();
         }
     }
+    
+    // Log entries containing a substring, optionally logged between two times
+    vector<pair<string, string>> findLogs(const string& searchTerm) const {
+        return logger->findLogs(searchTerm);
+    }
+    
+    vector<pair<string, string>> findLogs(const string& searchTerm, time_t from, time_t to) const {
+        return logger->findLogs(searchTerm, from, to);
+    }
+    
+    // Log entries beyond this much memory move to a scratch file
+    void setLogMemoryBudget(size_t bytes) {
+        logger->setMemoryBudget(bytes);
+    }
+    
+    void setLogCompression(bool enabled) {
+        logger->setCompression(enabled);
+    }
+    
+    // Sampled projections read the entity lists directly
+    friend class SampledSimulation;
 };
 
 #endif // CITY_H
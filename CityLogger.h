@@ -2,124 +2,258 @@
 #define CITYLOGGER_H
 
 #include <string>
-#include <fstream>
 #include <iostream>
 #include <ctime>
 #include <vector>
 #include <stdexcept>
 #include <memory>
+#include <sstream>
+#include <limits>
+#include <type_traits>
+
+#include "LogStore.h"
+#include "LogSink.h"
 
 using namespace std;
 
+/**
+ * Entries of a CityLogger, kept in memory exactly as logged.
+ * A search formats each entry the way it was written to the log.
+ */
+template<typename T>
+class LogEntryList {
+private:
+    vector<pair<time_t, T>> entries;
+
+public:
+    void append(time_t when, const T& data) { entries.emplace_back(when, data); }
+
+    template<typename Visit>
+    void forEach(Visit visit) const {
+        for (const auto& entry : entries) visit(entry.first, entry.second);
+    }
+
+    template<typename Visit>
+    void find(const string& term, time_t from, time_t to, Visit visit) const {
+        for (const auto& entry : entries) {
+            if (entry.first < from || entry.first > to) continue;
+            ostringstream text;
+            text << entry.second;
+            if (text.str().find(term) != string::npos) visit(entry.first, entry.second);
+        }
+    }
+
+    // Typed entries always stay in memory
+    void setMemoryBudget(size_t) {}
+    void setCompression(bool) {}
+
+    size_t size() const { return entries.size(); }
+    size_t getMemoryUsage() const { return entries.capacity() * sizeof(pair<time_t, T>); }
+    uint64_t getDiskUsage() const { return 0; }
+    void clear() { entries.clear(); }
+};
+
+/**
+ * Text entries go to a LogStore, which indexes them for search and spills
+ * older ones to disk past its memory budget.
+ */
+template<>
+class LogEntryList<string> {
+private:
+    LogStore store;
+
+public:
+    void append(time_t when, const string& data) { store.append(when, data); }
+
+    template<typename Visit>
+    void forEach(Visit visit) const { store.forEach(visit); }
+
+    template<typename Visit>
+    void find(const string& term, time_t from, time_t to, Visit visit) const { store.find(term, from, to, visit); }
+
+    void setMemoryBudget(size_t bytes) { store.setMemoryBudget(bytes); }
+    void setCompression(bool enabled) { store.setCompression(enabled); }
+
+    size_t size() const { return store.size(); }
+    size_t getMemoryUsage() const { return store.getMemoryUsage(); }
+    uint64_t getDiskUsage() const { return store.getDiskUsage(); }
+    void clear() { store.clear(); }
+};
+
 /**
  * Generic template class for city logging
  * Can log any type of data with a timestamp
+ * Entries come back exactly as logged. String entries are indexed for
+ * search and can spill to disk (see LogStore); forEachEntry streams them
+ * without holding more than one on-disk segment in memory.
  */
 template<typename T>
 class CityLogger {
 private:
     string logName;
-    ofstream logFile;
-    vector<pair<string, T>> logEntries;
+    shared_ptr<LogSink> sink;   // where formatted lines go, if anywhere
+    LogEntryList<T> logEntries;
+    time_t cachedTime;
+    string cachedTimestamp;
     
-    // Get current timestamp as string
-    string getCurrentTimestamp() const {
-        time_t now = time(0);
+    // Format a timestamp as string
+    static string formatTimestamp(time_t when) {
         struct tm tstruct;
         char buf[80];
-        tstruct = *localtime(&now);
+        // Reentrant variant, cities may be simulated on several threads
+#ifdef _WIN32
+        localtime_s(&tstruct, &when);
+#else
+        localtime_r(&when, &tstruct);
+#endif
         strftime(buf, sizeof(buf), "%Y-%m-%d %X", &tstruct);
         return string(buf);
     }
     
+    static string toText(const T& data) {
+        ostringstream text;
+        text << data;
+        return text.str();
+    }
+    
+    // A note about the log itself: an entry when T can hold text, otherwise only a line in the sink
+    void logNotice(const char* text) {
+        if constexpr (is_constructible<T, const char*>::value) {
+            log(T(text));
+        } else if (sink) {
+            sink->write("[" + formatTimestamp(time(0)) + "] " + text);
+        }
+    }
+    
 public:
     // Constructor
     CityLogger(const string& name, const string& filename = "") 
-        : logName(name) {
+        : logName(name), cachedTime(-1) {
         if (!filename.empty()) {
             openLogFile(filename);
         }
     }
     
-    // Destructor
+    CityLogger(const string& name, shared_ptr<LogSink> destination)
+        : logName(name), sink(move(destination)), cachedTime(-1) {}
+    
+    // Destructor: a sink shared with other loggers stays open
     ~CityLogger() {
-        if (logFile.is_open()) {
-            logFile.close();
+        if (sink) {
+            sink->flush();
         }
     }
     
     // Open log file
     void openLogFile(const string& filename) {
-        logFile.open(filename, ios::app);
-        if (!logFile.is_open()) {
-            throw runtime_error("Could not open log file: " + filename);
-        }
-        log("Log file opened");
+        setSink(make_shared<FileLogSink>(filename));
+        logNotice("Log file opened");
     }
     
     // Close log file
     void closeLogFile() {
-        if (logFile.is_open()) {
-            log("Log file closed");
-            logFile.close();
+        if (sink) {
+            logNotice("Log file closed");
+            setSink(nullptr);
+        }
+    }
+    
+    // Send formatted lines somewhere else; the previous sink is flushed
+    void setSink(shared_ptr<LogSink> destination) {
+        if (sink) {
+            sink->flush();
+        }
+        sink = move(destination);
+    }
+    
+    shared_ptr<LogSink> getSink() const { return sink; }
+    
+    void flush() {
+        if (sink) {
+            sink->flush();
         }
     }
     
     // Log an entry
     void log(const T& data) {
-        string timestamp = getCurrentTimestamp();
-        logEntries.push_back(make_pair(timestamp, data));
+        // The timestamp only changes once a second
+        time_t now = time(0);
+        if (now != cachedTime) {
+            cachedTime = now;
+            cachedTimestamp = formatTimestamp(now);
+        }
+        logEntries.append(now, data);
         
-        if (logFile.is_open()) {
-            logFile << "[" << timestamp << "] " << data << endl;
+        if (sink) {
+            sink->write("[" + cachedTimestamp + "] " + toText(data));
         }
     }
     
-    // Get all log entries
-    const vector<pair<string, T>>& getLogEntries() const {
-        return logEntries;
+    // Visit every log entry in order as visit(timestamp, data), including those spilled to disk
+    template<typename Visit>
+    void forEachEntry(Visit visit) const {
+        logEntries.forEach([&visit](time_t when, const T& data) {
+            visit(formatTimestamp(when), data);
+        });
+    }
+    
+    // Get all log entries, including those spilled to disk
+    vector<pair<string, T>> getLogEntries() const {
+        vector<pair<string, T>> entries;
+        entries.reserve(logEntries.size());
+        logEntries.forEach([&entries](time_t when, const T& data) {
+            entries.push_back(make_pair(formatTimestamp(when), data));
+        });
+        return entries;
     }
     
     // Display all log entries
     void displayAllLogs() const {
         cout << "===== " << logName << " Logs =====" << endl;
-        for (const auto& entry : logEntries) {
-            cout << "[" << entry.first << "] " << entry.second << endl;
-        }
+        logEntries.forEach([](time_t when, const T& data) {
+            cout << "[" << formatTimestamp(when) << "] " << data << endl;
+        });
         cout << "==========================" << endl;
     }
     
     // Find logs containing a specific substring
     vector<pair<string, T>> findLogs(const string& searchTerm) const {
+        return findLogs(searchTerm, numeric_limits<time_t>::min(), numeric_limits<time_t>::max());
+    }
+    
+    // Find logs containing a specific substring, logged between two times (inclusive)
+    vector<pair<string, T>> findLogs(const string& searchTerm, time_t from, time_t to) const {
         vector<pair<string, T>> results;
-        
-        for (const auto& entry : logEntries) {
-            // Convert T to string using to_string for numeric types
-            string entryStr = to_string(entry.second);
-            if (entryStr.find(searchTerm) != string::npos) {
-                results.push_back(entry);
-            }
-        }
-        
+        logEntries.find(searchTerm, from, to, [&results](time_t when, const T& data) {
+            results.push_back(make_pair(formatTimestamp(when), data));
+        });
         return results;
     }
     
+    // Entries beyond this much memory move to a scratch file (string entries only)
+    void setMemoryBudget(size_t bytes) {
+        logEntries.setMemoryBudget(bytes);
+    }
+    
+    // Compress entries as they move to disk (string entries only)
+    void setCompression(bool enabled) {
+        logEntries.setCompression(enabled);
+    }
+    
+    size_t getEntryCount() const { return logEntries.size(); }
+    size_t getMemoryUsage() const { return logEntries.getMemoryUsage(); }
+    uint64_t getDiskUsage() const { return logEntries.getDiskUsage(); }
+    
     // Clear all entries from memory (not file)
     void clearEntries() {
         logEntries.clear();
     }
 };
 
-// Template specialization for std::string to handle findLogs properly
+// Strings are stored and returned as logged
 template<>
-vector<pair<string, string>> CityLogger<string>::findLogs(const string& searchTerm) const {
-    vector<pair<string, string>> results;
-    for (const auto& entry : logEntries) {
-        if (entry.second.find(searchTerm) != string::npos) {
-            results.push_back(entry);
-        }
-    }
-    return results;
+inline string CityLogger<string>::toText(const string& data) {
+    return data;
 }
 
 #endif // CITYLOGGER_H
\ No newline at end of file
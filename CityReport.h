@@ -0,0 +1,231 @@
+#ifndef CITYREPORT_H
+#define CITYREPORT_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <stdexcept>
+
+#include "CitySummary.h"
+#include "PollutionControl.h"
+#include "LogSink.h"
+
+using namespace std;
+
+enum class ReportKind {
+    STATISTICS,   // headline numbers and pollution levels
+    DETAILED      // per-category breakdown
+};
+
+/**
+ * Everything a city report shows, copied out of the city.
+ * A snapshot never changes once taken, so it can be rendered on any thread
+ * while the city simulates the next day.
+ */
+struct CityReport {
+    string name;
+    string mayor;
+    int day;
+    double budget;
+    double ecoScore;
+    CitySummary summary;
+    PollutionLevels pollution;
+};
+
+// Renders report snapshots as text; lines end in '\n' and nothing is flushed
+class ReportWriter {
+public:
+    static void write(ostream& out, const CityReport& report, ReportKind kind) {
+        if (kind == ReportKind::DETAILED) writeDetailed(out, report);
+        else writeStatistics(out, report);
+    }
+
+    static string render(const CityReport& report, ReportKind kind) {
+        ostringstream out;
+        write(out, report, kind);
+        return out.str();
+    }
+
+    static void writeStatistics(ostream& out, const CityReport& report) {
+        const CitySummary& s = report.summary;
+        out << "\n===== CITY STATISTICS: " << report.name << " =====\n";
+        out << "Mayor: " << report.mayor << "\n";
+        out << "Day: " << report.day << "\n";
+        out << "Budget: $" << report.budget << "\n";
+        out << "Eco Score: " << report.ecoScore << "/100\n";
+        out << "Population: " << s.population << "\n";
+        out << "Buildings: " << s.buildingCount << "\n";
+        out << "Housing Schemes: " << s.housingCount << "\n";
+        out << "Vehicles: " << s.vehicleCount << "\n";
+        out << "Services: " << s.serviceCount << "\n";
+
+        // Show pollution levels
+        PollutionControl::writeReport(out, report.pollution);
+    }
+
+    static void writeDetailed(ostream& out, const CityReport& report) {
+        const CitySummary& s = report.summary;
+        out << "\n================ DETAILED CITY REPORT =================\n";
+        out << "City: " << report.name << " | Mayor: " << report.mayor << " | Day: " << report.day << "\n";
+        out << "Budget: $" << report.budget << " | Eco Score: " << report.ecoScore << "/100\n";
+
+        out << "\n--- POPULATION (" << s.population << " citizens) ---\n";
+        if (s.population == 0) {
+            out << "No citizens in the city.\n";
+        } else {
+            out << "Average Citizen Eco Score: " << s.averageCitizenEcoScore << "/100\n";
+
+            // Show top 5 citizens if available
+            out << "Top Citizens by Eco Score:\n";
+            for (size_t i = 0; i < s.topCitizens.size(); i++) {
+                out << i+1 << ". " << s.topCitizens[i].first << " (" << s.topCitizens[i].second << "/100)\n";
+            }
+        }
+
+        out << "\n--- BUILDINGS (" << s.buildingCount << " buildings) ---\n";
+        if (s.buildingCount == 0) {
+            out << "No buildings in the city.\n";
+        } else {
+            auto count = [&s](BuildingKind kind) { return s.buildingsByKind[static_cast<size_t>(kind)]; };
+            out << "Residential: " << count(BuildingKind::RESIDENTIAL) << "\n";
+            out << "Commercial: " << count(BuildingKind::COMMERCIAL) << "\n";
+            out << "Green: " << count(BuildingKind::GREEN_BUILDING) << "\n";
+            out << "Industrial: " << count(BuildingKind::INDUSTRIAL) << "\n";
+            out << "Recreational: " << count(BuildingKind::RECREATIONAL) << "\n";
+            out << "Educational: " << count(BuildingKind::EDUCATIONAL) << "\n";
+        }
+
+        out << "\n--- HOUSING (" << s.housingCount << " schemes) ---\n";
+        if (s.housingCount == 0) {
+            out << "No housing schemes in the city.\n";
+        } else {
+            out << "Apartment Complexes: " << s.apartments << "\n";
+            out << "Villa Complexes: " << s.villas << "\n";
+            out << "Average Sustainability: " << s.averageSustainability << "/100\n";
+            out << "Total Units: " << s.totalUnits << " (" << s.occupiedUnits << " occupied, "
+                << s.occupancyRate() << "% occupancy)\n";
+        }
+
+        out << "\n--- SERVICES (" << s.serviceCount << " services) ---\n";
+        if (s.serviceCount == 0) {
+            out << "No services in the city.\n";
+        } else {
+            for (const auto& [type, reliability] : s.serviceReliability) {
+                out << "Service: " << type << " (Reliability: " << reliability << "%)\n";
+            }
+        }
+
+        out << "\n--- TRANSPORT (" << s.vehicleCount << " vehicles) ---\n";
+        if (s.vehicleCount == 0) {
+            out << "No vehicles in the city.\n";
+        } else {
+            for (const auto& [type, count] : s.vehiclesByType) {
+                out << type << "s: " << count << "\n";
+            }
+
+            out << "Total Carbon Emissions: " << s.totalEmissions << " kg CO2\n";
+        }
+
+        out << "\n--- POLLUTION CONTROL ---\n";
+        PollutionControl::writeReport(out, report.pollution);
+
+        out << "\n=====================================================\n\n";
+    }
+};
+
+/**
+ * Renders report snapshots on a background thread.
+ * submit() only queues the snapshot; the worker renders each one and hands
+ * the text to the sink as a single write, so the simulation never waits on
+ * formatting or on the terminal. flush() waits until every report submitted
+ * so far has been written and the sink flushed.
+ */
+class AsyncReportRenderer {
+private:
+    struct Job {
+        shared_ptr<const CityReport> report;
+        ReportKind kind;
+    };
+
+    shared_ptr<LogSink> sink;
+    vector<Job> queued;
+    size_t submittedCount;   // reports ever submitted
+    size_t renderedCount;    // reports ever written to the sink
+    bool stopping;
+    mutex lock;
+    condition_variable wake;
+    condition_variable drained;
+    thread worker;
+
+    void run() {
+        vector<Job> batch;
+        unique_lock<mutex> guard(lock);
+        while (true) {
+            wake.wait(guard, [this] { return stopping || !queued.empty(); });
+            if (queued.empty() && stopping) return;
+            batch.swap(queued);
+            guard.unlock();
+            for (const Job& job : batch) {
+                string text = ReportWriter::render(*job.report, job.kind);
+                if (!text.empty() && text.back() == '\n') text.pop_back();   // the sink ends the line
+                sink->write(text);
+            }
+            guard.lock();
+            renderedCount += batch.size();
+            batch.clear();
+            drained.notify_all();
+        }
+    }
+
+public:
+    explicit AsyncReportRenderer(shared_ptr<LogSink> destination)
+        : sink(move(destination)), submittedCount(0), renderedCount(0), stopping(false) {
+        if (!sink) {
+            throw invalid_argument("Report renderer needs a sink");
+        }
+        worker = thread([this] { run(); });
+    }
+
+    ~AsyncReportRenderer() {
+        {
+            lock_guard<mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_one();
+        worker.join();
+        sink->flush();
+    }
+
+    AsyncReportRenderer(const AsyncReportRenderer&) = delete;
+    AsyncReportRenderer& operator=(const AsyncReportRenderer&) = delete;
+
+    void submit(shared_ptr<const CityReport> report, ReportKind kind) {
+        if (!report) {
+            throw invalid_argument("Cannot render a null report");
+        }
+        {
+            lock_guard<mutex> guard(lock);
+            queued.push_back(Job{move(report), kind});
+            submittedCount++;
+        }
+        wake.notify_one();
+    }
+
+    void flush() {
+        {
+            unique_lock<mutex> guard(lock);
+            size_t goal = submittedCount;
+            drained.wait(guard, [this, goal] { return renderedCount >= goal; });
+        }
+        sink->flush();
+    }
+
+    shared_ptr<LogSink> getSink() const { return sink; }
+};
+
+#endif // CITYREPORT_H
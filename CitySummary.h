@@ -0,0 +1,63 @@
+#ifndef CITYSUMMARY_H
+#define CITYSUMMARY_H
+
+#include <string>
+#include <vector>
+#include <array>
+#include <cstddef>
+
+#include "buildings.h"
+
+using namespace std;
+
+/**
+ * Aggregates of a city's entities, taken in one pass per entity list.
+ * The eco score, the daily operating cost and every report read from it,
+ * so none of them walks the entity lists again.
+ */
+struct CitySummary {
+    static constexpr size_t TOP_CITIZENS = 5;
+
+    int day;
+
+    size_t population;
+    size_t buildingCount;
+    size_t vehicleCount;
+    size_t housingCount;
+    size_t serviceCount;
+
+    // Eco score deductions, averaged per entity list
+    double buildingImpact;
+    double citizenImpact;
+    double transportImpact;
+    double housingImpact;
+    double servicesImpact;
+
+    // Citizens
+    double averageCitizenEcoScore;
+    vector<pair<string, double>> topCitizens;   // name and eco score, best first
+
+    // Buildings, indexed by BuildingKind
+    array<size_t, static_cast<size_t>(BuildingKind::COUNT)> buildingsByKind;
+
+    // Housing
+    size_t apartments;
+    size_t villas;
+    double averageSustainability;
+    long long totalUnits;
+    long long occupiedUnits;
+
+    // Services, in city order
+    vector<pair<string, double>> serviceReliability;
+    double serviceOperatingCost;
+
+    // Vehicles, by type name in alphabetical order
+    vector<pair<string, size_t>> vehiclesByType;
+    double totalEmissions;
+
+    double occupancyRate() const {
+        return totalUnits > 0 ? double(occupiedUnits) / totalUnits * 100.0 : 0.0;
+    }
+};
+
+#endif // CITYSUMMARY_H
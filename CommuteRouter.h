@@ -0,0 +1,503 @@
+#ifndef COMMUTEROUTER_H
+#define COMMUTEROUTER_H
+
+#include <string>
+#include <vector>
+#include <queue>
+#include <memory>
+#include <mutex>
+#include <limits>
+#include <cstdint>
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+#include <stdexcept>
+
+#include "Address.h"
+#include "StreetNetwork.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+/**
+ * Contraction hierarchy over the intersections of a street network.
+ * Intersections are contracted one at a time, cheapest first: the rating
+ * weighs shortcuts added against edges removed, the street segments they
+ * stand for, and how deep the node already sits, and is refreshed lazily
+ * when a node reaches the front of the queue. A shortcut replaces u-v-w only
+ * when a bounded witness search finds no path from u to w that is as short
+ * without v. A query is then a bidirectional Dijkstra that only ever moves
+ * to higher-ranked intersections (stalling nodes that are reached more
+ * cheaply from above), so it settles a small part of the network.
+ */
+class ContractionHierarchy {
+public:
+    static constexpr uint32_t NONE = numeric_limits<uint32_t>::max();
+
+private:
+    // An original street segment, or a shortcut made of two edges
+    struct Edge {
+        double length;
+        uint32_t segment;
+        uint32_t first;
+        uint32_t second;
+        uint32_t hops;      // street segments it stands for
+    };
+    struct Arc {
+        uint32_t to;
+        uint32_t edge;
+    };
+
+    vector<Edge> edges;
+    vector<size_t> upStart;    // CSR: arcs to higher-ranked intersections
+    vector<Arc> up;
+    vector<double> upLength;   // length of each upward arc, kept next to the arcs for queries
+    size_t nodeCount;
+
+    // Witness searches that only rate a node stop sooner than the ones that contract it
+    static constexpr size_t RATING_SETTLE_LIMIT = 40;
+    static constexpr size_t WITNESS_SETTLE_LIMIT = 500;
+
+    // Scratch state of witness searches, reset after each search
+    struct Witness {
+        vector<double> dist;
+        vector<char> target;
+        vector<uint32_t> touched;
+        vector<pair<double, uint32_t>> open;
+
+        explicit Witness(size_t nodes) : dist(nodes, numeric_limits<double>::infinity()), target(nodes, 0) {}
+    };
+
+    // Bounded Dijkstra over the remaining graph from `from`, avoiding `skip`, until every
+    // marked target is settled; distances are left in work.dist for the caller to read
+    static void witnessSearch(const vector<vector<Arc>>& graph, const vector<Edge>& edgeList, uint32_t from, uint32_t skip,
+                              double limit, size_t targets, size_t settleLimit, Witness& work) {
+        auto later = greater<pair<double, uint32_t>>();
+        work.dist[from] = 0.0;
+        work.touched.push_back(from);
+        work.open.push_back({0.0, from});
+        size_t settled = 0;
+        while (!work.open.empty() && settled < settleLimit && targets > 0) {
+            pop_heap(work.open.begin(), work.open.end(), later);
+            pair<double, uint32_t> top = work.open.back();
+            work.open.pop_back();
+            if (top.first > work.dist[top.second]) continue;
+            if (top.first > limit) break;
+            settled++;
+            if (work.target[top.second]) targets--;
+            for (const Arc& arc : graph[top.second]) {
+                if (arc.to == skip) continue;
+                double d = top.first + edgeList[arc.edge].length;
+                if (d <= limit && d < work.dist[arc.to]) {
+                    if (work.dist[arc.to] == numeric_limits<double>::infinity()) work.touched.push_back(arc.to);
+                    work.dist[arc.to] = d;
+                    work.open.push_back({d, arc.to});
+                    push_heap(work.open.begin(), work.open.end(), later);
+                }
+            }
+        }
+        work.open.clear();
+    }
+
+    // Shortcuts needed to contract v, as (from arc, to arc) pairs of v's adjacency;
+    // one witness search per neighbour covers all the pairs starting there
+    static vector<pair<size_t, size_t>> neededShortcuts(const vector<vector<Arc>>& graph, const vector<Edge>& edgeList,
+                                                        uint32_t v, size_t settleLimit, Witness& work) {
+        vector<pair<size_t, size_t>> shortcuts;
+        const vector<Arc>& around = graph[v];
+        for (size_t i = 0; i + 1 < around.size(); i++) {
+            double first = edgeList[around[i].edge].length;
+            double longest = 0.0;
+            for (size_t j = i + 1; j < around.size(); j++) {
+                work.target[around[j].to] = 1;
+                longest = max(longest, edgeList[around[j].edge].length);
+            }
+            witnessSearch(graph, edgeList, around[i].to, v, first + longest, around.size() - i - 1, settleLimit, work);
+            for (size_t j = i + 1; j < around.size(); j++) {
+                work.target[around[j].to] = 0;
+                if (work.dist[around[j].to] > first + edgeList[around[j].edge].length) {
+                    shortcuts.push_back({i, j});
+                }
+            }
+            for (uint32_t node : work.touched) work.dist[node] = numeric_limits<double>::infinity();
+            work.touched.clear();
+        }
+        return shortcuts;
+    }
+
+    void unpack(uint32_t edge, vector<uint32_t>& segments) const {
+        const Edge& e = edges[edge];
+        if (e.first == NONE) {
+            segments.push_back(e.segment);
+            return;
+        }
+        unpack(e.first, segments);
+        unpack(e.second, segments);
+    }
+
+public:
+    // Per-thread search state for queries
+    struct Workspace {
+        vector<double> forward, backward;
+        vector<uint32_t> forwardArc, backwardArc;    // edge that reached each node (NONE at a start)
+        vector<uint32_t> forwardParent, backwardParent;
+        vector<uint32_t> touched;
+
+        explicit Workspace(size_t nodes)
+            : forward(nodes, numeric_limits<double>::infinity()), backward(nodes, numeric_limits<double>::infinity()),
+              forwardArc(nodes, NONE), backwardArc(nodes, NONE), forwardParent(nodes, NONE), backwardParent(nodes, NONE) {}
+    };
+
+    explicit ContractionHierarchy(const StreetNetwork& network) : nodeCount(network.getIntersectionCount()) {
+        if (nodeCount >= NONE || network.getSegmentCount() >= NONE) {
+            throw out_of_range("Street network is too large for routing");
+        }
+
+        // Parallel streets between the same intersections keep the shortest
+        vector<vector<Arc>> graph(nodeCount);
+        for (size_t s = 0; s < network.getSegmentCount(); s++) {
+            const StreetSegment& seg = network.getSegment(s);
+            uint32_t a = static_cast<uint32_t>(seg.from), b = static_cast<uint32_t>(seg.to);
+            auto existing = find_if(graph[a].begin(), graph[a].end(), [b](const Arc& arc) { return arc.to == b; });
+            if (existing != graph[a].end()) {
+                if (seg.length < edges[existing->edge].length) {
+                    edges[existing->edge] = {seg.length, static_cast<uint32_t>(s), NONE, NONE, 1};
+                }
+                continue;
+            }
+            edges.push_back({seg.length, static_cast<uint32_t>(s), NONE, NONE, 1});
+            uint32_t id = static_cast<uint32_t>(edges.size() - 1);
+            graph[a].push_back({b, id});
+            graph[b].push_back({a, id});
+        }
+
+        vector<int> depth(nodeCount, 0);
+        Witness witness(nodeCount);
+        vector<vector<Arc>> upward(nodeCount);
+
+        auto priority = [&](uint32_t v) {
+            int removed = 0, removedHops = 0, added = 0, addedHops = 0;
+            for (const Arc& arc : graph[v]) {
+                removed++;
+                removedHops += edges[arc.edge].hops;
+            }
+            for (const auto& pairing : neededShortcuts(graph, edges, v, RATING_SETTLE_LIMIT, witness)) {
+                added++;
+                addedHops += edges[graph[v][pairing.first].edge].hops + edges[graph[v][pairing.second].edge].hops;
+            }
+            if (removed == 0) return static_cast<double>(depth[v]);
+            return 2.0 * added / removed + 4.0 * addedHops / removedHops + depth[v];
+        };
+
+        // Every intersection is in the queue exactly once until it is contracted
+        typedef pair<double, uint32_t> Item;
+        priority_queue<Item, vector<Item>, greater<Item>> order;
+        for (uint32_t v = 0; v < nodeCount; v++) order.push({priority(v), v});
+
+        while (!order.empty()) {
+            Item top = order.top();
+            order.pop();
+            // Lazy update: re-rate the cheapest node and contract it only if it still is the cheapest
+            double current = priority(top.second);
+            if (!order.empty() && current > order.top().first) {
+                order.push({current, top.second});
+                continue;
+            }
+
+            uint32_t v = top.second;
+            for (const auto& pairing : neededShortcuts(graph, edges, v, WITNESS_SETTLE_LIMIT, witness)) {
+                const Arc& a = graph[v][pairing.first];
+                const Arc& b = graph[v][pairing.second];
+                double length = edges[a.edge].length + edges[b.edge].length;
+                uint32_t u = a.to, w = b.to;
+                auto existing = find_if(graph[u].begin(), graph[u].end(), [w](const Arc& arc) { return arc.to == w; });
+                if (existing != graph[u].end() && length >= edges[existing->edge].length) continue;
+                edges.push_back({length, NONE, a.edge, b.edge, edges[a.edge].hops + edges[b.edge].hops});
+                uint32_t id = static_cast<uint32_t>(edges.size() - 1);
+                if (existing != graph[u].end()) {
+                    // A longer edge between the same intersections is replaced in both directions;
+                    // the old edge stays, other shortcuts may be built on it
+                    existing->edge = id;
+                    find_if(graph[w].begin(), graph[w].end(), [u](const Arc& arc) { return arc.to == u; })->edge = id;
+                    continue;
+                }
+                graph[u].push_back({w, id});
+                graph[w].push_back({u, id});
+            }
+
+            // v leaves the remaining graph: its arcs become upward arcs and its neighbours forget it
+            for (const Arc& arc : graph[v]) {
+                upward[v].push_back(arc);
+                depth[arc.to] = max(depth[arc.to], depth[v] + 1);
+                vector<Arc>& back = graph[arc.to];
+                back.erase(find_if(back.begin(), back.end(), [v](const Arc& other) { return other.to == v; }));
+            }
+            vector<Arc>().swap(graph[v]);
+        }
+
+        upStart.assign(nodeCount + 1, 0);
+        for (size_t v = 0; v < nodeCount; v++) upStart[v + 1] = upStart[v] + upward[v].size();
+        up.reserve(upStart[nodeCount]);
+        for (const auto& arcs : upward) up.insert(up.end(), arcs.begin(), arcs.end());
+        upLength.reserve(up.size());
+        for (const Arc& arc : up) upLength.push_back(edges[arc.edge].length);
+    }
+
+    size_t getNodeCount() const { return nodeCount; }
+    size_t getShortcutCount() const {
+        size_t count = 0;
+        for (const Edge& e : edges) if (e.first != NONE) count++;
+        return count;
+    }
+
+    /**
+     * Shortest path between two sets of start and end intersections, each with
+     * an initial distance. Returns infinity if they are not connected; the
+     * street segments along the path are appended to segments.
+     */
+    double query(const vector<pair<uint32_t, double>>& sources, const vector<pair<uint32_t, double>>& targets,
+                 Workspace& work, vector<uint32_t>* segments) const {
+        typedef pair<double, uint32_t> Item;
+        priority_queue<Item, vector<Item>, greater<Item>> forwardOpen, backwardOpen;
+        auto start = [&work](vector<double>& dist, vector<uint32_t>& arc, vector<uint32_t>& parent,
+                             priority_queue<Item, vector<Item>, greater<Item>>& open,
+                             const vector<pair<uint32_t, double>>& from) {
+            for (const auto& s : from) {
+                if (s.second < dist[s.first]) {
+                    if (dist[s.first] == numeric_limits<double>::infinity()) work.touched.push_back(s.first);
+                    dist[s.first] = s.second;
+                    arc[s.first] = NONE;
+                    parent[s.first] = NONE;
+                    open.push({s.second, s.first});
+                }
+            }
+        };
+        start(work.forward, work.forwardArc, work.forwardParent, forwardOpen, sources);
+        start(work.backward, work.backwardArc, work.backwardParent, backwardOpen, targets);
+
+        double best = numeric_limits<double>::infinity();
+        uint32_t meeting = NONE;
+        auto step = [&](vector<double>& dist, vector<uint32_t>& arc, vector<uint32_t>& parent,
+                        priority_queue<Item, vector<Item>, greater<Item>>& open, const vector<double>& other) {
+            Item top = open.top();
+            open.pop();
+            if (top.first > dist[top.second]) return;
+            if (other[top.second] != numeric_limits<double>::infinity() && top.first + other[top.second] < best) {
+                best = top.first + other[top.second];
+                meeting = top.second;
+            }
+            // Stall on demand: a node reached more cheaply down from a higher neighbour is not on a shortest path
+            for (size_t k = upStart[top.second]; k < upStart[top.second + 1]; k++) {
+                if (dist[up[k].to] + upLength[k] < top.first) return;
+            }
+            for (size_t k = upStart[top.second]; k < upStart[top.second + 1]; k++) {
+                const Arc& next = up[k];
+                double d = top.first + upLength[k];
+                if (d < dist[next.to]) {
+                    if (dist[next.to] == numeric_limits<double>::infinity() &&
+                        work.forward[next.to] == numeric_limits<double>::infinity() &&
+                        work.backward[next.to] == numeric_limits<double>::infinity()) {
+                        work.touched.push_back(next.to);
+                    }
+                    dist[next.to] = d;
+                    arc[next.to] = next.edge;
+                    parent[next.to] = top.second;
+                    open.push({d, next.to});
+                }
+            }
+        };
+
+        while (true) {
+            bool forwardLive = !forwardOpen.empty() && forwardOpen.top().first < best;
+            bool backwardLive = !backwardOpen.empty() && backwardOpen.top().first < best;
+            if (!forwardLive && !backwardLive) break;
+            if (forwardLive && (!backwardLive || forwardOpen.top().first <= backwardOpen.top().first)) {
+                step(work.forward, work.forwardArc, work.forwardParent, forwardOpen, work.backward);
+            } else {
+                step(work.backward, work.backwardArc, work.backwardParent, backwardOpen, work.forward);
+            }
+        }
+
+        if (segments && meeting != NONE) {
+            for (uint32_t node = meeting; work.forwardArc[node] != NONE; node = work.forwardParent[node]) {
+                unpack(work.forwardArc[node], *segments);
+            }
+            for (uint32_t node = meeting; work.backwardArc[node] != NONE; node = work.backwardParent[node]) {
+                unpack(work.backwardArc[node], *segments);
+            }
+        }
+
+        for (uint32_t node : work.touched) {
+            work.forward[node] = work.backward[node] = numeric_limits<double>::infinity();
+        }
+        work.touched.clear();
+        return best;
+    }
+};
+
+// Shortest street route between two addresses, one way
+struct CommuteRoute {
+    bool found;
+    double km;
+    vector<uint32_t> segments;   // street segments driven, each once
+};
+
+/**
+ * Routes commutes between addresses over a contraction hierarchy and keeps
+ * every route in a cache keyed by origin and destination, so a city's daily
+ * commutes are mostly cache hits. Batches are routed in parallel and the
+ * cache may be shared by several cities.
+ */
+class CommuteRouter {
+private:
+    struct RouteKey {
+        uint32_t fromSegment;
+        int fromHouse;
+        uint32_t toSegment;
+        int toHouse;
+
+        bool operator==(const RouteKey& other) const {
+            return fromSegment == other.fromSegment && fromHouse == other.fromHouse &&
+                   toSegment == other.toSegment && toHouse == other.toHouse;
+        }
+    };
+    struct RouteKeyHash {
+        size_t operator()(const RouteKey& k) const {
+            uint64_t a = (uint64_t(k.fromSegment) << 32) | uint32_t(k.fromHouse);
+            uint64_t b = (uint64_t(k.toSegment) << 32) | uint32_t(k.toHouse);
+            return hash<uint64_t>()(a * 0x9E3779B97F4A7C15ull ^ b);
+        }
+    };
+
+    shared_ptr<const StreetNetwork> network;
+    ContractionHierarchy hierarchy;
+    ThreadPool pool;
+    mutex cacheLock;
+    unordered_map<RouteKey, shared_ptr<const CommuteRoute>, RouteKeyHash> cache;
+    size_t cacheHits;
+    size_t cacheMisses;
+
+    CommuteRoute compute(const RouteKey& key, ContractionHierarchy::Workspace& work) const {
+        CommuteRoute route{false, 0.0, {}};
+        const StreetSegment& from = network->getSegment(key.fromSegment);
+        const StreetSegment& to = network->getSegment(key.toSegment);
+        auto along = [](const StreetSegment& s, int house) {
+            double t = (s.lastHouse > s.firstHouse) ? double(house - s.firstHouse) / (s.lastHouse - s.firstHouse) : 0.5;
+            return min(1.0, max(0.0, t)) * s.length;
+        };
+        double fromOffset = along(from, key.fromHouse), toOffset = along(to, key.toHouse);
+
+        if (key.fromSegment == key.toSegment) {
+            route.found = true;
+            route.km = abs(fromOffset - toOffset) / 1000.0;
+            route.segments.push_back(key.fromSegment);
+            return route;
+        }
+
+        vector<pair<uint32_t, double>> sources = {{uint32_t(from.from), fromOffset}, {uint32_t(from.to), from.length - fromOffset}};
+        vector<pair<uint32_t, double>> targets = {{uint32_t(to.from), toOffset}, {uint32_t(to.to), to.length - toOffset}};
+        vector<uint32_t> middle;
+        double meters = hierarchy.query(sources, targets, work, &middle);
+        if (meters == numeric_limits<double>::infinity()) return route;
+
+        route.found = true;
+        route.km = meters / 1000.0;
+        route.segments.push_back(key.fromSegment);
+        route.segments.insert(route.segments.end(), middle.begin(), middle.end());
+        route.segments.push_back(key.toSegment);
+        sort(route.segments.begin(), route.segments.end());
+        route.segments.erase(unique(route.segments.begin(), route.segments.end()), route.segments.end());
+        return route;
+    }
+
+public:
+    // threadCount = 0 uses every hardware thread
+    CommuteRouter(shared_ptr<const StreetNetwork> streets, size_t threadCount = 0)
+        : network(streets), hierarchy(*streets), pool(threadCount), cacheHits(0), cacheMisses(0) {}
+
+    // Whether trips by this transport type follow the streets (rail and air travel do not)
+    static bool usesStreets(const string& transportType) {
+        return transportType != "Train" && transportType != "Plane";
+    }
+
+    /**
+     * Route a batch of (origin, destination) trips. Addresses off the network
+     * give a route that is not found. Identical trips share one cached route.
+     */
+    vector<shared_ptr<const CommuteRoute>> route(const vector<pair<Address, Address>>& trips) {
+        static const shared_ptr<const CommuteRoute> unreachable = make_shared<const CommuteRoute>(CommuteRoute{false, 0.0, {}});
+        vector<shared_ptr<const CommuteRoute>> routes(trips.size(), unreachable);
+
+        vector<RouteKey> keys(trips.size());
+        vector<char> onNetwork(trips.size(), 0);
+        for (size_t i = 0; i < trips.size(); i++) {
+            size_t a = network->segmentOf(trips[i].first), b = network->segmentOf(trips[i].second);
+            if (a == StreetNetwork::NONE || b == StreetNetwork::NONE) continue;
+            keys[i] = {uint32_t(a), trips[i].first.houseNo, uint32_t(b), trips[i].second.houseNo};
+            onNetwork[i] = 1;
+        }
+
+        // Look everything up under one lock and collect the distinct misses
+        unordered_map<RouteKey, size_t, RouteKeyHash> missIndex;
+        vector<RouteKey> misses;
+        {
+            lock_guard<mutex> lock(cacheLock);
+            for (size_t i = 0; i < trips.size(); i++) {
+                if (!onNetwork[i]) continue;
+                auto hit = cache.find(keys[i]);
+                if (hit != cache.end()) {
+                    routes[i] = hit->second;
+                    cacheHits++;
+                } else if (missIndex.emplace(keys[i], misses.size()).second) {
+                    misses.push_back(keys[i]);
+                }
+            }
+            cacheMisses += misses.size();
+        }
+
+        vector<shared_ptr<const CommuteRoute>> computed(misses.size());
+        pool.parallelFor(0, misses.size(), [&](size_t first, size_t last) {
+            ContractionHierarchy::Workspace work(hierarchy.getNodeCount());
+            for (size_t m = first; m < last; m++) {
+                computed[m] = make_shared<const CommuteRoute>(compute(misses[m], work));
+            }
+        }, 256);
+
+        {
+            lock_guard<mutex> lock(cacheLock);
+            for (size_t m = 0; m < misses.size(); m++) {
+                cache.emplace(misses[m], computed[m]);
+            }
+        }
+        for (size_t i = 0; i < trips.size(); i++) {
+            if (!onNetwork[i]) continue;
+            auto miss = missIndex.find(keys[i]);
+            if (miss != missIndex.end()) routes[i] = computed[miss->second];
+        }
+        return routes;
+    }
+
+    size_t getCacheSize() {
+        lock_guard<mutex> lock(cacheLock);
+        return cache.size();
+    }
+
+    size_t getCacheHits() {
+        lock_guard<mutex> lock(cacheLock);
+        return cacheHits;
+    }
+
+    size_t getCacheMisses() {
+        lock_guard<mutex> lock(cacheLock);
+        return cacheMisses;
+    }
+
+    void clearCache() {
+        lock_guard<mutex> lock(cacheLock);
+        cache.clear();
+    }
+
+    const ContractionHierarchy& getHierarchy() const { return hierarchy; }
+};
+
+#endif // COMMUTEROUTER_H
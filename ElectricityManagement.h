@@ -63,22 +63,23 @@ public:
         return tariff.baseCost + (totalUsageKWh * tariff.pricePerUnit);
     }
 
-    // Calculate carbon footprint
-    double calculateCarbonFootprint() const {
+    // Carbon emission factor for standard grid electricity (kg CO2 per kWh)
+    static constexpr double STANDARD_EMISSION_FACTOR = 0.5;
+
+    // Emissions per kWh drawn under the current plan
+    double getEmissionFactor() const {
         if (currentPlan == ElectricityPlan::NO_SERVICE) {
             return 0.0;
         }
         
-        // Get renewable percentage
-        double renewable = planDetails[currentPlan].renewablePercentage;
-        
-        // Carbon emission factor for standard grid electricity (kg CO2 per kWh)
-        const double STANDARD_EMISSION_FACTOR = 0.5;
-        
         // Adjust based on renewable percentage
-        double emissionFactor = STANDARD_EMISSION_FACTOR * (1.0 - renewable / 100.0);
-        
-        return totalUsageKWh * emissionFactor;
+        double renewable = planDetails[currentPlan].renewablePercentage;
+        return STANDARD_EMISSION_FACTOR * (1.0 - renewable / 100.0);
+    }
+
+    // Calculate carbon footprint
+    double calculateCarbonFootprint() const {
+        return totalUsageKWh * getEmissionFactor();
     }
 
     // --- Getters ---
@@ -86,6 +87,7 @@ public:
     double getTotalUsageKWh() const { return totalUsageKWh; }
     ElectricityPlan getCurrentPlan() const { return currentPlan; }
     string getPlanName() const { return planDetails[currentPlan].displayName; }
+    static const ElectricityTariff& getTariffDetails(ElectricityPlan plan) { return planDetails.at(plan); }
 
     // --- Setters ---
     void setCurrentPlan(ElectricityPlan newPlan) {
@@ -120,6 +122,12 @@ public:
         cout << "-------------------------" << endl;
     }
 
+    const Address* getServiceAddress() const override { return &address; }
+
+    unique_ptr<Services> clone() const override {
+        return make_unique<ElectricityManagement>(*this);
+    }
+
     virtual ~ElectricityManagement() override = default;
 };
 
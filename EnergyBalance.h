@@ -0,0 +1,193 @@
+#ifndef ENERGYBALANCE_H
+#define ENERGYBALANCE_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <iostream>
+#include <unordered_map>
+#include <algorithm>
+
+#include "buildings.h"
+#include "HousingScheme.h"
+#include "Services.h"
+#include "ElectricityManagement.h"
+#include "HourlyProfiles.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+/**
+ * Energy balance of one district (all entities sharing a pin code) for one day
+ */
+struct DistrictEnergy {
+    string district;                       // pin code, empty for entities without an address
+    double demandKWh;                      // commercial building consumption
+    double generationKWh;                  // on-site solar (green buildings, apartment rooftops)
+    double gridImportKWh;
+    double exportKWh;
+    double importCarbonKg;
+    double unmeteredKWh;                   // import drawn with no active electricity account in the district
+    vector<size_t> accounts;               // service indices of the district's active electricity accounts
+    double hourlyImportKWh[HOURS_PER_DAY]; // filled when the balance is computed hour by hour
+};
+
+struct EnergyReport {
+    int day;
+    bool hourly;
+    vector<DistrictEnergy> districts;
+
+    double totalDemand() const { return total(&DistrictEnergy::demandKWh); }
+    double totalGeneration() const { return total(&DistrictEnergy::generationKWh); }
+    double totalImport() const { return total(&DistrictEnergy::gridImportKWh); }
+    double totalExport() const { return total(&DistrictEnergy::exportKWh); }
+    double totalImportCarbon() const { return total(&DistrictEnergy::importCarbonKg); }
+
+    void display() const {
+        cout << "\n===== ENERGY BALANCE FOR DAY " << day << (hourly ? " (hourly)" : "") << " =====" << endl;
+        for (const auto& d : districts) {
+            cout << "District " << (d.district.empty() ? "(unassigned)" : d.district)
+                 << ": demand " << d.demandKWh << " kWh, generation " << d.generationKWh
+                 << " kWh, import " << d.gridImportKWh << " kWh, export " << d.exportKWh
+                 << " kWh, import carbon " << d.importCarbonKg << " kg CO2";
+            if (d.unmeteredKWh > 0) cout << " (" << d.unmeteredKWh << " kWh unmetered)";
+            cout << endl;
+        }
+        cout << "City total: import " << totalImport() << " kWh, export " << totalExport()
+             << " kWh, carbon " << totalImportCarbon() << " kg CO2" << endl;
+        cout << "=============================================" << endl;
+    }
+
+private:
+    double total(double DistrictEnergy::*field) const {
+        double sum = 0.0;
+        for (const auto& d : districts) sum += d.*field;
+        return sum;
+    }
+};
+
+/**
+ * Nets building demand against on-site generation per district.
+ * Entities are first flattened into contiguous arrays (district index, demand,
+ * generation), then reduced in fixed-size chunks on a thread pool; the chunk
+ * partials are merged in chunk order so the result does not depend on thread
+ * timing. compute() keeps no state between calls, so one engine can serve
+ * several cities (e.g. forks) at once.
+ */
+class EnergyBalance {
+private:
+    ThreadPool pool;
+
+    static constexpr double SOLAR_PEAK_HOURS = 5.0;              // kWh per kW of panel per day
+    static constexpr double APARTMENT_SOLAR_KWH_PER_UNIT = 4.0;  // rooftop share of each apartment per day
+    static constexpr size_t CHUNK_SIZE = 4096;
+
+    struct Entities {
+        vector<size_t> district;
+        vector<double> demand;
+        vector<double> generation;
+    };
+
+    static size_t districtIndex(const string& pin, unordered_map<string, size_t>& index, vector<DistrictEnergy>& districts) {
+        auto inserted = index.emplace(pin, districts.size());
+        if (inserted.second) {
+            DistrictEnergy d{};
+            d.district = pin;
+            districts.push_back(d);
+        }
+        return inserted.first->second;
+    }
+
+public:
+    // threadCount = 0 uses every hardware thread
+    explicit EnergyBalance(size_t threadCount = 0) : pool(threadCount) {}
+
+    // demandProfile == nullptr nets whole days; otherwise demand follows the profile,
+    // generation follows the solar curve and import/export are netted hour by hour
+    EnergyReport compute(int day,
+                         const vector<shared_ptr<Building>>& buildings,
+                         const vector<shared_ptr<HousingScheme>>& housing,
+                         const vector<shared_ptr<Services>>& services,
+                         const HourlyProfile* demandProfile = nullptr) {
+        EnergyReport report;
+        report.day = day;
+        report.hourly = (demandProfile != nullptr);
+
+        unordered_map<string, size_t> index;
+        Entities entities;
+        entities.district.reserve(buildings.size() + housing.size());
+        entities.demand.reserve(buildings.size() + housing.size());
+        entities.generation.reserve(buildings.size() + housing.size());
+
+        for (const auto& building : buildings) {
+            double demand = 0.0, generation = 0.0;
+            if (auto* commercial = dynamic_cast<const CommercialBuilding*>(building.get())) {
+                demand = commercial->getEnergyUsage();
+            } else if (auto* green = dynamic_cast<const GreenBuilding*>(building.get())) {
+                generation = green->getSolarOutput() * SOLAR_PEAK_HOURS;
+            } else {
+                continue;
+            }
+            entities.district.push_back(districtIndex(building->getAddress().pin, index, report.districts));
+            entities.demand.push_back(demand);
+            entities.generation.push_back(generation);
+        }
+        for (const auto& scheme : housing) {
+            auto* apartments = dynamic_cast<const ApartmentComplex*>(scheme.get());
+            if (!apartments || !apartments->getHasSolarPanels()) continue;
+            entities.district.push_back(districtIndex(scheme->getLocation().pin, index, report.districts));
+            entities.demand.push_back(0.0);
+            entities.generation.push_back(apartments->getTotalUnits() * APARTMENT_SOLAR_KWH_PER_UNIT);
+        }
+
+        // Accounts only draw from the grid while they have a plan
+        for (size_t i = 0; i < services.size(); i++) {
+            auto* account = dynamic_cast<const ElectricityManagement*>(services[i].get());
+            if (!account || account->getCurrentPlan() == ElectricityPlan::NO_SERVICE) continue;
+            report.districts[districtIndex(account->getAddress().pin, index, report.districts)].accounts.push_back(i);
+        }
+
+        // Parallel reduction: one partial (demand, generation) pair per district and chunk
+        size_t count = entities.district.size();
+        size_t districtCount = report.districts.size();
+        size_t chunks = (count + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        vector<double> partials(chunks * districtCount * 2, 0.0);
+        pool.parallelFor(0, chunks, [&](size_t firstChunk, size_t lastChunk) {
+            for (size_t c = firstChunk; c < lastChunk; c++) {
+                double* partial = partials.data() + c * districtCount * 2;
+                size_t end = min(count, (c + 1) * CHUNK_SIZE);
+                for (size_t i = c * CHUNK_SIZE; i < end; i++) {
+                    partial[entities.district[i] * 2] += entities.demand[i];
+                    partial[entities.district[i] * 2 + 1] += entities.generation[i];
+                }
+            }
+        });
+        for (size_t c = 0; c < chunks; c++) {
+            const double* partial = partials.data() + c * districtCount * 2;
+            for (size_t d = 0; d < districtCount; d++) {
+                report.districts[d].demandKWh += partial[d * 2];
+                report.districts[d].generationKWh += partial[d * 2 + 1];
+            }
+        }
+
+        // Net demand against generation
+        HourlyProfile solar = HourlyProfile::solar();
+        for (auto& d : report.districts) {
+            if (demandProfile) {
+                for (int h = 0; h < HOURS_PER_DAY; h++) {
+                    double net = d.demandKWh * demandProfile->share[h] - d.generationKWh * solar.share[h];
+                    d.hourlyImportKWh[h] = max(0.0, net);
+                    d.gridImportKWh += max(0.0, net);
+                    d.exportKWh += max(0.0, -net);
+                }
+            } else {
+                double net = d.demandKWh - d.generationKWh;
+                d.gridImportKWh = max(0.0, net);
+                d.exportKWh = max(0.0, -net);
+            }
+        }
+        return report;
+    }
+};
+
+#endif // ENERGYBALANCE_H
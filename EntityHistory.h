@@ -0,0 +1,248 @@
+#ifndef ENTITYHISTORY_H
+#define ENTITYHISTORY_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+// Per-entity values a city can keep the daily history of
+enum class HistoryField : uint8_t {
+    CITIZEN_ECO_SCORE = 0,
+    CITIZEN_ECO_AWARENESS,
+    BUILDING_ECO_IMPACT,
+    COUNT
+};
+
+struct HistoryFieldInfo {
+    const char* name;
+    double resolution;   // values are stored as whole multiples of this
+};
+
+inline const HistoryFieldInfo& historyFieldInfo(HistoryField field) {
+    static const HistoryFieldInfo table[] = {
+        {"citizen_eco_score", 0.01},
+        {"citizen_eco_awareness", 0.0001},
+        {"building_eco_impact", 0.01},
+    };
+    return table[static_cast<size_t>(field)];
+}
+
+// Daily values of one entity, starting at firstDay
+struct HistorySeries {
+    int firstDay;
+    vector<double> values;
+};
+
+/**
+ * Daily history of one value per entity, for entities that are only ever appended.
+ * Values are rounded to a fixed resolution. The open block of DAY_BLOCK days
+ * is kept as plain integers. Once full, it is sealed into one chunk per
+ * ENTITY_BLOCK entities.
+ *
+ * In a chunk, each entity's first value is packed as an offset from the
+ * chunk minimum. Its day-to-day changes follow as zigzag deltas. All values
+ * in a chunk share one bit width, so an entity's bits start at a computed
+ * position. A query for one entity therefore unpacks DAY_BLOCK values per
+ * chunk, and only from the chunks its day range touches. Slowly changing
+ * values take a few bits a day.
+ */
+class EntityHistory {
+public:
+    static constexpr size_t DAY_BLOCK = 16;
+    static constexpr size_t ENTITY_BLOCK = 1024;
+
+private:
+    struct Chunk {
+        int64_t baseMin;
+        uint8_t baseWidth;
+        uint8_t deltaWidth;
+        uint32_t entities;
+        vector<uint64_t> bits;   // bases of every entity, then each entity's deltas
+    };
+
+    double resolution;
+    int startDay;
+    size_t recordedDays;
+    vector<int> firstDay;                  // entity -> first day recorded
+    vector<int32_t> open;                  // entity-major: open[entity * DAY_BLOCK + slot]
+    vector<vector<Chunk>> sealed;          // day block -> entity block -> chunk
+
+    int32_t quantize(double value) const {
+        double q = nearbyint(value / resolution);
+        if (!(q == q)) return 0;   // NaN
+        q = max(q, double(numeric_limits<int32_t>::min()));
+        q = min(q, double(numeric_limits<int32_t>::max()));
+        return static_cast<int32_t>(q);
+    }
+
+    static uint64_t zigzag(int64_t v) { return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63); }
+    static int64_t unzigzag(uint64_t v) { return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1); }
+
+    static uint8_t bitWidth(uint64_t v) {
+        uint8_t width = 0;
+        while (v) {
+            width++;
+            v >>= 1;
+        }
+        return width;
+    }
+
+    static void putBits(vector<uint64_t>& words, uint64_t position, uint64_t value, unsigned width) {
+        if (width == 0) return;
+        size_t word = position >> 6;
+        unsigned shift = position & 63;
+        words[word] |= value << shift;
+        if (shift + width > 64) words[word + 1] |= value >> (64 - shift);
+    }
+
+    static uint64_t getBits(const vector<uint64_t>& words, uint64_t position, unsigned width) {
+        if (width == 0) return 0;
+        size_t word = position >> 6;
+        unsigned shift = position & 63;
+        uint64_t value = words[word] >> shift;
+        if (shift + width > 64) value |= words[word + 1] << (64 - shift);
+        return width == 64 ? value : value & ((uint64_t(1) << width) - 1);
+    }
+
+    // Pack the open block into chunks; days is the number of slots filled
+    void seal(size_t days) {
+        size_t entities = firstDay.size();
+        vector<Chunk> block;
+        for (size_t first = 0; first < entities; first += ENTITY_BLOCK) {
+            size_t count = min(ENTITY_BLOCK, entities - first);
+            Chunk chunk{numeric_limits<int64_t>::max(), 0, 0, static_cast<uint32_t>(count), {}};
+            int64_t baseMax = numeric_limits<int64_t>::min();
+            uint64_t deltaMax = 0;
+            for (size_t e = first; e < first + count; e++) {
+                const int32_t* row = &open[e * DAY_BLOCK];
+                chunk.baseMin = min(chunk.baseMin, int64_t(row[0]));
+                baseMax = max(baseMax, int64_t(row[0]));
+                for (size_t d = 1; d < days; d++) deltaMax = max(deltaMax, zigzag(int64_t(row[d]) - row[d - 1]));
+            }
+            chunk.baseWidth = bitWidth(static_cast<uint64_t>(baseMax - chunk.baseMin));
+            chunk.deltaWidth = bitWidth(deltaMax);
+
+            uint64_t deltaStart = uint64_t(count) * chunk.baseWidth;
+            uint64_t totalBits = deltaStart + uint64_t(count) * (days - 1) * chunk.deltaWidth;
+            chunk.bits.assign((totalBits + 63) / 64 + 1, 0);   // one spare word for straddling reads
+            for (size_t i = 0; i < count; i++) {
+                const int32_t* row = &open[(first + i) * DAY_BLOCK];
+                putBits(chunk.bits, i * chunk.baseWidth, static_cast<uint64_t>(row[0] - chunk.baseMin), chunk.baseWidth);
+                uint64_t position = deltaStart + uint64_t(i) * (days - 1) * chunk.deltaWidth;
+                for (size_t d = 1; d < days; d++, position += chunk.deltaWidth) {
+                    putBits(chunk.bits, position, zigzag(int64_t(row[d]) - row[d - 1]), chunk.deltaWidth);
+                }
+            }
+            chunk.bits.shrink_to_fit();
+            block.push_back(move(chunk));
+        }
+        sealed.push_back(move(block));
+    }
+
+    // Values of one entity in a sealed day block, slots [from, to)
+    void unpack(size_t dayBlock, size_t entity, size_t from, size_t to, vector<double>& out) const {
+        const Chunk& chunk = sealed[dayBlock][entity / ENTITY_BLOCK];
+        size_t i = entity % ENTITY_BLOCK;
+        size_t days = blockDays(dayBlock);
+        int64_t value = chunk.baseMin + static_cast<int64_t>(getBits(chunk.bits, i * chunk.baseWidth, chunk.baseWidth));
+        uint64_t position = uint64_t(chunk.entities) * chunk.baseWidth + uint64_t(i) * (days - 1) * chunk.deltaWidth;
+        for (size_t d = 0; d < to; d++) {
+            if (d > 0) {
+                value += unzigzag(getBits(chunk.bits, position, chunk.deltaWidth));
+                position += chunk.deltaWidth;
+            }
+            if (d >= from) out.push_back(value * resolution);
+        }
+    }
+
+    size_t blockDays(size_t dayBlock) const {
+        return min(DAY_BLOCK, recordedDays - dayBlock * DAY_BLOCK);
+    }
+
+public:
+    explicit EntityHistory(double valueResolution) : resolution(valueResolution), startDay(0), recordedDays(0) {
+        if (!(valueResolution > 0)) {
+            throw invalid_argument("History resolution must be positive");
+        }
+    }
+
+    /**
+     * Record day's value of entities [0, count); valueOf(entity) gives the value.
+     * Days must follow each other. An entity first seen partway through a
+     * block is back-filled with its first value, but queries start at the
+     * day it joined.
+     */
+    template<typename ValueOf>
+    void record(int day, size_t count, const ValueOf& valueOf) {
+        if (recordedDays == 0) {
+            startDay = day;
+        } else if (day != startDay + static_cast<int>(recordedDays)) {
+            throw invalid_argument("History days must be recorded one after another");
+        }
+        if (count < firstDay.size()) {
+            throw invalid_argument("Entities cannot leave a history");
+        }
+
+        size_t slot = recordedDays % DAY_BLOCK;
+        size_t known = firstDay.size();
+        firstDay.resize(count, day);
+        open.resize(count * DAY_BLOCK);
+        for (size_t e = 0; e < count; e++) {
+            int32_t value = quantize(valueOf(e));
+            int32_t* row = &open[e * DAY_BLOCK];
+            if (e >= known) fill(row, row + slot, value);
+            row[slot] = value;
+        }
+
+        recordedDays++;
+        if (slot == DAY_BLOCK - 1) seal(DAY_BLOCK);
+    }
+
+    // Daily values of entity over [fromDay, toDay], clamped to the days it was recorded
+    HistorySeries getSeries(size_t entity, int fromDay = numeric_limits<int>::min(),
+                            int toDay = numeric_limits<int>::max()) const {
+        if (entity >= firstDay.size()) {
+            throw out_of_range("Entity has no history");
+        }
+        int lastDay = startDay + static_cast<int>(recordedDays) - 1;
+        HistorySeries series{max(fromDay, firstDay[entity]), {}};
+        int until = min(toDay, lastDay);
+        if (series.firstDay > until) return series;
+
+        size_t from = series.firstDay - startDay, to = until - startDay + 1;   // day offsets, [from, to)
+        series.values.reserve(to - from);
+        for (size_t block = from / DAY_BLOCK; block * DAY_BLOCK < to; block++) {
+            size_t begin = block * DAY_BLOCK;
+            size_t first = max(from, begin) - begin, last = min(to, begin + DAY_BLOCK) - begin;
+            if (block < sealed.size()) {
+                unpack(block, entity, first, last, series.values);
+            } else {
+                const int32_t* row = &open[entity * DAY_BLOCK];
+                for (size_t d = first; d < last; d++) series.values.push_back(row[d] * resolution);
+            }
+        }
+        return series;
+    }
+
+    size_t getEntityCount() const { return firstDay.size(); }
+    size_t getRecordedDays() const { return recordedDays; }
+    int getStartDay() const { return startDay; }
+    double getResolution() const { return resolution; }
+
+    // Bytes held by sealed chunks and by the open block
+    size_t getMemoryUsage() const {
+        size_t bytes = open.capacity() * sizeof(int32_t) + firstDay.capacity() * sizeof(int);
+        for (const auto& block : sealed) {
+            for (const Chunk& chunk : block) bytes += sizeof(Chunk) + chunk.bits.capacity() * sizeof(uint64_t);
+        }
+        return bytes;
+    }
+};
+
+#endif // ENTITYHISTORY_H
@@ -0,0 +1,130 @@
+#ifndef EVENTSCHEDULER_H
+#define EVENTSCHEDULER_H
+
+#include <vector>
+#include <queue>
+#include <stdexcept>
+#include <cstdint>
+
+using namespace std;
+
+enum class CityEventType {
+    COMMUTE,          // a citizen makes a trip of `amount` km
+    SERVICE_OUTAGE,   // a service goes down for `amount` minutes
+    SERVICE_RESTORE,  // a service comes back after an outage of `amount` minutes
+    POLLUTION_SPIKE   // `amount` units are released into one pollution level
+};
+
+enum class PollutionKind {
+    AIR,
+    WATER,
+    NOISE,
+    SOLID_WASTE
+};
+
+/**
+ * A timestamped event aimed at one entity of the city
+ */
+struct CityEvent {
+    static const int MINUTES_PER_DAY = 1440;
+
+    long long time;      // minutes since the start of the simulation (day 1 starts at 0)
+    CityEventType type;
+    size_t target;       // citizen or service index, or the PollutionKind of a spike
+    double amount;
+    double cost;         // charged to the city budget when the event fires
+
+    // Minute at which the given day, hour and minute start
+    static long long at(int day, int hour, int minute = 0) {
+        return static_cast<long long>(day - 1) * MINUTES_PER_DAY + hour * 60 + minute;
+    }
+
+    static CityEvent commute(long long time, size_t citizen, double km) {
+        return {time, CityEventType::COMMUTE, citizen, km, 0.0};
+    }
+
+    static CityEvent serviceOutage(long long time, size_t service, double minutes, double repairCost = 0.0) {
+        return {time, CityEventType::SERVICE_OUTAGE, service, minutes, repairCost};
+    }
+
+    static CityEvent pollutionSpike(long long time, PollutionKind kind, double amount, double cleanupCost = 0.0) {
+        return {time, CityEventType::POLLUTION_SPIKE, static_cast<size_t>(kind), amount, cleanupCost};
+    }
+};
+
+/**
+ * Timer-wheel event queue with one-minute resolution.
+ * The wheel holds the current day with one slot per minute; events further
+ * ahead wait in an overflow heap and are moved onto the wheel when their day
+ * comes round. Events at the same minute fire in the order they were scheduled.
+ */
+class EventScheduler {
+private:
+    struct PendingEvent {
+        CityEvent event;
+        uint64_t sequence;
+
+        // Min-heap on (time, sequence)
+        bool operator<(const PendingEvent& other) const {
+            if (event.time != other.event.time) return event.time > other.event.time;
+            return sequence > other.sequence;
+        }
+    };
+
+    vector<vector<CityEvent>> wheel;
+    long long wheelStart;     // first minute covered by the wheel
+    int cursor;               // slot being processed, events may not be scheduled before it
+    priority_queue<PendingEvent> overflow;
+    size_t pendingCount;
+    uint64_t nextSequence;
+
+public:
+    EventScheduler()
+        : wheel(CityEvent::MINUTES_PER_DAY), wheelStart(0), cursor(0), pendingCount(0), nextSequence(0) {}
+
+    void schedule(const CityEvent& event) {
+        if (event.time < wheelStart + cursor) {
+            throw invalid_argument("Cannot schedule an event in the past");
+        }
+
+        if (event.time < wheelStart + CityEvent::MINUTES_PER_DAY) {
+            wheel[event.time - wheelStart].push_back(event);
+        } else {
+            overflow.push({event, nextSequence++});
+        }
+        pendingCount++;
+    }
+
+    // Fire every event of the current day in time order, then move on to the next day.
+    // The handler may schedule further events, including later the same day.
+    template<typename Handler>
+    size_t runDay(Handler handler) {
+        size_t fired = 0;
+        for (cursor = 0; cursor < CityEvent::MINUTES_PER_DAY; cursor++) {
+            vector<CityEvent>& slot = wheel[cursor];
+            // Indexed loop: the handler may append to this slot
+            for (size_t i = 0; i < slot.size(); i++) {
+                CityEvent event = slot[i];
+                pendingCount--;
+                fired++;
+                handler(event);
+            }
+            slot.clear();
+        }
+
+        // Roll the wheel over to the next day
+        cursor = 0;
+        wheelStart += CityEvent::MINUTES_PER_DAY;
+        while (!overflow.empty() && overflow.top().event.time < wheelStart + CityEvent::MINUTES_PER_DAY) {
+            const CityEvent& event = overflow.top().event;
+            wheel[event.time - wheelStart].push_back(event);
+            overflow.pop();
+        }
+        return fired;
+    }
+
+    size_t getPendingCount() const { return pendingCount; }
+    long long getCurrentDayStart() const { return wheelStart; }
+};
+
+#endif // EVENTSCHEDULER_H
@@ -12,13 +12,17 @@ class GasManagement : public Services {
 private:
     Address address;          
     double totalConsumption;  // Total gas consumed in cubic meters (m³)
+    double supplyPressure;    // kPa at this address from the last network solve (negative if unknown)
+    bool lowPressure;
     static double gridUnitPrice;
 
 public:
     GasManagement(Address ad, double initialConsumption = 0.0)
         : Services("Gas"), 
         address(ad),
-        totalConsumption(initialConsumption)
+        totalConsumption(initialConsumption),
+        supplyPressure(-1.0),
+        lowPressure(false)
     {
         if (initialConsumption < 0) {
             throw invalid_argument("Initial gas consumption cannot be negative.");
@@ -46,8 +50,16 @@ public:
     const Address& getAddress() const { return address; }
     double getTotalConsumption() const { return totalConsumption; }
     static double getGridUnitPrice() { return gridUnitPrice; } // Static getter
+    double getSupplyPressure() const { return supplyPressure; }
+    bool isLowPressure() const { return lowPressure; }
 
     // --- Setters (Mutators) ---
+    // Set by the gas network after each pressure solve
+    void setSupplyPressure(double kPa, bool belowMinimum) {
+        supplyPressure = kPa;
+        lowPressure = belowMinimum;
+    }
+
     static void SetGridUnitPrice(double newPrice) {
         if (newPrice < 0) {
             throw invalid_argument("Gas unit price cannot be negative.");
@@ -58,8 +70,13 @@ public:
     // --- Overridden Virtual Functions ---
     void supply() override {
         std::cout << "Managing Gas supply for address: [" << address << "]" << std::endl;
-        // Future logic could involve checking grid availability, pressure, etc.
-        std::cout << "   Status: Grid connection active. Current consumption rate implies stable supply." << std::endl;
+        if (supplyPressure < 0) {
+            std::cout << "   Status: Grid connection active. Current consumption rate implies stable supply." << std::endl;
+        } else if (lowPressure) {
+            std::cout << "   Status: LOW PRESSURE (" << supplyPressure << " kPa). Supply may be interrupted." << std::endl;
+        } else {
+            std::cout << "   Status: Grid connection active at " << supplyPressure << " kPa. Stable supply." << std::endl;
+        }
     }
 
     // Displays the current status of the gas service for this address.
@@ -67,10 +84,19 @@ public:
         std::cout << "--- Gas Status for Address: [" << address << "] ---" << std::endl;
         std::cout << "   Total Consumption This Period: " << totalConsumption << " m³" << std::endl;
         std::cout << "   Grid Unit Price: $" << gridUnitPrice << "/m³" << std::endl;
+        if (supplyPressure >= 0) {
+            std::cout << "   Supply Pressure: " << supplyPressure << " kPa" << (lowPressure ? " (LOW)" : "") << std::endl;
+        }
         std::cout << "   Estimated Grid Bill: $" << calculateBill() << std::endl;
         std::cout << "-------------------------------------------" << std::endl;
     }
 
+    const Address* getServiceAddress() const override { return &address; }
+
+    unique_ptr<Services> clone() const override {
+        return make_unique<GasManagement>(*this);
+    }
+
     // --- Virtual Destructor ---
     virtual ~GasManagement() override = default; 
 };
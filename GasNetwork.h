@@ -0,0 +1,108 @@
+#ifndef GASNETWORK_H
+#define GASNETWORK_H
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <unordered_map>
+#include <limits>
+#include <algorithm>
+
+#include "Address.h"
+#include "PipeNetwork.h"
+
+using namespace std;
+
+struct GasNetworkReport {
+    int day;
+    double totalDemand;                  // m^3 drawn since the previous tick
+    double lowestPressure;               // kPa, over all supplied nodes that are not stations
+    vector<string> lowPressureNodes;     // below the minimum pressure or cut off from every station
+    SolveResult solver;
+
+    void display() const {
+        cout << "\n===== GAS NETWORK FOR DAY " << day << " =====" << endl;
+        cout << "Demand: " << totalDemand << " m^3, lowest pressure: " << lowestPressure << " kPa" << endl;
+        cout << "Solved in " << solver.iterations << " iterations" << (solver.converged ? "" : " (not converged)") << endl;
+        if (lowPressureNodes.empty()) {
+            cout << "All addresses above minimum pressure" << endl;
+        } else {
+            cout << lowPressureNodes.size() << " addresses below minimum pressure:" << endl;
+            for (const auto& node : lowPressureNodes) {
+                cout << "   [" << node << "]" << endl;
+            }
+        }
+        cout << "=============================================" << endl;
+    }
+};
+
+/**
+ * Gas distribution pipes between supply stations, junctions and service addresses.
+ * Pressure drop along a pipe is linearised (flow = conductance * pressure
+ * difference) so each tick is one sparse solve; the previous tick's pressures
+ * are the starting guess, which keeps day-to-day solves short.
+ */
+class GasNetwork : public PipeNetwork {
+private:
+    double minimumPressure;
+
+public:
+    explicit GasNetwork(double minimumPressureKPa = 2.0) : minimumPressure(minimumPressureKPa) {}
+
+    static string nodeKey(const Address& address) { return address.display(false); }
+
+    size_t addSupplyStation(const string& name, double pressureKPa) { return addSource(name, pressureKPa); }
+
+    // conductance in m^3/day per kPa of pressure difference
+    void addMain(const string& from, const string& to, double conductance) { addPipe(from, to, conductance); }
+    void connect(const Address& address, const string& junction, double conductance) {
+        addPipe(nodeKey(address), junction, conductance);
+    }
+    void addServicePipe(const Address& from, const Address& to, double conductance) {
+        addPipe(nodeKey(from), nodeKey(to), conductance);
+    }
+
+    double getMinimumPressure() const { return minimumPressure; }
+
+    // Pressure at an address after the last solve (0 if it is cut off or was never solved)
+    double getPressure(const Address& address) const {
+        size_t node = getNode(nodeKey(address));
+        return node < heads.size() ? heads[node] : 0.0;
+    }
+
+    // Solve one tick; addressDemand is keyed by nodeKey(). Addresses missing
+    // from the network are added unconnected and reported as low pressure.
+    GasNetworkReport simulate(int day, const unordered_map<string, double>& addressDemand, double tolerance = 1e-6) {
+        for (const auto& entry : addressDemand) addNode(entry.first);
+
+        vector<double> draw(getNodeCount(), 0.0);
+        for (const auto& entry : addressDemand) {
+            draw[getNode(entry.first)] = entry.second;
+        }
+        return simulate(day, draw, tolerance);
+    }
+
+    // Solve one tick with the demand given per node index (no key lookups, for large networks)
+    GasNetworkReport simulate(int day, const vector<double>& nodeDemand, double tolerance = 1e-6) {
+        GasNetworkReport report{};
+        report.day = day;
+
+        Solution solution = solve(nodeDemand, tolerance);
+        report.solver = solution.stats;
+
+        report.lowestPressure = numeric_limits<double>::infinity();
+        for (size_t node = 0; node < getNodeCount(); node++) {
+            if (getIsSource(node)) continue;
+            report.totalDemand += nodeDemand[node];
+            if (solution.supplied[node]) {
+                report.lowestPressure = min(report.lowestPressure, solution.head[node]);
+            }
+            if (!solution.supplied[node] || solution.head[node] < minimumPressure) {
+                report.lowPressureNodes.push_back(nodeNames[node]);
+            }
+        }
+        return report;
+    }
+};
+
+#endif // GASNETWORK_H
@@ -10,6 +10,13 @@
 
 using namespace std;
 
+// Concrete kind of a housing scheme, so tallies need no dynamic_cast chain
+enum class HousingKind {
+    GENERIC,
+    APARTMENT,
+    VILLA
+};
+
 // Forward declarations
 class PollutionControl;
 class City;
@@ -112,6 +119,13 @@ public:
         cout << "Average Pollution Level: " << getAveragePollution() << endl;
     }
 
+    virtual HousingKind getKind() const { return HousingKind::GENERIC; }
+
+    // Virtual copy constructor
+    virtual unique_ptr<HousingScheme> clone() const {
+        return make_unique<HousingScheme>(*this);
+    }
+
     // Declare PollutionControl as friend class
     friend class PollutionControl;
     friend class City;
@@ -152,6 +166,12 @@ public:
         cout << "Elevator: " << (hasElevator ? "Yes" : "No") << endl;
         cout << "Solar Panels: " << (hasSolarPanels ? "Yes" : "No") << endl;
     }
+
+    HousingKind getKind() const override { return HousingKind::APARTMENT; }
+
+    unique_ptr<HousingScheme> clone() const override {
+        return make_unique<ApartmentComplex>(*this);
+    }
 };
 
 // Villa complex derived class
@@ -189,6 +209,12 @@ public:
         cout << "Swimming Pool: " << (hasSwimmingPool ? "Yes" : "No") << endl;
         cout << "Green Space: " << (hasGreenSpace ? "Yes" : "No") << endl;
     }
+
+    HousingKind getKind() const override { return HousingKind::VILLA; }
+
+    unique_ptr<HousingScheme> clone() const override {
+        return make_unique<VillaComplex>(*this);
+    }
 };
 
 #endif // HOUSINGSCHEME_H
\ No newline at end of file
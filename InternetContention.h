@@ -0,0 +1,145 @@
+#ifndef INTERNETCONTENTION_H
+#define INTERNETCONTENTION_H
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <stdexcept>
+
+#include "Address.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+// Busy-hour load of one neighborhood's shared backhaul
+struct NeighborhoodLoad {
+    string neighborhood;
+    double capacityMbps;
+    double demandMbps;
+    double allocatedMbps;
+    double fairShareMbps;    // water level: subscribers demanding more than this get exactly this
+    size_t subscribers;
+
+    bool isCongested() const { return demandMbps > capacityMbps; }
+};
+
+struct ContentionReport {
+    int day;
+    vector<NeighborhoodLoad> neighborhoods;
+
+    size_t getCongestedCount() const {
+        size_t count = 0;
+        for (const auto& n : neighborhoods) if (n.isCongested()) count++;
+        return count;
+    }
+
+    void display() const {
+        cout << "\n===== INTERNET CONTENTION FOR DAY " << day << " =====" << endl;
+        for (const auto& n : neighborhoods) {
+            cout << "Neighborhood " << n.neighborhood << ": " << n.subscribers << " subscribers, demand "
+                 << n.demandMbps << " / " << n.capacityMbps << " Mbps";
+            if (n.isCongested()) cout << " CONGESTED, fair share " << n.fairShareMbps << " Mbps";
+            cout << endl;
+        }
+        cout << getCongestedCount() << " of " << neighborhoods.size() << " neighborhoods congested" << endl;
+        cout << "=============================================" << endl;
+    }
+};
+
+/**
+ * Max-min fair sharing of neighborhood backhaul capacity.
+ * Within a neighborhood every subscriber gets min(demand, level), where the
+ * level is the largest value that fits the capacity. The level is found by
+ * repeated partitioning around a median (quickselect) rather than sorting, so
+ * each neighborhood costs expected linear time; neighborhoods are solved in
+ * parallel.
+ */
+class InternetContention {
+private:
+    ThreadPool pool;
+
+    // Water level for the demands in [first, last); the range is reordered
+    static double waterLevel(double* first, double* last, double capacity) {
+        double total = 0.0;
+        for (double* d = first; d != last; d++) total += *d;
+        if (total <= capacity) return numeric_limits<double>::infinity();
+
+        double below = 0.0;     // sum of demands known to sit under the level
+        size_t above = 0;       // count of demands known to reach the level
+        double* lo = first;
+        double* hi = last;
+        while (lo < hi) {
+            double* mid = lo + (hi - lo) / 2;
+            nth_element(lo, mid, hi);
+            double pivot = *mid;
+            double lowerSum = accumulate(lo, mid, 0.0);
+            double filled = below + lowerSum + pivot * static_cast<double>((hi - mid) + above);
+            if (filled >= capacity) {
+                // Level is at or under the pivot: everything from the pivot up is capped
+                above += hi - mid;
+                hi = mid;
+            } else {
+                // Level is above the pivot: the pivot and everything under it is fully served
+                below += lowerSum + pivot;
+                lo = mid + 1;
+            }
+        }
+        return above > 0 ? (capacity - below) / above : numeric_limits<double>::infinity();
+    }
+
+public:
+    // Share of a day's traffic that falls into the busiest hour
+    static constexpr double BUSY_HOUR_SHARE = 0.15;
+
+    // Busy-hour rate of a subscriber who moved gbPerDay today, capped by the plan speed
+    static double busyHourDemandMbps(double gbPerDay, double planSpeedMbps) {
+        return min(planSpeedMbps, gbPerDay * 8000.0 * BUSY_HOUR_SHARE / 3600.0);
+    }
+
+    // threadCount = 0 uses every hardware thread
+    explicit InternetContention(size_t threadCount = 0) : pool(threadCount) {}
+
+    static string neighborhoodKey(const Address& address) {
+        return address.pin + "/" + to_string(address.streetNo);
+    }
+
+    /**
+     * Share capacity among subscribers.
+     * subscribersOf[n] lists the subscriber indices of neighborhood n;
+     * returns each subscriber's allocated throughput and fills the fair share
+     * and totals of each entry in loads (whose capacityMbps must be set).
+     */
+    vector<double> allocate(const vector<vector<size_t>>& subscribersOf, const vector<double>& demand,
+                            vector<NeighborhoodLoad>& loads) {
+        if (loads.size() != subscribersOf.size()) {
+            throw invalid_argument("Every neighborhood needs a load entry");
+        }
+        vector<double> allocation(demand.size(), 0.0);
+
+        pool.parallelFor(0, subscribersOf.size(), [&](size_t first, size_t last) {
+            vector<double> scratch;
+            for (size_t n = first; n < last; n++) {
+                const vector<size_t>& members = subscribersOf[n];
+                scratch.resize(members.size());
+                for (size_t k = 0; k < members.size(); k++) scratch[k] = demand[members[k]];
+
+                NeighborhoodLoad& load = loads[n];
+                load.subscribers = members.size();
+                load.demandMbps = accumulate(scratch.begin(), scratch.end(), 0.0);
+                load.fairShareMbps = waterLevel(scratch.data(), scratch.data() + scratch.size(), load.capacityMbps);
+
+                load.allocatedMbps = 0.0;
+                for (size_t member : members) {
+                    allocation[member] = min(demand[member], load.fairShareMbps);
+                    load.allocatedMbps += allocation[member];
+                }
+            }
+        }, 16);
+        return allocation;
+    }
+};
+
+#endif // INTERNETCONTENTION_H
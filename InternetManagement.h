@@ -10,6 +10,7 @@
 #include <limits>
 #include <cmath>
 #include <map>
+#include <algorithm>
 
 using namespace std;
 
@@ -33,6 +34,9 @@ class InternetManagement: public Services{
     private:
         Address address;
         double dataUsedGB;
+        double effectiveSpeedMbps; // busy-hour speed after neighborhood contention (negative if unknown)
+        double baselineReliability;    // reliability before contention
+        double contendedReliability;   // score contention last set (negative if never)
         InternetPlan currentPlan;
         static map<InternetPlan, PlanDetails> planDetailsMap;
 
@@ -46,7 +50,8 @@ class InternetManagement: public Services{
 
     public:
         InternetManagement(Address ad, InternetPlan plan = InternetPlan::NO_SERVICE, double initialDataUsage = 0.0)
-            : Services("Internet"), address(ad), currentPlan(plan), dataUsedGB(initialDataUsage) {
+            : Services("Internet"), address(ad), dataUsedGB(initialDataUsage), effectiveSpeedMbps(-1.0),
+              baselineReliability(100.0), contendedReliability(-1.0), currentPlan(plan) {
                 if (initialDataUsage < 0) {
                     throw invalid_argument("Initial data usage cannot be negative.");
                 }
@@ -95,8 +100,35 @@ class InternetManagement: public Services{
         const Address& getAddress() const {return address;}
         double getDataUsedGB() const {return dataUsedGB;}
         InternetPlan getCurrentPlan() const {return currentPlan;}
+        double getEffectiveSpeed() const {return effectiveSpeedMbps;}
 
         // --- Setters ---
+        // Set by the contention model after each tick
+        void setEffectiveSpeed(double mbps) {
+            effectiveSpeedMbps = mbps;
+        }
+
+        // The account's own reliability: the score, unless contention set it, in which case the score it scaled
+        double getBaselineReliability() const {
+            return (contendedReliability >= 0 && reliabilityScore == contendedReliability) ? baselineReliability : reliabilityScore;
+        }
+
+        // Reliability when only mbps of the plan speed gets through in the busy hour
+        double reliabilityAt(double mbps) const {
+            int planSpeed = getCurrentSpeed();
+            double delivered = (planSpeed > 0) ? min(1.0, max(0.0, mbps / planSpeed)) : 1.0;
+            return getBaselineReliability() * delivered;
+        }
+
+        // Set by the contention model after each tick; a score set in the meantime becomes the new baseline
+        void applyContention(double mbps) {
+            double reliability = reliabilityAt(mbps);
+            baselineReliability = getBaselineReliability();
+            effectiveSpeedMbps = mbps;
+            reliabilityScore = reliability;
+            contendedReliability = reliability;
+        }
+
         void setCurrentPlan(InternetPlan newPlan) {
             currentPlan = newPlan;
             dataUsedGB = 0.0; // Reset data usage when plan changes
@@ -111,6 +143,9 @@ class InternetManagement: public Services{
                 cout << "STATUS: No internet service active" << endl;
             } else {
                 cout << "Current speed: " << getCurrentSpeed() << " Mbps" << endl;
+                if (effectiveSpeedMbps >= 0 && effectiveSpeedMbps < getCurrentSpeed()) {
+                    cout << "Busy-hour speed: " << effectiveSpeedMbps << " Mbps (shared backhaul congested)" << endl;
+                }
                 cout << "STATUS: Complete" << endl;
             }
         }
@@ -131,6 +166,9 @@ class InternetManagement: public Services{
             if (currentPlan != InternetPlan::NO_SERVICE) {
                 cout << "Data Used: " << dataUsedGB << " GB" << endl;
                 cout << "Speed: " << details.speedMbps << " Mbps" << endl;
+                if (effectiveSpeedMbps >= 0) {
+                    cout << "Busy-hour Speed: " << effectiveSpeedMbps << " Mbps" << endl;
+                }
                 if (!std::isinf(details.dataCapGB)){
                     cout << "Data Cap: " << details.dataCapGB << " GB" << endl;
                 } else {
@@ -146,6 +184,12 @@ class InternetManagement: public Services{
             cout << "-------------------------" << endl;
         }
 
+        const Address* getServiceAddress() const override { return &address; }
+
+        unique_ptr<Services> clone() const override {
+            return make_unique<InternetManagement>(*this);
+        }
+
         virtual ~InternetManagement() override = default; // Virtual Destructor
 };
 
@@ -0,0 +1,306 @@
+#ifndef INTERVALBILLING_H
+#define INTERVALBILLING_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+
+#include "ElectricityManagement.h"
+#include "HourlyProfiles.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+/**
+ * Smart-meter interval readings for many electricity accounts.
+ * Each account is its own column of day blocks. A block stores the day's
+ * readings in whole Wh as a base value followed by zig-zag encoded deltas
+ * bit-packed at the narrowest width that fits the day, so a typical meter
+ * costs about one byte per interval instead of eight.
+ */
+class IntervalStore {
+private:
+    struct Column {
+        vector<uint8_t> bytes;
+        int days = 0;
+    };
+
+    int intervalMinutes;
+    int intervalsPerDay;
+    vector<Column> columns;
+
+    static uint32_t zigzag(int64_t value) { return static_cast<uint32_t>((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63)); }
+    static int64_t unzigzag(uint32_t value) { return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1); }
+
+    static void putVarint(vector<uint8_t>& out, uint32_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    static uint32_t getVarint(const uint8_t*& in) {
+        uint32_t value = 0;
+        int shift = 0;
+        while (*in & 0x80) {
+            value |= static_cast<uint32_t>(*in++ & 0x7F) << shift;
+            shift += 7;
+        }
+        return value | (static_cast<uint32_t>(*in++) << shift);
+    }
+
+    static uint64_t loadLittleEndian64(const uint8_t* p) {
+        return static_cast<uint64_t>(p[0]) | static_cast<uint64_t>(p[1]) << 8 |
+               static_cast<uint64_t>(p[2]) << 16 | static_cast<uint64_t>(p[3]) << 24 |
+               static_cast<uint64_t>(p[4]) << 32 | static_cast<uint64_t>(p[5]) << 40 |
+               static_cast<uint64_t>(p[6]) << 48 | static_cast<uint64_t>(p[7]) << 56;
+    }
+
+    // Readings are kept within +/-2^30 Wh so every delta zig-zags into 32 bits
+    static int32_t toWh(double kWh) {
+        double wh = round(kWh * 1000.0);
+        if (!(fabs(wh) < 1073741824.0)) {
+            throw out_of_range("Interval reading out of range");
+        }
+        return static_cast<int32_t>(wh);
+    }
+
+    const Column& column(size_t account) const {
+        if (account >= columns.size()) {
+            throw out_of_range("Unknown meter account");
+        }
+        return columns[account];
+    }
+
+public:
+    // intervalMinutes must divide an hour so that no interval straddles two hours
+    explicit IntervalStore(int minutesPerInterval = 15)
+        : intervalMinutes(minutesPerInterval), intervalsPerDay(0) {
+        if (minutesPerInterval <= 0 || 60 % minutesPerInterval != 0) {
+            throw invalid_argument("Interval length must divide 60 minutes");
+        }
+        intervalsPerDay = HOURS_PER_DAY * 60 / minutesPerInterval;
+    }
+
+    // Register a meter; returns its account number
+    size_t addAccount() {
+        columns.emplace_back();
+        return columns.size() - 1;
+    }
+
+    void reserveAccounts(size_t count) { columns.reserve(count); }
+
+    // Append one day of readings (intervalsPerDay values in kWh) to an account
+    void appendDay(size_t account, const double* kWh) {
+        if (account >= columns.size()) {
+            throw out_of_range("Unknown meter account");
+        }
+
+        // Quantise and delta-encode first so the block width is known
+        vector<uint32_t> deltas(intervalsPerDay - 1);
+        int32_t first = toWh(kWh[0]);
+        int32_t previous = first;
+        uint32_t widest = 0;
+        for (int i = 1; i < intervalsPerDay; i++) {
+            int32_t current = toWh(kWh[i]);
+            deltas[i - 1] = zigzag(static_cast<int64_t>(current) - previous);
+            widest |= deltas[i - 1];
+            previous = current;
+        }
+        int width = 0;
+        while (width < 32 && (widest >> width) != 0) width++;
+
+        vector<uint8_t>& out = columns[account].bytes;
+        putVarint(out, zigzag(first));
+        out.push_back(static_cast<uint8_t>(width));
+
+        size_t start = out.size();
+        out.resize(start + (static_cast<size_t>(deltas.size()) * width + 7) / 8, 0);
+        size_t bit = 0;
+        for (uint32_t delta : deltas) {
+            uint64_t window = static_cast<uint64_t>(delta) << (bit % 8);
+            for (size_t byte = start + bit / 8; window != 0; byte++, window >>= 8) {
+                out[byte] |= static_cast<uint8_t>(window);
+            }
+            bit += width;
+        }
+        columns[account].days++;
+    }
+
+    void appendDay(size_t account, const vector<double>& kWh) {
+        if (kWh.size() != static_cast<size_t>(intervalsPerDay)) {
+            throw invalid_argument("Expected " + to_string(intervalsPerDay) + " interval readings");
+        }
+        appendDay(account, kWh.data());
+    }
+
+    // Call visit(day, wh) with each stored day of an account, oldest first;
+    // wh points at intervalsPerDay readings in whole Wh
+    template<typename Visitor>
+    void forEachDay(size_t account, Visitor visit) const {
+        const Column& col = column(account);
+        const uint8_t* in = col.bytes.data();
+        vector<int64_t> wh(intervalsPerDay);
+        for (int d = 0; d < col.days; d++) {
+            int64_t value = unzigzag(getVarint(in));
+            int width = *in++;
+            wh[0] = value;
+
+            // Each delta spans at most five bytes; whole 8-byte windows are read
+            // while they stay inside the block (the compiler folds them into one load)
+            const uint64_t mask = (width == 32) ? 0xFFFFFFFFull : ((1ull << width) - 1);
+            const size_t blockBytes = (static_cast<size_t>(intervalsPerDay - 1) * width + 7) / 8;
+            size_t bit = 0;
+            for (int i = 1; i < intervalsPerDay; i++, bit += width) {
+                const uint8_t* p = in + bit / 8;
+                size_t bytes = (bit / 8 + 8 <= blockBytes) ? 8 : blockBytes - bit / 8;
+                uint64_t window = 0;
+                if (bytes == 8) {
+                    window = loadLittleEndian64(p);
+                } else {
+                    for (size_t k = 0; k < bytes; k++) window |= static_cast<uint64_t>(p[k]) << (8 * k);
+                }
+                value += unzigzag(static_cast<uint32_t>((window >> (bit % 8)) & mask));
+                wh[i] = value;
+            }
+            in += blockBytes;
+            visit(d, static_cast<const int64_t*>(wh.data()));
+        }
+    }
+
+    // Decoded readings of one account in kWh
+    vector<double> readings(size_t account) const {
+        vector<double> result;
+        result.reserve(static_cast<size_t>(column(account).days) * intervalsPerDay);
+        forEachDay(account, [this, &result](int, const int64_t* wh) {
+            for (int i = 0; i < intervalsPerDay; i++) result.push_back(wh[i] / 1000.0);
+        });
+        return result;
+    }
+
+    // Release the slack left by growing columns
+    void compact() {
+        for (auto& col : columns) col.bytes.shrink_to_fit();
+    }
+
+    // Start a new billing period
+    void clear() {
+        for (auto& col : columns) {
+            col.bytes.clear();
+            col.days = 0;
+        }
+    }
+
+    size_t getAccountCount() const { return columns.size(); }
+    int getIntervalMinutes() const { return intervalMinutes; }
+    int getIntervalsPerDay() const { return intervalsPerDay; }
+    int getDays(size_t account) const { return column(account).days; }
+
+    size_t getEncodedBytes() const {
+        size_t total = 0;
+        for (const auto& col : columns) total += col.bytes.size();
+        return total;
+    }
+};
+
+/**
+ * Time-of-use tariff with an optional peak-demand charge
+ */
+struct TimeOfUseTariff {
+    string displayName;
+    double baseCost;                     // per billing period
+    double pricePerUnit[HOURS_PER_DAY];  // per kWh, by hour of day
+    double demandCharge;                 // per kW of the highest interval demand in the period
+
+    // Single-rate tariff equivalent to an existing electricity plan
+    static TimeOfUseTariff fromPlan(ElectricityPlan plan) {
+        const ElectricityTariff& tariff = ElectricityManagement::getTariffDetails(plan);
+        TimeOfUseTariff tou{tariff.displayName, tariff.baseCost, {}, 0.0};
+        for (int h = 0; h < HOURS_PER_DAY; h++) tou.pricePerUnit[h] = tariff.pricePerUnit;
+        return tou;
+    }
+
+    // Off-peak overnight, shoulder during the day, peak from 17:00 to 21:00
+    static TimeOfUseTariff peakShoulderOffPeak(const string& name, double base, double offPeak,
+                                               double shoulder, double peak, double perKW = 0.0) {
+        TimeOfUseTariff tou{name, base, {}, perKW};
+        for (int h = 0; h < HOURS_PER_DAY; h++) {
+            if (h >= 17 && h < 21) tou.pricePerUnit[h] = peak;
+            else if (h >= 7 && h < 17) tou.pricePerUnit[h] = shoulder;
+            else tou.pricePerUnit[h] = offPeak;
+        }
+        return tou;
+    }
+};
+
+struct IntervalBill {
+    double energyKWh;
+    double peakKW;
+    double baseCost;
+    double energyCost;
+    double demandCost;
+    double total;
+};
+
+/**
+ * Bulk billing over an interval store.
+ * Each account is decoded a day at a time; consumption is summed per hour of
+ * day in whole Wh and priced with 24 multiplications at the end, and accounts are
+ * billed in parallel.
+ */
+class IntervalBilling {
+public:
+    static IntervalBill billAccount(const IntervalStore& store, size_t account, const TimeOfUseTariff& tariff) {
+        int64_t hourWh[HOURS_PER_DAY] = {};
+        int64_t peakWh = 0;
+        const int minutes = store.getIntervalMinutes();
+        const int perHour = 60 / minutes;
+
+        store.forEachDay(account, [&](int, const int64_t* wh) {
+            for (int h = 0; h < HOURS_PER_DAY; h++) {
+                const int64_t* hour = wh + h * perHour;
+                for (int i = 0; i < perHour; i++) {
+                    hourWh[h] += hour[i];
+                    peakWh = max(peakWh, hour[i]);
+                }
+            }
+        });
+
+        IntervalBill bill{};
+        for (int h = 0; h < HOURS_PER_DAY; h++) {
+            bill.energyKWh += hourWh[h] / 1000.0;
+            bill.energyCost += hourWh[h] / 1000.0 * tariff.pricePerUnit[h];
+        }
+        bill.peakKW = peakWh / 1000.0 * 60.0 / minutes;
+        bill.baseCost = tariff.baseCost;
+        bill.demandCost = bill.peakKW * tariff.demandCharge;
+        bill.total = bill.baseCost + bill.energyCost + bill.demandCost;
+        return bill;
+    }
+
+    // tariffOf[account] indexes into tariffs
+    static vector<IntervalBill> billAll(const IntervalStore& store, const vector<TimeOfUseTariff>& tariffs,
+                                        const vector<size_t>& tariffOf, ThreadPool& pool) {
+        if (tariffOf.size() != store.getAccountCount()) {
+            throw invalid_argument("Every account needs a tariff");
+        }
+        for (size_t t : tariffOf) {
+            if (t >= tariffs.size()) throw out_of_range("Unknown tariff");
+        }
+
+        vector<IntervalBill> bills(store.getAccountCount());
+        pool.parallelFor(0, bills.size(), [&](size_t first, size_t last) {
+            for (size_t a = first; a < last; a++) {
+                bills[a] = billAccount(store, a, tariffs[tariffOf[a]]);
+            }
+        }, 256);
+        return bills;
+    }
+};
+
+#endif // INTERVALBILLING_H
@@ -0,0 +1,74 @@
+#ifndef LOGLEVEL_H
+#define LOGLEVEL_H
+
+#include <cstdint>
+
+using namespace std;
+
+// Severity of a log message, least severe first
+enum class LogLevel : uint8_t {
+    VERBOSE = 0,   // per-entity and per-day detail
+    INFO = 1,      // setup, configuration and notable events
+    WARNING = 2    // thresholds exceeded, outages
+};
+
+// What a log message is about; each category can be switched off on its own
+enum class LogCategory : uint8_t {
+    GENERAL = 0,   // city lifecycle and configuration
+    ENTITIES,      // buildings, vehicles, citizens, housing and services joining the city
+    SIMULATION,    // day progress, scheduled events, eco score
+    MONITORING,    // per-entity pollution monitoring
+    NETWORKS,      // energy, water, gas, internet, street and traffic results
+    POLLUTION,     // pollution spikes, thresholds and measures
+    COUNT
+};
+
+// Messages below this level are compiled out, e.g. -DCITY_MIN_LOG_LEVEL=1 drops VERBOSE messages
+#ifndef CITY_MIN_LOG_LEVEL
+#define CITY_MIN_LOG_LEVEL 0
+#endif
+
+/**
+ * Which log messages are written.
+ * Call sites test enabled() before building a message, so filtered messages
+ * cost a compare and a mask test and no string work. compiledIn() is a
+ * constant expression: a guarded message below CITY_MIN_LOG_LEVEL is removed
+ * by the compiler along with its formatting.
+ */
+class LogFilter {
+private:
+    LogLevel minimum;
+    uint32_t categories;   // bit per LogCategory
+
+public:
+#if CITY_MIN_LOG_LEVEL > 0
+    static constexpr bool compiledIn(LogLevel level) {
+        return static_cast<int>(level) >= CITY_MIN_LOG_LEVEL;
+    }
+#else
+    // Nothing is compiled out; no comparison, which would always hold
+    static constexpr bool compiledIn(LogLevel) {
+        return true;
+    }
+#endif
+
+    LogFilter() : minimum(LogLevel::VERBOSE), categories((1u << static_cast<int>(LogCategory::COUNT)) - 1) {}
+
+    bool enabled(LogLevel level, LogCategory category) const {
+        return compiledIn(level) && level >= minimum && ((categories >> static_cast<int>(category)) & 1u);
+    }
+
+    void setLevel(LogLevel level) { minimum = level; }
+    LogLevel getLevel() const { return minimum; }
+
+    void setCategory(LogCategory category, bool enabled) {
+        uint32_t bit = 1u << static_cast<int>(category);
+        categories = enabled ? (categories | bit) : (categories & ~bit);
+    }
+
+    bool isCategoryEnabled(LogCategory category) const {
+        return (categories >> static_cast<int>(category)) & 1u;
+    }
+};
+
+#endif // LOGLEVEL_H
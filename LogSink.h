@@ -0,0 +1,196 @@
+#ifndef LOGSINK_H
+#define LOGSINK_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <ostream>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <stdexcept>
+
+using namespace std;
+
+/**
+ * Destination of formatted log lines.
+ * Loggers hand over one line at a time without a trailing newline; a sink
+ * decides when the lines reach their destination, and flush() forces them
+ * out. Every sink can be shared between loggers and threads.
+ */
+class LogSink {
+public:
+    virtual ~LogSink() = default;
+    virtual void write(const string& line) = 0;
+    virtual void flush() {}
+};
+
+// Discards every line
+class NullLogSink : public LogSink {
+public:
+    void write(const string&) override {}
+};
+
+// Keeps every line in memory
+class MemoryLogSink : public LogSink {
+private:
+    vector<string> lines;
+    mutable mutex lock;
+
+public:
+    void write(const string& line) override {
+        lock_guard<mutex> guard(lock);
+        lines.push_back(line);
+    }
+
+    vector<string> getLines() const {
+        lock_guard<mutex> guard(lock);
+        return lines;
+    }
+
+    void clear() {
+        lock_guard<mutex> guard(lock);
+        lines.clear();
+    }
+};
+
+// Writes lines to a stream such as cout, which only flushes on flush()
+class StreamLogSink : public LogSink {
+private:
+    ostream& out;
+    mutex lock;
+
+public:
+    explicit StreamLogSink(ostream& stream) : out(stream) {}
+
+    void write(const string& line) override {
+        lock_guard<mutex> guard(lock);
+        out.write(line.data(), line.size());
+        out.put('\n');
+    }
+
+    void flush() override {
+        lock_guard<mutex> guard(lock);
+        out.flush();
+    }
+};
+
+/**
+ * Appends lines to a file in batches.
+ * Lines collect in a buffer that is written once it holds batchBytes, on
+ * flush() and on destruction, instead of one flushed write per line.
+ */
+class FileLogSink : public LogSink {
+private:
+    ofstream file;
+    string buffer;
+    size_t batchBytes;
+    mutex lock;
+
+    void writeBuffer() {
+        file.write(buffer.data(), buffer.size());
+        buffer.clear();
+    }
+
+public:
+    explicit FileLogSink(const string& filename, size_t batch = 1 << 16) : batchBytes(batch) {
+        file.open(filename, ios::app);
+        if (!file.is_open()) {
+            throw runtime_error("Could not open log file: " + filename);
+        }
+        buffer.reserve(batchBytes);
+    }
+
+    ~FileLogSink() override {
+        flush();
+    }
+
+    void write(const string& line) override {
+        lock_guard<mutex> guard(lock);
+        buffer += line;
+        buffer += '\n';
+        if (buffer.size() >= batchBytes) writeBuffer();
+    }
+
+    void flush() override {
+        lock_guard<mutex> guard(lock);
+        writeBuffer();
+        file.flush();
+    }
+};
+
+/**
+ * Hands lines to another sink on a background thread.
+ * write() only queues the line; the worker passes queued lines on in
+ * batches, so slow destinations stay off the simulation thread. flush()
+ * waits until everything queued so far has reached the target and it has
+ * been flushed.
+ */
+class AsyncLogSink : public LogSink {
+private:
+    shared_ptr<LogSink> target;
+    vector<string> queued;
+    size_t queuedCount;     // lines ever queued
+    size_t writtenCount;    // lines ever passed to the target
+    bool stopping;
+    mutex lock;
+    condition_variable wake;
+    condition_variable drained;
+    thread worker;
+
+    void run() {
+        vector<string> batch;
+        unique_lock<mutex> guard(lock);
+        while (true) {
+            wake.wait(guard, [this] { return stopping || !queued.empty(); });
+            if (queued.empty() && stopping) return;
+            batch.swap(queued);
+            guard.unlock();
+            for (const string& line : batch) target->write(line);
+            guard.lock();
+            writtenCount += batch.size();
+            batch.clear();
+            drained.notify_all();
+        }
+    }
+
+public:
+    explicit AsyncLogSink(shared_ptr<LogSink> destination)
+        : target(move(destination)), queuedCount(0), writtenCount(0), stopping(false) {
+        if (!target) {
+            throw invalid_argument("Asynchronous log sink needs a target sink");
+        }
+        worker = thread([this] { run(); });
+    }
+
+    ~AsyncLogSink() override {
+        {
+            lock_guard<mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_one();
+        worker.join();
+        target->flush();
+    }
+
+    void write(const string& line) override {
+        {
+            lock_guard<mutex> guard(lock);
+            queued.push_back(line);
+            queuedCount++;
+        }
+        wake.notify_one();
+    }
+
+    void flush() override {
+        {
+            unique_lock<mutex> guard(lock);
+            size_t goal = queuedCount;
+            drained.wait(guard, [this, goal] { return writtenCount >= goal; });
+        }
+        target->flush();
+    }
+};
+
+#endif // LOGSINK_H
@@ -0,0 +1,484 @@
+#ifndef LOGSTORE_H
+#define LOGSTORE_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <cstdio>
+#include <cstdint>
+#include <ctime>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "BlockCompressor.h"
+
+using namespace std;
+
+/**
+ * Searchable store of timestamped log lines.
+ * Lines collect in time-range partitions (segments). A segment is sealed
+ * when it is full or the clock enters a new partition, and sealing builds a
+ * trigram inverted index over its lines, so a substring query intersects a
+ * few posting lists instead of scanning. Terms under three characters, the
+ * open segment and spilled segments are searched a whole text block at a
+ * time with Boyer-Moore-Horspool. Once sealed segments exceed the
+ * memory budget, the oldest are written once to an append-only scratch file,
+ * optionally compressed, with a bloom filter of their trigrams in front that
+ * lets searches skip almost every segment that cannot match. Only the time
+ * range and file position of a spilled segment stay in memory; reads map it
+ * back, and the buffers it held are recycled for the next open segment.
+ */
+class LogStore {
+private:
+    // A segment's lines, in memory or mapped from the scratch file
+    struct Lines {
+        const time_t* times;
+        const uint32_t* textStart;    // line i is text[textStart[i], textStart[i + 1])
+        const char* text;
+        uint32_t count;
+    };
+
+    struct Segment {
+        time_t firstTime;
+        time_t lastTime;
+        vector<time_t> times;
+        vector<uint32_t> textStart;
+        string text;
+        vector<uint32_t> keys;        // trigrams in the segment, ascending
+        vector<uint32_t> keyStart;    // CSR: lines holding keys[k] are lines[keyStart[k], keyStart[k + 1])
+        vector<uint16_t> lines;
+
+        Lines view() const {
+            return {times.data(), textStart.data(), text.data(), static_cast<uint32_t>(times.size())};
+        }
+
+        size_t memoryUsage() const {
+            return sizeof(Segment) + times.capacity() * sizeof(time_t) +
+                   (textStart.capacity() + keys.capacity() + keyStart.capacity()) * sizeof(uint32_t) +
+                   text.capacity() + lines.capacity() * sizeof(uint16_t);
+        }
+    };
+
+    // A segment on disk: bloomWords of bloom filter at fileOffset, then storedBytes of lines (payloadBytes uncompressed)
+    struct SpilledSegment {
+        time_t firstTime;
+        time_t lastTime;
+        uint64_t fileOffset;
+        uint64_t storedBytes;
+        uint64_t payloadBytes;
+        uint32_t lineCount;
+        uint32_t bloomWords;
+        bool compressed;
+    };
+
+    struct FileCloser {
+        void operator()(FILE* file) const { if (file) fclose(file); }
+    };
+
+    // A byte range of the scratch file, memory mapped where the platform allows, else read
+    class Region {
+    private:
+        const char* bytes;
+        size_t count;
+#ifndef _WIN32
+        void* base;
+        size_t length;
+#else
+        vector<uint64_t> buffer;
+#endif
+
+    public:
+        Region(FILE* file, uint64_t offset, size_t size) : count(size) {
+#ifndef _WIN32
+            uint64_t page = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+            uint64_t aligned = offset - offset % page;
+            length = size + (offset - aligned);
+            base = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fileno(file), static_cast<off_t>(aligned));
+            if (base == MAP_FAILED) {
+                throw runtime_error("Could not map a log segment from the scratch file");
+            }
+            bytes = static_cast<const char*>(base) + (offset - aligned);
+#else
+            buffer.resize((size + 7) / 8);
+            if (_fseeki64(file, offset, SEEK_SET) != 0 || fread(buffer.data(), 1, size, file) != size) {
+                throw runtime_error("Could not read a log segment from the scratch file");
+            }
+            bytes = reinterpret_cast<const char*>(buffer.data());
+#endif
+        }
+
+        ~Region() {
+#ifndef _WIN32
+            munmap(base, length);
+#endif
+        }
+
+        Region(const Region&) = delete;
+        Region& operator=(const Region&) = delete;
+
+        const char* data() const { return bytes; }
+        size_t size() const { return count; }
+    };
+
+    vector<SpilledSegment> spilled;   // oldest first, all older than the segments in memory
+    vector<Segment> segments;     // oldest first; the last one is open unless the store is empty
+    size_t memoryBudget;
+    size_t sealedBytes;           // memory of sealed segments not yet spilled
+    size_t lineCount;
+    bool compression;
+    uint64_t diskBytes;
+    Segment spare;                // buffers of the last spilled segment, reused by the next open one
+    unique_ptr<FILE, FileCloser> scratch;
+    mutable shared_ptr<const Region> mapping;   // the whole scratch file, remapped when it has grown
+    mutable mutex scratchLock;
+
+    static uint32_t trigram(const char* p) {
+        return (uint32_t(uint8_t(p[0])) << 16) | (uint32_t(uint8_t(p[1])) << 8) | uint8_t(p[2]);
+    }
+
+    static uint64_t bloomHash(uint32_t key, int probe) {
+        uint64_t h = (uint64_t(key) + 1) * 0x9E3779B97F4A7C15ULL;
+        h ^= h >> 29;
+        return h * (0xBF58476D1CE4E5B9ULL + 2 * probe);
+    }
+
+    static constexpr int BLOOM_PROBES = 3;
+
+    static bool bloomContains(const uint64_t* bloom, size_t words, uint32_t key) {
+        size_t bits = words * 64;
+        for (int k = 0; k < BLOOM_PROBES; k++) {
+            size_t bit = (bloomHash(key, k) >> 20) & (bits - 1);
+            if (!(bloom[bit / 64] & (1ULL << (bit % 64)))) return false;
+        }
+        return true;
+    }
+
+    static vector<uint32_t> trigramsOf(const string& term) {
+        vector<uint32_t> keys;
+        for (size_t i = 0; i + 3 <= term.size(); i++) keys.push_back(trigram(term.data() + i));
+        sort(keys.begin(), keys.end());
+        keys.erase(unique(keys.begin(), keys.end()), keys.end());
+        return keys;
+    }
+
+    static time_t partitionOf(time_t t) { return t - (t % PARTITION_SECONDS); }
+
+    void seal(Segment& segment) {
+        // (trigram, line) pairs come out in line order, so a stable radix sort on
+        // the 24-bit trigram leaves every posting list ascending
+        vector<uint64_t> pairs, sorted;
+        for (uint32_t line = 0; line < segment.times.size(); line++) {
+            const char* p = segment.text.data() + segment.textStart[line];
+            size_t length = segment.textStart[line + 1] - segment.textStart[line];
+            for (size_t i = 0; i + 3 <= length; i++) pairs.push_back((uint64_t(trigram(p + i)) << 16) | line);
+        }
+        sorted.resize(pairs.size());
+        for (int shift = 16; shift < 40; shift += 12) {
+            vector<size_t> start(4097, 0);
+            for (uint64_t pair : pairs) start[((pair >> shift) & 4095) + 1]++;
+            for (size_t b = 1; b <= 4096; b++) start[b] += start[b - 1];
+            for (uint64_t pair : pairs) sorted[start[(pair >> shift) & 4095]++] = pair;
+            pairs.swap(sorted);
+        }
+
+        for (size_t i = 0; i < pairs.size(); i++) {
+            if (i > 0 && pairs[i] == pairs[i - 1]) continue;
+            uint32_t key = static_cast<uint32_t>(pairs[i] >> 16);
+            if (segment.keys.empty() || segment.keys.back() != key) {
+                segment.keys.push_back(key);
+                segment.keyStart.push_back(static_cast<uint32_t>(segment.lines.size()));
+            }
+            segment.lines.push_back(static_cast<uint16_t>(pairs[i] & 0xFFFF));
+        }
+        segment.keyStart.push_back(static_cast<uint32_t>(segment.lines.size()));
+        segment.keys.shrink_to_fit();
+        segment.keyStart.shrink_to_fit();
+        segment.lines.shrink_to_fit();
+        sealedBytes += segment.memoryUsage();
+    }
+
+    // Writes the oldest segment in memory to the scratch file and keeps only its place there
+    void spillOldest() {
+        if (!scratch) {
+            scratch.reset(tmpfile());
+            if (!scratch) {
+                throw runtime_error("Could not create a scratch file for log segments");
+            }
+        }
+        Segment& segment = segments.front();
+        SpilledSegment entry;
+        entry.firstTime = segment.firstTime;
+        entry.lastTime = segment.lastTime;
+        entry.lineCount = static_cast<uint32_t>(segment.times.size());
+
+        // Roughly 10 bits per distinct trigram keeps false positives near 1%
+        size_t bits = 1024;
+        while (bits < segment.keys.size() * 10) bits *= 2;
+        vector<uint64_t> bloom(bits / 64, 0);
+        for (uint32_t key : segment.keys) {
+            for (int k = 0; k < BLOOM_PROBES; k++) {
+                size_t bit = (bloomHash(key, k) >> 20) & (bits - 1);
+                bloom[bit / 64] |= 1ULL << (bit % 64);
+            }
+        }
+
+        // Lines as times, text offsets and text, so a mapped segment is read in place
+        string payload(segment.times.size() * sizeof(time_t) + segment.textStart.size() * sizeof(uint32_t), '\0');
+        memcpy(&payload[0], segment.times.data(), segment.times.size() * sizeof(time_t));
+        memcpy(&payload[segment.times.size() * sizeof(time_t)], segment.textStart.data(), segment.textStart.size() * sizeof(uint32_t));
+        payload += segment.text;
+        entry.payloadBytes = payload.size();
+        entry.compressed = compression;
+        if (compression) payload = BlockCompressor::compress(payload.data(), payload.size());
+        entry.storedBytes = payload.size();
+        entry.bloomWords = static_cast<uint32_t>(bloom.size());
+
+        {
+            lock_guard<mutex> guard(scratchLock);
+            // Segments start 8-byte aligned so mapped times and offsets can be read directly
+            static const char padding[8] = {};
+            size_t pad = (8 - diskBytes % 8) % 8;
+            entry.fileOffset = diskBytes + pad;
+            bool written = fseek(scratch.get(), 0, SEEK_END) == 0 &&
+                           fwrite(padding, 1, pad, scratch.get()) == pad &&
+                           fwrite(bloom.data(), sizeof(uint64_t), bloom.size(), scratch.get()) == bloom.size() &&
+                           fwrite(payload.data(), 1, payload.size(), scratch.get()) == payload.size() &&
+                           fflush(scratch.get()) == 0;
+            if (!written) {
+                throw runtime_error("Could not write a log segment to the scratch file");
+            }
+            diskBytes = entry.fileOffset + bloom.size() * sizeof(uint64_t) + payload.size();
+        }
+
+        sealedBytes -= segment.memoryUsage();
+        if (spare.text.capacity() == 0) {
+            segment.times.clear();
+            segment.textStart.clear();
+            segment.text.clear();
+            spare.times.swap(segment.times);
+            spare.textStart.swap(segment.textStart);
+            spare.text.swap(segment.text);
+        }
+        spilled.push_back(entry);
+        segments.erase(segments.begin());
+    }
+
+    void enforceBudget() {
+        while (segments.size() > 1 && sealedBytes > memoryBudget) spillOldest();
+    }
+
+    /**
+     * Calls use(lines) with the lines of a spilled segment, unless its bloom
+     * filter rules out one of the trigrams. Uncompressed segments are read
+     * straight from the mapping.
+     */
+    template<typename Use>
+    void withSpilled(const SpilledSegment& segment, const vector<uint32_t>& keys, Use use) const {
+        uint64_t size = segment.bloomWords * sizeof(uint64_t) + segment.storedBytes;
+        shared_ptr<const Region> region;
+        const char* bytes;
+        {
+            lock_guard<mutex> guard(scratchLock);
+#ifndef _WIN32
+            if (!mapping || mapping->size() < segment.fileOffset + size) {
+                mapping = make_shared<Region>(scratch.get(), 0, diskBytes);
+            }
+            region = mapping;
+            bytes = region->data() + segment.fileOffset;
+#else
+            region = make_shared<Region>(scratch.get(), segment.fileOffset, size);
+            bytes = region->data();
+#endif
+        }
+        const uint64_t* bloom = reinterpret_cast<const uint64_t*>(bytes);
+        for (uint32_t key : keys) {
+            if (!bloomContains(bloom, segment.bloomWords, key)) return;
+        }
+
+        const char* payload = bytes + segment.bloomWords * sizeof(uint64_t);
+        vector<uint64_t> unpacked;
+        if (segment.compressed) {
+            unpacked.resize((segment.payloadBytes + BlockCompressor::SLACK + 7) / 8);
+            BlockCompressor::decompress(payload, segment.storedBytes, reinterpret_cast<char*>(unpacked.data()), segment.payloadBytes);
+            payload = reinterpret_cast<const char*>(unpacked.data());
+        }
+        size_t n = segment.lineCount;
+        use(Lines{reinterpret_cast<const time_t*>(payload),
+                  reinterpret_cast<const uint32_t*>(payload + n * sizeof(time_t)),
+                  payload + n * sizeof(time_t) + (n + 1) * sizeof(uint32_t),
+                  segment.lineCount});
+    }
+
+    template<typename Visit>
+    static void visitLine(const Lines& segment, uint32_t line, Visit& visit) {
+        uint32_t start = segment.textStart[line];
+        visit(segment.times[line], string(segment.text + start, segment.textStart[line + 1] - start));
+    }
+
+    template<typename Visit>
+    static void scan(const Lines& segment, const string& term, time_t from, time_t to, Visit& visit) {
+        uint32_t count = segment.count;
+        if (term.empty()) {
+            for (uint32_t line = 0; line < count; line++) {
+                if (segment.times[line] >= from && segment.times[line] <= to) visitLine(segment, line, visit);
+            }
+            return;
+        }
+
+        // One search over the whole block; a match running into the next line is not a match
+        const char* begin = segment.text;
+        const char* end = begin + segment.textStart[count];
+        boyer_moore_horspool_searcher<string::const_iterator> searcher(term.begin(), term.end());
+        const char* at = begin;
+        while (true) {
+            const char* hit = search(at, end, searcher);
+            if (hit == end) break;
+            uint32_t offset = static_cast<uint32_t>(hit - begin);
+            uint32_t line = static_cast<uint32_t>(upper_bound(segment.textStart, segment.textStart + count, offset) -
+                                                  segment.textStart) - 1;
+            if (offset + term.size() <= segment.textStart[line + 1]) {
+                if (segment.times[line] >= from && segment.times[line] <= to) visitLine(segment, line, visit);
+                at = begin + segment.textStart[line + 1];
+            } else {
+                at = hit + 1;
+            }
+        }
+    }
+
+    // Lines holding every trigram of the term, checked for the whole term
+    template<typename Visit>
+    static void lookUp(const Segment& segment, const string& term, const vector<uint32_t>& keys,
+                       time_t from, time_t to, Visit& visit) {
+        vector<pair<const uint16_t*, const uint16_t*>> lists;
+        for (uint32_t key : keys) {
+            auto found = lower_bound(segment.keys.begin(), segment.keys.end(), key);
+            if (found == segment.keys.end() || *found != key) return;
+            size_t k = found - segment.keys.begin();
+            lists.push_back({segment.lines.data() + segment.keyStart[k], segment.lines.data() + segment.keyStart[k + 1]});
+        }
+        sort(lists.begin(), lists.end(), [](const pair<const uint16_t*, const uint16_t*>& a, const pair<const uint16_t*, const uint16_t*>& b) {
+            return a.second - a.first < b.second - b.first;
+        });
+
+        vector<uint16_t> candidates(lists[0].first, lists[0].second), next;
+        for (size_t l = 1; l < lists.size() && !candidates.empty(); l++) {
+            next.clear();
+            set_intersection(candidates.begin(), candidates.end(), lists[l].first, lists[l].second, back_inserter(next));
+            candidates.swap(next);
+        }
+        Lines view = segment.view();
+        for (uint16_t line : candidates) {
+            if (view.times[line] < from || view.times[line] > to) continue;
+            const char* begin = view.text + view.textStart[line];
+            const char* end = view.text + view.textStart[line + 1];
+            if (search(begin, end, term.begin(), term.end()) != end) visitLine(view, line, visit);
+        }
+    }
+
+public:
+    static constexpr size_t SEGMENT_LINES = 4096;   // at most 65536, posting lists hold 16-bit line numbers
+    static constexpr time_t PARTITION_SECONDS = 3600;
+
+    explicit LogStore(size_t memoryBudgetBytes = 4 << 20)
+        : memoryBudget(memoryBudgetBytes), sealedBytes(0), lineCount(0), compression(false), diskBytes(0) {}
+
+    LogStore(const LogStore&) = delete;
+    LogStore& operator=(const LogStore&) = delete;
+
+    void append(time_t time, const string& line) {
+        if (segments.empty() || segments.back().times.size() >= SEGMENT_LINES ||
+            partitionOf(time) != partitionOf(segments.back().firstTime)) {
+            if (!segments.empty()) {
+                seal(segments.back());
+                enforceBudget();
+            }
+            segments.emplace_back();
+            Segment& open = segments.back();
+            open.firstTime = time;
+            open.times.swap(spare.times);
+            open.textStart.swap(spare.textStart);
+            open.text.swap(spare.text);
+            open.textStart.push_back(0);
+        }
+        Segment& open = segments.back();
+        if (open.text.size() + line.size() > UINT32_MAX) {
+            throw length_error("Log segment text is too large");
+        }
+        open.times.push_back(time);
+        open.text += line;
+        open.textStart.push_back(static_cast<uint32_t>(open.text.size()));
+        open.lastTime = time;
+        lineCount++;
+    }
+
+    // Sealed segments beyond the budget spill to disk; the open segment always stays in memory
+    void setMemoryBudget(size_t bytes) {
+        memoryBudget = bytes;
+        enforceBudget();
+    }
+
+    size_t size() const { return lineCount; }
+    size_t getSegmentCount() const { return spilled.size() + segments.size(); }
+    size_t getSpilledCount() const { return spilled.size(); }
+    // Segments in memory and the spare buffers, plus the index of spilled segments
+    size_t getMemoryUsage() const {
+        return sealedBytes + spare.memoryUsage() + (segments.empty() ? 0 : segments.back().memoryUsage()) +
+               spilled.capacity() * sizeof(SpilledSegment);
+    }
+    uint64_t getDiskUsage() const { return diskBytes; }
+
+    // Segments spilled from now on are compressed
+    void setCompression(bool enabled) { compression = enabled; }
+    bool getCompression() const { return compression; }
+
+    void clear() {
+        spilled.clear();
+        segments.clear();
+        sealedBytes = 0;
+        lineCount = 0;
+        diskBytes = 0;
+        lock_guard<mutex> guard(scratchLock);
+        mapping.reset();
+        scratch.reset();
+    }
+
+    // Every line in order, as visit(time, text)
+    template<typename Visit>
+    void forEach(Visit visit) const {
+        static const vector<uint32_t> none;
+        auto visitAll = [&visit](const Lines& lines) {
+            for (uint32_t line = 0; line < lines.count; line++) visitLine(lines, line, visit);
+        };
+        for (const SpilledSegment& segment : spilled) withSpilled(segment, none, visitAll);
+        for (const Segment& segment : segments) visitAll(segment.view());
+    }
+
+    // Lines logged in [from, to] containing the term, in order, as visit(time, text)
+    template<typename Visit>
+    void find(const string& term, time_t from, time_t to, Visit visit) const {
+        vector<uint32_t> keys = trigramsOf(term);
+        auto scanLines = [&](const Lines& lines) { scan(lines, term, from, to, visit); };
+        for (const SpilledSegment& segment : spilled) {
+            if (segment.lastTime >= from && segment.firstTime <= to) withSpilled(segment, keys, scanLines);
+        }
+        for (size_t s = 0; s < segments.size(); s++) {
+            const Segment& segment = segments[s];
+            if (segment.lastTime < from || segment.firstTime > to) continue;
+            if (keys.empty() || s + 1 == segments.size()) {
+                // Terms under three characters and the unindexed open segment are scanned
+                scanLines(segment.view());
+            } else {
+                lookUp(segment, term, keys, from, to, visit);
+            }
+        }
+    }
+};
+
+#endif // LOGSTORE_H
@@ -0,0 +1,211 @@
+#ifndef PIPENETWORK_H
+#define PIPENETWORK_H
+
+#include <string>
+#include <vector>
+#include <tuple>
+#include <unordered_map>
+#include <memory>
+#include <cmath>
+#include <stdexcept>
+
+#include "SparseSolver.h"
+
+using namespace std;
+
+/**
+ * Steady-state flow network of nodes joined by pipes.
+ * Each pipe carries conductance * (head difference) from its higher to its
+ * lower end; source nodes hold a fixed head and every other node draws its
+ * demand. Solving for the heads is a sparse SPD system (the graph Laplacian
+ * with the sources eliminated), which is solved with conjugate gradient
+ * starting from the previous solution; large networks are preconditioned
+ * with aggregation multigrid. Nodes with no path to a source
+ * cannot be supplied and are left out of the solve.
+ */
+class PipeNetwork {
+protected:
+    struct Pipe {
+        size_t from;
+        size_t to;
+        double conductance;
+    };
+
+    static constexpr size_t NONE = static_cast<size_t>(-1);
+    static constexpr size_t MULTIGRID_THRESHOLD = 2000;   // unknowns above which multigrid pays off
+
+    vector<string> nodeNames;
+    unordered_map<string, size_t> nodeIndex;
+    vector<char> isSource;
+    vector<double> sourceHead;
+    vector<Pipe> pipes;
+
+    // Reduced system, rebuilt only when the topology changes
+    bool systemStale;
+    SparseMatrix system;
+    shared_ptr<const AggregationMultigrid> multigrid;   // immutable, so copies of the network share it
+    vector<size_t> unknownOf;      // node -> row of the reduced system (NONE for sources and cut-off nodes)
+    vector<size_t> nodeOfUnknown;
+
+    // Last solution, reused as the starting guess of the next solve
+    vector<double> heads;
+
+    void rebuildSystem() {
+        size_t n = nodeNames.size();
+
+        // Nodes reachable from a source
+        vector<vector<size_t>> adjacent(n);
+        for (const auto& pipe : pipes) {
+            adjacent[pipe.from].push_back(pipe.to);
+            adjacent[pipe.to].push_back(pipe.from);
+        }
+        vector<char> reached(n, 0);
+        vector<size_t> stack;
+        for (size_t i = 0; i < n; i++) {
+            if (isSource[i]) {
+                reached[i] = 1;
+                stack.push_back(i);
+            }
+        }
+        while (!stack.empty()) {
+            size_t node = stack.back();
+            stack.pop_back();
+            for (size_t next : adjacent[node]) {
+                if (!reached[next]) {
+                    reached[next] = 1;
+                    stack.push_back(next);
+                }
+            }
+        }
+
+        unknownOf.assign(n, NONE);
+        nodeOfUnknown.clear();
+        for (size_t i = 0; i < n; i++) {
+            if (reached[i] && !isSource[i]) {
+                unknownOf[i] = nodeOfUnknown.size();
+                nodeOfUnknown.push_back(i);
+            }
+        }
+
+        vector<tuple<size_t, size_t, double>> entries;
+        entries.reserve(pipes.size() * 4);
+        for (const auto& pipe : pipes) {
+            size_t a = unknownOf[pipe.from], b = unknownOf[pipe.to];
+            if (a != NONE) entries.emplace_back(a, a, pipe.conductance);
+            if (b != NONE) entries.emplace_back(b, b, pipe.conductance);
+            if (a != NONE && b != NONE) {
+                entries.emplace_back(a, b, -pipe.conductance);
+                entries.emplace_back(b, a, -pipe.conductance);
+            }
+        }
+        system = SparseMatrix::fromTriplets(nodeOfUnknown.size(), move(entries));
+        multigrid.reset();
+        if (system.rows > MULTIGRID_THRESHOLD) {
+            multigrid = make_shared<const AggregationMultigrid>(system);
+        }
+        heads.resize(n, 0.0);
+        systemStale = false;
+    }
+
+public:
+    struct Solution {
+        vector<double> head;     // per node (0 for nodes cut off from every source)
+        vector<double> flow;     // per pipe, positive from `from` to `to`
+        vector<char> supplied;   // per node: connected to a source
+        SolveResult stats;
+    };
+
+    PipeNetwork() : systemStale(true) {}
+    virtual ~PipeNetwork() = default;
+
+    // Index of a node, added on first use
+    size_t addNode(const string& key) {
+        auto inserted = nodeIndex.emplace(key, nodeNames.size());
+        if (inserted.second) {
+            nodeNames.push_back(key);
+            isSource.push_back(0);
+            sourceHead.push_back(0.0);
+            systemStale = true;
+        }
+        return inserted.first->second;
+    }
+
+    size_t addSource(const string& key, double head) {
+        size_t node = addNode(key);
+        isSource[node] = 1;
+        sourceHead[node] = head;
+        systemStale = true;
+        return node;
+    }
+
+    void addPipe(const string& from, const string& to, double conductance) {
+        if (conductance <= 0) {
+            throw invalid_argument("Pipe conductance must be positive");
+        }
+        size_t a = addNode(from), b = addNode(to);
+        if (a == b) {
+            throw invalid_argument("A pipe must join two different nodes");
+        }
+        pipes.push_back({a, b, conductance});
+        systemStale = true;
+    }
+
+    // demand[node] is drawn at each node (ignored at sources). The tolerance is
+    // relative to the demand, since the source terms would otherwise swamp it
+    Solution solve(const vector<double>& demand, double tolerance = 1e-8) {
+        if (demand.size() != nodeNames.size()) {
+            throw invalid_argument("Demand must be given for every node");
+        }
+        if (systemStale) rebuildSystem();
+
+        size_t unknowns = nodeOfUnknown.size();
+        vector<double> rhs(unknowns), x(unknowns);
+        double demandNorm = 0.0;
+        for (size_t u = 0; u < unknowns; u++) {
+            rhs[u] = -demand[nodeOfUnknown[u]];
+            x[u] = heads[nodeOfUnknown[u]];
+            demandNorm += rhs[u] * rhs[u];
+        }
+        for (const auto& pipe : pipes) {
+            size_t a = unknownOf[pipe.from], b = unknownOf[pipe.to];
+            if (a != NONE && isSource[pipe.to]) rhs[a] += pipe.conductance * sourceHead[pipe.to];
+            if (b != NONE && isSource[pipe.from]) rhs[b] += pipe.conductance * sourceHead[pipe.from];
+        }
+
+        Solution solution;
+        solution.stats = ConjugateGradient::solve(system, rhs, x, tolerance, 0, multigrid.get(), sqrt(demandNorm));
+
+        size_t n = nodeNames.size();
+        solution.head.assign(n, 0.0);
+        solution.supplied.assign(n, 0);
+        for (size_t i = 0; i < n; i++) {
+            if (isSource[i]) {
+                solution.head[i] = sourceHead[i];
+                solution.supplied[i] = 1;
+            } else if (unknownOf[i] != NONE) {
+                solution.head[i] = x[unknownOf[i]];
+                solution.supplied[i] = 1;
+            }
+            heads[i] = solution.head[i];
+        }
+
+        solution.flow.resize(pipes.size());
+        for (size_t p = 0; p < pipes.size(); p++) {
+            solution.flow[p] = pipes[p].conductance * (solution.head[pipes[p].from] - solution.head[pipes[p].to]);
+        }
+        return solution;
+    }
+
+    size_t getNodeCount() const { return nodeNames.size(); }
+    size_t getPipeCount() const { return pipes.size(); }
+    const string& getNodeName(size_t node) const { return nodeNames.at(node); }
+    bool hasNode(const string& key) const { return nodeIndex.count(key) > 0; }
+    size_t getNode(const string& key) const {
+        auto it = nodeIndex.find(key);
+        if (it == nodeIndex.end()) throw out_of_range("Unknown network node: " + key);
+        return it->second;
+    }
+    bool getIsSource(size_t node) const { return isSource.at(node) != 0; }
+};
+
+#endif // PIPENETWORK_H
@@ -9,12 +9,17 @@
 #include <stdexcept>
 #include <ctime>
 #include <iomanip>
+#include <memory>
 
 #include "buildings.h"
 #include "transport.h"
 #include "Citizens.h"
 #include "Services.h"
 #include "HousingScheme.h"
+#include "PollutionGrid.h"
+#include "BinaryLog.h"
+#include "LogLevel.h"
+#include "LogSink.h"
 
 using namespace std;
 
@@ -24,6 +29,22 @@ class Citizen;
 class Services;
 class HousingScheme;
 
+// Amount each pollution level rises by when one entity is monitored
+struct PollutionDeposit {
+    double air;
+    double water;
+    double noise;
+    double solidWaste;
+};
+
+// Current pollution levels, each on a 0-100 scale
+struct PollutionLevels {
+    double air;
+    double water;
+    double noise;
+    double solidWaste;
+};
+
 // PollutionControl class that monitors and regulates pollution levels in the city
 //This is a friend class to all major components
  
@@ -35,44 +56,223 @@ private:
     double noisePollutionLevel;
     double solidWasteLevel;
     
+    // Spatial grid (optional); when attached the levels above are the grid's layer totals after each tick
+    unique_ptr<PollutionGrid> grid;
+    
+    // When traffic noise comes from the street network, vehicles only add air pollution here
+    bool noiseFromStreets;
+    
+    // When a water network is attached it supplies the wastewater figure, so water accounts add none here
+    bool waterFromNetwork;
+    
+    // Threshold warnings and reduction measures are also printed to cout, unless turned off
+    bool consoleOutput;
+    
     // Threshold - limit for each pollution level
     const double AIR_POLLUTION_THRESHOLD = 50.0;
     const double WATER_POLLUTION_THRESHOLD = 30.0;
     const double NOISE_POLLUTION_THRESHOLD = 60.0;
     const double SOLID_WASTE_THRESHOLD = 40.0;
     
-    // creating a file to entere the date and time for each entry 
-    ofstream logFile;
+    // Where the timestamped entries go (the owning city's pollution log), if anywhere
+    shared_ptr<LogSink> logSink;
+    LogFilter logFilter;
+    time_t cachedTime;
+    string cachedTimestamp;
+    
+    // When set, monitoring events are written to it unformatted instead of to the text log
+    shared_ptr<BinaryLog> binaryLog;
+    
+    // Call sites test these before building a message, so filtered messages cost no string work
+    bool logging(LogLevel level, LogCategory category) const {
+        return logFilter.enabled(level, category);
+    }
+    
+    bool logging(LogEvent event) const {
+        return logFilter.enabled(logEventLevel(event), logEventCategory(event));
+    }
     
     // Private helper to log events
     void logEvent(const string& event) {
-        time_t now = time(0);
-        struct tm tstruct;
-        char buf[80];
-        tstruct = *localtime(&now);
-        strftime(buf, sizeof(buf), "%Y-%m-%d %X", &tstruct);
+        if (!logSink) return;
         
-        if (logFile.is_open()) {
-            logFile << "[" << buf << "] " << event << endl;
+        // The timestamp only changes once a second
+        time_t now = time(0);
+        if (now != cachedTime) {
+            struct tm tstruct;
+            char buf[80];
+            // Reentrant variant, cities may be simulated on several threads
+#ifdef _WIN32
+            localtime_s(&tstruct, &now);
+#else
+            localtime_r(&now, &tstruct);
+#endif
+            strftime(buf, sizeof(buf), "%Y-%m-%d %X", &tstruct);
+            cachedTime = now;
+            cachedTimestamp = buf;
+        }
+        logSink->write("[" + cachedTimestamp + "] " + event);
+    }
+    
+    // Structured event: raw arguments to the binary log, or the formatted text to the log file
+    template<typename... Args>
+    void logEvent(LogEvent event, const Args&... args) {
+        if (binaryLog) {
+            binaryLog->write(event, args...);
+        } else if (logSink) {
+            logEvent(BinaryLog::format(event, args...));
         }
     }
     
 public:
-    // Constructor
-    PollutionControl()  : airPollutionLevel(0.0), waterPollutionLevel(0.0), noisePollutionLevel(0.0), solidWasteLevel(0.0) {
-        // Open log file
-        logFile.open("pollution_control.log", ios::app);
-        if (!logFile.is_open()) {
-            cout << "Warning: cant open pollution control log file!!!" << endl;
+    // Constructor: entries go to the sink, or nowhere without one
+    explicit PollutionControl(shared_ptr<LogSink> sink = nullptr)
+        : airPollutionLevel(0.0), waterPollutionLevel(0.0), noisePollutionLevel(0.0), solidWasteLevel(0.0),
+          noiseFromStreets(false), waterFromNetwork(false), consoleOutput(true), logSink(move(sink)), cachedTime(-1) {
+        if (logging(LogLevel::INFO, LogCategory::GENERAL)) {
+            logEvent("Pollution Control System initialized");
         }
-        logEvent("Pollution Control System initialized");
     }
     
-    // Destructor to close log file
+    // Copy constructor: copies the pollution levels; the copy logs nowhere until it is given a sink
+    PollutionControl(const PollutionControl& other)
+        : airPollutionLevel(other.airPollutionLevel), waterPollutionLevel(other.waterPollutionLevel),
+          noisePollutionLevel(other.noisePollutionLevel), solidWasteLevel(other.solidWasteLevel),
+          grid(other.grid ? make_unique<PollutionGrid>(*other.grid) : nullptr), noiseFromStreets(other.noiseFromStreets),
+          waterFromNetwork(other.waterFromNetwork), consoleOutput(other.consoleOutput),
+          logFilter(other.logFilter), cachedTime(-1) {
+        if (logging(LogLevel::INFO, LogCategory::GENERAL)) {
+            logEvent("Pollution Control System copied");
+        }
+    }
+    
+    // Destructor: writes out what the sink still holds
     ~PollutionControl() {
-        if (logFile.is_open()) {
-            logEvent("Pollution Control System shutdown!!");
-            logFile.close();
+        if (logSink) {
+            if (logging(LogLevel::INFO, LogCategory::GENERAL)) {
+                logEvent("Pollution Control System shutdown!!");
+            }
+            logSink->flush();
+        }
+    }
+    
+    void setConsoleOutput(bool enabled) { consoleOutput = enabled; }
+    bool getConsoleOutput() const { return consoleOutput; }
+    
+    void setLogSink(shared_ptr<LogSink> sink) {
+        if (logSink) logSink->flush();
+        logSink = move(sink);
+    }
+    
+    void flushLog() {
+        if (logSink) logSink->flush();
+    }
+    
+    void setBinaryLog(shared_ptr<BinaryLog> log) { binaryLog = move(log); }
+    void setLogFilter(const LogFilter& filter) { logFilter = filter; }
+    
+    // Per-entity deposit rules, shared by the monitor functions and the sampled estimator
+    static PollutionDeposit buildingDeposit(const Building* building) {
+        double impact = building->getEcoScoreImpact();
+        return {(impact > 0) ? impact * 0.1 : 0, 0.0, 0.0, 0.0};
+    }
+    
+    static PollutionDeposit transportDeposit(const Transport* transport) {
+        return emissionsDeposit(transport->getCarbonEmissions());
+    }
+    
+    // Any release of vehicle emissions (a monitored vehicle or a single trip)
+    static PollutionDeposit emissionsDeposit(double emissions) {
+        return {emissions * 0.05, 0.0, (emissions > 10) ? emissions * 0.02 : 0, 0.0};
+    }
+    
+    static PollutionDeposit citizenDeposit(const Citizen* citizen) {
+        double distance = citizen->getTotalDistanceTraveled();
+        return {(distance > 20) ? distance * 0.01 : 0, 0.0, 0.0, 0.0};
+    }
+    
+    static PollutionDeposit serviceDeposit(const Services* service) {
+        string serviceType = service->getServiceType();
+        double reading = service->getAverageReading();
+        PollutionDeposit deposit = {0.0, 0.0, 0.0, 0.0};
+        if (serviceType == "Water") {
+            deposit.water = reading * 0.02;
+        } 
+        else if (serviceType == "Electricity") {
+            deposit.air = reading * 0.03;
+        }
+        else if (serviceType == "Gas") {
+            deposit.air = reading * 0.04;
+        }
+        return deposit;
+    }
+    
+    // Wastewater from mains supply, plus contamination risk in zones running below service pressure
+    static PollutionDeposit waterNetworkDeposit(double suppliedCubicMeters, size_t lowPressureZones) {
+        return {0.0, suppliedCubicMeters * 0.01 + lowPressureZones * 5.0, 0.0, 0.0};
+    }
+    
+    // A street segment at or above the loud level, by how far it exceeds it
+    static PollutionDeposit streetNoiseDeposit(double levelDb, double loudDb) {
+        return {0.0, 0.0, (levelDb > loudDb) ? (levelDb - loudDb) * 0.1 : 0.0, 0.0};
+    }
+    
+    static PollutionDeposit housingDeposit(const HousingScheme* housing) {
+        return {housing->getAveragePollution() * 0.02, housing->getAveragePollution() * 0.01,
+                0.0, housing->getOccupiedUnits() * 0.1};
+    }
+    
+    // Add a deposit to the current levels; with a grid it lands in the location's cell,
+    // or is spread over the whole city when there is no location
+    void addDeposit(const PollutionDeposit& deposit, double weight = 1.0, const Address* location = nullptr) {
+        airPollutionLevel += deposit.air * weight;
+        waterPollutionLevel += deposit.water * weight;
+        noisePollutionLevel += deposit.noise * weight;
+        solidWasteLevel += deposit.solidWaste * weight;
+        
+        if (!grid) return;
+        const pair<PollutionKind, double> amounts[] = {
+            {PollutionKind::AIR, deposit.air * weight}, {PollutionKind::WATER, deposit.water * weight},
+            {PollutionKind::NOISE, deposit.noise * weight}, {PollutionKind::SOLID_WASTE, deposit.solidWaste * weight}};
+        for (const auto& amount : amounts) {
+            if (amount.second == 0) continue;
+            if (location) {
+                grid->deposit(*location, amount.first, amount.second);
+            } else {
+                grid->depositUniform(amount.first, amount.second);
+            }
+        }
+    }
+    
+    // Attach a spatial grid; pollution already present is spread evenly over it
+    void attachGrid(unique_ptr<PollutionGrid> pollutionGrid) {
+        grid = move(pollutionGrid);
+        if (grid) {
+            grid->depositUniform(PollutionKind::AIR, airPollutionLevel);
+            grid->depositUniform(PollutionKind::WATER, waterPollutionLevel);
+            grid->depositUniform(PollutionKind::NOISE, noisePollutionLevel);
+            grid->depositUniform(PollutionKind::SOLID_WASTE, solidWasteLevel);
+        }
+        if (logging(LogLevel::INFO, LogCategory::GENERAL)) {
+            logEvent(grid ? "Pollution grid attached: " + to_string(grid->getWidth()) + "x" + to_string(grid->getHeight())
+                          : string("Pollution grid removed"));
+        }
+    }
+    
+    bool hasGrid() const { return grid != nullptr; }
+    const PollutionGrid* getGrid() const { return grid.get(); }
+    
+    // Diffuse and decay the grid for one tick, then take the citywide levels from its totals
+    void advanceGrid() {
+        if (!grid) return;
+        grid->step();
+        airPollutionLevel = grid->getTotal(PollutionKind::AIR);
+        waterPollutionLevel = grid->getTotal(PollutionKind::WATER);
+        noisePollutionLevel = grid->getTotal(PollutionKind::NOISE);
+        solidWasteLevel = grid->getTotal(PollutionKind::SOLID_WASTE);
+        if (logging(LogLevel::VERBOSE, LogCategory::POLLUTION)) {
+            logEvent("Pollution grid advanced. Air: " + to_string(airPollutionLevel) + ", Water: " + to_string(waterPollutionLevel) +
+                     ", Noise: " + to_string(noisePollutionLevel) + ", Solid waste: " + to_string(solidWasteLevel));
         }
     }
     
@@ -81,10 +281,11 @@ public:
         if (!building) return;
 
         // Increment air pollution based on building's eco score impact
-        double impact = building->getEcoScoreImpact();
-        airPollutionLevel += (impact > 0) ? impact * 0.1 : 0;
+        addDeposit(buildingDeposit(building), 1.0, &building->getAddress());
         
-        logEvent("Monitored building: " + string(building->getName()) + ", Impact: " + to_string(impact));
+        if (logging(LogEvent::MONITORED_BUILDING)) {
+            logEvent(LogEvent::MONITORED_BUILDING, building->getName(), building->getEcoScoreImpact());
+        }
         
         // Alert if threshold exceeded
         checkThresholds();
@@ -95,28 +296,33 @@ public:
         if (!transport) return;
 
         // Increment air pollution based on vehicle's carbon emissions
-        double emissions = transport->getCarbonEmissions();
-        airPollutionLevel += emissions * 0.05;
-        noisePollutionLevel += (emissions > 10) ? emissions * 0.02 : 0;
+        PollutionDeposit deposit = transportDeposit(transport);
+        if (noiseFromStreets) deposit.noise = 0.0;
+        addDeposit(deposit);
         
-        logEvent("Monitored transport: " + string(transport->getType()) +  ", Emissions: " + to_string(emissions));
+        if (logging(LogEvent::MONITORED_TRANSPORT)) {
+            logEvent(LogEvent::MONITORED_TRANSPORT, transport->getType(), transport->getCarbonEmissions());
+        }
         
         // Alert if threshold exceeded
         checkThresholds();
     }
     
-    // Monitor Citizen activities
-    void monitorCitizen(const Citizen* citizen) {
+    // Monitor Citizen activities (weight > 1 stands for a cohort of identical citizens)
+    void monitorCitizen(const Citizen* citizen, size_t weight = 1) {
         if (!citizen) return;
 
-        // Using the eco score to measure citizen impact
-        double ecoScore = citizen->calculateEcoScore();
-        double distance = citizen->getTotalDistanceTraveled();
-        
         // Adjust pollution levels based on citizen activity
-        airPollutionLevel += (distance > 20) ? distance * 0.01 : 0;
+        addDeposit(citizenDeposit(citizen), weight);
         
-        logEvent("Monitored citizen with eco score: " + to_string(ecoScore) + ", Distance traveled: " + to_string(distance));
+        // Using the eco score to measure citizen impact
+        if (weight > 1) {
+            if (logging(LogEvent::MONITORED_COHORT)) {
+                logEvent(LogEvent::MONITORED_COHORT, weight, citizen->calculateEcoScore(), citizen->getTotalDistanceTraveled());
+            }
+        } else if (logging(LogEvent::MONITORED_CITIZEN)) {
+            logEvent(LogEvent::MONITORED_CITIZEN, citizen->calculateEcoScore(), citizen->getTotalDistanceTraveled());
+        }
         
         // Alert if threshold exceeded
         checkThresholds();
@@ -127,20 +333,57 @@ public:
         if (!service) return;
 
         // Different services affect different pollution types
-        string serviceType = service->getServiceType();
-        double reading = service->getAverageReading();
-
-        if (serviceType == "Water") {
-            waterPollutionLevel += reading * 0.02;
-        } 
-        else if (serviceType == "Electricity") {
-            airPollutionLevel += reading * 0.03;
+        PollutionDeposit deposit = serviceDeposit(service);
+        if (waterFromNetwork) deposit.water = 0.0;
+        addDeposit(deposit, 1.0, service->getServiceAddress());
+        
+        if (logging(LogEvent::MONITORED_SERVICE)) {
+            logEvent(LogEvent::MONITORED_SERVICE, service->getServiceType(), service->getAverageReading());
         }
-        else if (serviceType == "Gas") {
-            airPollutionLevel += reading * 0.04;
+        
+        // Alert if threshold exceeded
+        checkThresholds();
+    }
+    
+    // Monitor the water network after its daily solve
+    void monitorWaterNetwork(double suppliedCubicMeters, size_t lowPressureZones) {
+        addDeposit(waterNetworkDeposit(suppliedCubicMeters, lowPressureZones));
+        
+        if (logging(LogLevel::VERBOSE, LogCategory::MONITORING)) {
+            logEvent("Monitored water network: " + to_string(suppliedCubicMeters) + " m^3 supplied, " +
+                     to_string(lowPressureZones) + " low-pressure zones");
         }
         
-        logEvent("Monitored service: " + serviceType + ", Reading: " + to_string(reading));
+        // Alert if threshold exceeded
+        checkThresholds();
+    }
+    
+    // Take traffic noise from the street network instead of from each vehicle's emissions
+    void setNoiseFromStreets(bool enabled) {
+        noiseFromStreets = enabled;
+        if (logging(LogLevel::INFO, LogCategory::GENERAL)) {
+            logEvent(enabled ? "Traffic noise taken from the street network" : "Traffic noise taken from vehicle emissions");
+        }
+    }
+    
+    bool isNoiseFromStreets() const { return noiseFromStreets; }
+    
+    // Take water pollution from the water network's daily supply instead of from each water account
+    void setWaterFromNetwork(bool enabled) {
+        waterFromNetwork = enabled;
+        if (logging(LogLevel::INFO, LogCategory::GENERAL)) {
+            logEvent(enabled ? "Water pollution taken from the water network" : "Water pollution taken from water accounts");
+        }
+    }
+    
+    bool isWaterFromNetwork() const { return waterFromNetwork; }
+    
+    // Monitor street noise after the daily traffic pass (segment deposits are added by the caller)
+    void monitorStreetNoise(size_t loudSegments, double maxLevelDb) {
+        if (logging(LogLevel::VERBOSE, LogCategory::MONITORING)) {
+            logEvent("Monitored street noise: " + to_string(loudSegments) + " loud segments, loudest " +
+                     to_string(maxLevelDb) + " dB");
+        }
         
         // Alert if threshold exceeded
         checkThresholds();
@@ -151,11 +394,12 @@ public:
         if (!housing) return;
 
         // Housing affects multiple pollution types
-        airPollutionLevel += housing->getAveragePollution() * 0.02;
-        waterPollutionLevel += housing->getAveragePollution() * 0.01;
-        solidWasteLevel += housing->getOccupiedUnits() * 0.1;
+        Address location = housing->getLocation();
+        addDeposit(housingDeposit(housing), 1.0, &location);
         
-        logEvent("Monitored housing scheme: " + housing->getSchemeName() + ", Average pollution: " + to_string(housing->getAveragePollution()));
+        if (logging(LogEvent::MONITORED_HOUSING)) {
+            logEvent(LogEvent::MONITORED_HOUSING, housing->getSchemeName(), housing->getAveragePollution());
+        }
         
         // Alert if threshold exceeded
         checkThresholds();
@@ -164,50 +408,64 @@ public:
     // Check all thresholds and issue warnings
     void checkThresholds() {
         if (airPollutionLevel > AIR_POLLUTION_THRESHOLD) {
-            cout << "WARNING: Air pollution level exceeded threshold!" << endl;
-            logEvent("WARNING: Air pollution level exceeded threshold: " + to_string(airPollutionLevel));
+            if (consoleOutput) cout << "WARNING: Air pollution level exceeded threshold!" << endl;
+            if (logging(LogEvent::AIR_THRESHOLD)) {
+                logEvent(LogEvent::AIR_THRESHOLD, airPollutionLevel);
+            }
         }
         
         if (waterPollutionLevel > WATER_POLLUTION_THRESHOLD) {
-            cout << "WARNING: Water pollution level exceeded threshold!" << endl;
-            logEvent("WARNING: Water pollution level exceeded threshold: " + to_string(waterPollutionLevel));
+            if (consoleOutput) cout << "WARNING: Water pollution level exceeded threshold!" << endl;
+            if (logging(LogEvent::WATER_THRESHOLD)) {
+                logEvent(LogEvent::WATER_THRESHOLD, waterPollutionLevel);
+            }
         }
         
         if (noisePollutionLevel > NOISE_POLLUTION_THRESHOLD) {
-            cout << "WARNING: Noise pollution level exceeded threshold!" << endl;
-            logEvent("WARNING: Noise pollution level exceeded threshold: " + to_string(noisePollutionLevel));
+            if (consoleOutput) cout << "WARNING: Noise pollution level exceeded threshold!" << endl;
+            if (logging(LogEvent::NOISE_THRESHOLD)) {
+                logEvent(LogEvent::NOISE_THRESHOLD, noisePollutionLevel);
+            }
         }
         
         if (solidWasteLevel > SOLID_WASTE_THRESHOLD) {
-            cout << "WARNING: Solid waste level exceeded threshold!" << endl;
-            logEvent("WARNING: Solid waste level exceeded threshold: " + to_string(solidWasteLevel));
+            if (consoleOutput) cout << "WARNING: Solid waste level exceeded threshold!" << endl;
+            if (logging(LogEvent::SOLID_WASTE_THRESHOLD)) {
+                logEvent(LogEvent::SOLID_WASTE_THRESHOLD, solidWasteLevel);
+            }
         }
     }
     
     // Generate pollution report
     void generateReport() const {
-        cout << "\n----- Pollution Control Report -----" << endl;
-        cout << "Air Pollution Level: " << airPollutionLevel << " / 100" << endl;
-        cout << "Water Pollution Level: " << waterPollutionLevel << " / 100" << endl;
-        cout << "Noise Pollution Level: " << noisePollutionLevel << " / 100" << endl;
-        cout << "Solid Waste Level: " << solidWasteLevel << " / 100" << endl;
+        writeReport(cout, getLevels());
+        cout.flush();
+    }
+    
+    // Write the pollution report for the given levels to out, without flushing
+    static void writeReport(ostream& out, const PollutionLevels& levels) {
+        out << "\n----- Pollution Control Report -----\n";
+        out << "Air Pollution Level: " << levels.air << " / 100\n";
+        out << "Water Pollution Level: " << levels.water << " / 100\n";
+        out << "Noise Pollution Level: " << levels.noise << " / 100\n";
+        out << "Solid Waste Level: " << levels.solidWaste << " / 100\n";
         
         // Overall status
-        double avgPollution = (airPollutionLevel+waterPollutionLevel+noisePollutionLevel+solidWasteLevel)/4.0;
+        double avgPollution = (levels.air + levels.water + levels.noise + levels.solidWaste) / 4.0;
         
-        cout << "Overall Pollution Status: ";
+        out << "Overall Pollution Status: ";
         if (avgPollution < 20) {
-            cout << "Excellent - Very low pollution levels!" << endl;
+            out << "Excellent - Very low pollution levels!\n";
         } else if (avgPollution < 40) {
-            cout << "Good - Moderate pollution levels!" << endl;
+            out << "Good - Moderate pollution levels!\n";
         } else if (avgPollution < 60) {
-            cout << "Warning - High pollution levels!" << endl;
+            out << "Warning - High pollution levels!\n";
         } else if (avgPollution < 80) {
-            cout << "Danger - Very high pollution levels!" << endl;
+            out << "Danger - Very high pollution levels!\n";
         } else {
-            cout << "Critical - Extreme pollution levels!" << endl;
+            out << "Critical - Extreme pollution levels!\n";
         }
-        cout << "----------------------------------" << endl;
+        out << "----------------------------------\n";
     }
     
     // Implement pollution reduction measures
@@ -216,26 +474,38 @@ public:
         
         if (airPollutionLevel > AIR_POLLUTION_THRESHOLD) {
             airPollutionLevel *= (1 - reductionFactor);
-            cout << "Implementing air pollution reduction measures..." << endl;
-            logEvent("Air pollution reduction measures implemented. New level: " + to_string(airPollutionLevel));
+            if (grid) grid->scale(PollutionKind::AIR, 1 - reductionFactor);
+            if (consoleOutput) cout << "Implementing air pollution reduction measures..." << endl;
+            if (logging(LogLevel::INFO, LogCategory::POLLUTION)) {
+                logEvent("Air pollution reduction measures implemented. New level: " + to_string(airPollutionLevel));
+            }
         }
         
         if (waterPollutionLevel > WATER_POLLUTION_THRESHOLD) {
             waterPollutionLevel *= (1 - reductionFactor);
-            cout << "Implementing water pollution reduction measures..." << endl;
-            logEvent("Water pollution reduction measures implemented. New level: " + to_string(waterPollutionLevel));
+            if (grid) grid->scale(PollutionKind::WATER, 1 - reductionFactor);
+            if (consoleOutput) cout << "Implementing water pollution reduction measures..." << endl;
+            if (logging(LogLevel::INFO, LogCategory::POLLUTION)) {
+                logEvent("Water pollution reduction measures implemented. New level: " + to_string(waterPollutionLevel));
+            }
         }
         
         if (noisePollutionLevel > NOISE_POLLUTION_THRESHOLD) {
             noisePollutionLevel *= (1 - reductionFactor);
-            cout << "Implementing noise reduction measures..." << endl;
-            logEvent("Noise pollution reduction measures implemented. New level: " + to_string(noisePollutionLevel));
+            if (grid) grid->scale(PollutionKind::NOISE, 1 - reductionFactor);
+            if (consoleOutput) cout << "Implementing noise reduction measures..." << endl;
+            if (logging(LogLevel::INFO, LogCategory::POLLUTION)) {
+                logEvent("Noise pollution reduction measures implemented. New level: " + to_string(noisePollutionLevel));
+            }
         }
         
         if (solidWasteLevel > SOLID_WASTE_THRESHOLD) {
             solidWasteLevel *= (1 - reductionFactor);
-            cout << "Implementing waste management measures..." << endl;
-            logEvent("Waste management measures implemented. New level: " + to_string(solidWasteLevel));
+            if (grid) grid->scale(PollutionKind::SOLID_WASTE, 1 - reductionFactor);
+            if (consoleOutput) cout << "Implementing waste management measures..." << endl;
+            if (logging(LogLevel::INFO, LogCategory::POLLUTION)) {
+                logEvent("Waste management measures implemented. New level: " + to_string(solidWasteLevel));
+            }
         }
     }
     
@@ -244,6 +514,9 @@ public:
     double getWaterPollutionLevel() const { return waterPollutionLevel; }
     double getNoisePollutionLevel() const { return noisePollutionLevel; }
     double getSolidWasteLevel() const { return solidWasteLevel; }
+    PollutionLevels getLevels() const {
+        return PollutionLevels{airPollutionLevel, waterPollutionLevel, noisePollutionLevel, solidWasteLevel};
+    }
 };
 
 #endif // POLLUTIONCONTROL_H
\ No newline at end of file
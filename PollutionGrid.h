@@ -0,0 +1,215 @@
+#ifndef POLLUTIONGRID_H
+#define POLLUTIONGRID_H
+
+#include <vector>
+#include <array>
+#include <memory>
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define POLLUTIONGRID_SSE2 1
+#endif
+
+#include "Address.h"
+#include "EventScheduler.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+// Per-tick spread and loss of one pollution kind
+struct GridLayerRates {
+    float diffusion;   // share exchanged with each of the four neighbours, at most 0.25
+    float decay;       // share lost per tick
+};
+
+/**
+ * Pollution concentration over a 2D grid of the city, one layer per pollution kind.
+ * Streets run along x and house numbers along y. Every tick each layer is
+ * diffused with a five-point stencil (edges reflect, so diffusion keeps the total)
+ * and decayed. Rows are split over a thread pool and the inner loop works on four
+ * cells at a time with SSE2. Layers are stored as floats and stepped one at a
+ * time through a single scratch buffer, so a 4096x4096 grid needs about 320 MB.
+ */
+class PollutionGrid {
+public:
+    static constexpr size_t LAYERS = 4;
+
+private:
+    size_t width;
+    size_t height;
+    int streetsPerCell;
+    int housesPerCell;
+    array<vector<float>, LAYERS> layers;
+    array<GridLayerRates, LAYERS> rates;
+    array<double, LAYERS> pendingUniform;   // deposits without a location, spread evenly on the next tick
+    array<double, LAYERS> totals;           // layer sums after the last tick
+    vector<float> scratch;
+    vector<double> rowSums;
+    shared_ptr<ThreadPool> pool;            // shared with copies of the grid
+
+    // dst = keep * (src + d * (neighbours - 4 * src)) + add, for rows [first, last); row sums go to rowSums
+    void stencilRows(const float* src, float* dst, size_t first, size_t last, float d, float keep, float add) {
+        const float centre = keep * (1.0f - 4.0f * d);
+        const float side = keep * d;
+        for (size_t y = first; y < last; y++) {
+            const float* row = src + y * width;
+            const float* up = (y > 0) ? row - width : row;
+            const float* down = (y + 1 < height) ? row + width : row;
+            float* out = dst + y * width;
+            double sum = 0.0;
+
+            if (width == 1) {
+                out[0] = centre * row[0] + side * (2.0f * row[0] + up[0] + down[0]) + add;
+                rowSums[y] = out[0];
+                continue;
+            }
+
+            out[0] = centre * row[0] + side * (row[0] + row[1] + up[0] + down[0]) + add;
+            sum += out[0];
+
+            size_t x = 1;
+#ifdef POLLUTIONGRID_SSE2
+            const __m128 vCentre = _mm_set1_ps(centre);
+            const __m128 vSide = _mm_set1_ps(side);
+            const __m128 vAdd = _mm_set1_ps(add);
+            __m128d sumLow = _mm_setzero_pd(), sumHigh = _mm_setzero_pd();
+            for (; x + 4 < width; x += 4) {
+                __m128 neighbours = _mm_add_ps(_mm_add_ps(_mm_loadu_ps(row + x - 1), _mm_loadu_ps(row + x + 1)),
+                                               _mm_add_ps(_mm_loadu_ps(up + x), _mm_loadu_ps(down + x)));
+                __m128 value = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vCentre, _mm_loadu_ps(row + x)),
+                                                     _mm_mul_ps(vSide, neighbours)), vAdd);
+                _mm_storeu_ps(out + x, value);
+                sumLow = _mm_add_pd(sumLow, _mm_cvtps_pd(value));
+                sumHigh = _mm_add_pd(sumHigh, _mm_cvtps_pd(_mm_movehl_ps(value, value)));
+            }
+            double lanes[2];
+            _mm_storeu_pd(lanes, _mm_add_pd(sumLow, sumHigh));
+            sum += lanes[0] + lanes[1];
+#endif
+            for (; x + 1 < width; x++) {
+                out[x] = centre * row[x] + side * (row[x - 1] + row[x + 1] + up[x] + down[x]) + add;
+                sum += out[x];
+            }
+
+            size_t last = width - 1;
+            out[last] = centre * row[last] + side * (row[last - 1] + row[last] + up[last] + down[last]) + add;
+            sum += out[last];
+            rowSums[y] = sum;
+        }
+    }
+
+    // Row sums are added in row order, so totals do not depend on how rows were split
+    double sumRows() const {
+        double total = 0.0;
+        for (double s : rowSums) total += s;
+        return total;
+    }
+
+public:
+    // threadCount = 0 uses every hardware thread
+    PollutionGrid(size_t gridWidth, size_t gridHeight, int streetsPerGridCell = 1, int housesPerGridCell = 1,
+                  size_t threadCount = 0)
+        : width(gridWidth), height(gridHeight), streetsPerCell(streetsPerGridCell), housesPerCell(housesPerGridCell),
+          pendingUniform{}, totals{}, pool(make_shared<ThreadPool>(threadCount)) {
+        if (width == 0 || height == 0) {
+            throw invalid_argument("Pollution grid needs at least one cell");
+        }
+        if (streetsPerCell <= 0 || housesPerCell <= 0) {
+            throw invalid_argument("Streets and houses per cell must be positive");
+        }
+        for (auto& layer : layers) layer.assign(width * height, 0.0f);
+        scratch.resize(width * height);
+        rowSums.resize(height);
+
+        rates[static_cast<size_t>(PollutionKind::AIR)] = {0.20f, 0.05f};
+        rates[static_cast<size_t>(PollutionKind::WATER)] = {0.10f, 0.03f};
+        rates[static_cast<size_t>(PollutionKind::NOISE)] = {0.24f, 0.50f};
+        rates[static_cast<size_t>(PollutionKind::SOLID_WASTE)] = {0.00f, 0.01f};
+    }
+
+    size_t getWidth() const { return width; }
+    size_t getHeight() const { return height; }
+
+    void setRates(PollutionKind kind, const GridLayerRates& layerRates) {
+        if (layerRates.diffusion < 0 || layerRates.diffusion > 0.25f || layerRates.decay < 0 || layerRates.decay > 1) {
+            throw invalid_argument("Diffusion must be within [0, 0.25] and decay within [0, 1]");
+        }
+        rates[static_cast<size_t>(kind)] = layerRates;
+    }
+
+    // Cell of an address; addresses beyond the grid land on its edge
+    size_t cellOf(const Address& address) const {
+        size_t x = min(width - 1, static_cast<size_t>(max(0, address.streetNo) / streetsPerCell));
+        size_t y = min(height - 1, static_cast<size_t>(max(0, address.houseNo) / housesPerCell));
+        return y * width + x;
+    }
+
+    void deposit(const Address& address, PollutionKind kind, double amount) {
+        layers[static_cast<size_t>(kind)][cellOf(address)] += static_cast<float>(amount);
+    }
+
+    // Pollution without a location is spread over the whole grid on the next tick
+    void depositUniform(PollutionKind kind, double amount) {
+        pendingUniform[static_cast<size_t>(kind)] += amount;
+    }
+
+    // Diffuse and decay every layer once
+    void step() {
+        double cells = static_cast<double>(width) * height;
+        for (size_t k = 0; k < LAYERS; k++) {
+            const GridLayerRates& r = rates[k];
+            float keep = 1.0f - r.decay;
+            // A uniform field is unchanged by diffusion, so the spread-out deposit is just added
+            float add = static_cast<float>(keep * pendingUniform[k] / cells);
+            const float* src = layers[k].data();
+            float* dst = scratch.data();
+            pool->parallelFor(0, height, [&](size_t first, size_t last) {
+                stencilRows(src, dst, first, last, r.diffusion, keep, add);
+            }, 16);
+            layers[k].swap(scratch);
+            pendingUniform[k] = 0.0;
+            totals[k] = sumRows();
+        }
+    }
+
+    // Scale one layer, e.g. after reduction measures
+    void scale(PollutionKind kind, double factor) {
+        size_t k = static_cast<size_t>(kind);
+        float f = static_cast<float>(factor);
+        float* data = layers[k].data();
+        pool->parallelFor(0, height, [&](size_t first, size_t last) {
+            for (size_t y = first; y < last; y++) {
+                double sum = 0.0;
+                float* row = data + y * width;
+                for (size_t x = 0; x < width; x++) {
+                    row[x] *= f;
+                    sum += row[x];
+                }
+                rowSums[y] = sum;
+            }
+        }, 16);
+        pendingUniform[k] *= factor;
+        totals[k] = sumRows();
+    }
+
+    // Sum of a layer after the last tick (or scale), i.e. the citywide level
+    double getTotal(PollutionKind kind) const { return totals[static_cast<size_t>(kind)]; }
+
+    double getConcentration(size_t x, size_t y, PollutionKind kind) const {
+        if (x >= width || y >= height) {
+            throw out_of_range("Cell is outside the pollution grid");
+        }
+        return layers[static_cast<size_t>(kind)][y * width + x];
+    }
+
+    double getConcentration(const Address& address, PollutionKind kind) const {
+        return layers[static_cast<size_t>(kind)][cellOf(address)];
+    }
+
+    // Read-only view of a whole layer, row-major
+    const float* getLayer(PollutionKind kind) const { return layers[static_cast<size_t>(kind)].data(); }
+};
+
+#endif // POLLUTIONGRID_H
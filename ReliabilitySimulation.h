@@ -0,0 +1,297 @@
+#ifndef RELIABILITYSIMULATION_H
+#define RELIABILITYSIMULATION_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <array>
+#include <mutex>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+
+#include "City.h"
+#include "Services.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+/**
+ * Philox4x32-10 counter-based generator.
+ * Every draw is a pure function of (key, counter), so a trial's random stream
+ * does not depend on which thread runs it or in what order.
+ */
+class CounterRng {
+private:
+    array<uint32_t, 2> key;
+    array<uint32_t, 4> counter;
+    array<uint32_t, 4> block;
+    int used;
+
+    static array<uint32_t, 4> philox(array<uint32_t, 4> ctr, array<uint32_t, 2> k) {
+        for (int round = 0; round < 10; round++) {
+            uint64_t p0 = uint64_t(0xD2511F53u) * ctr[0];
+            uint64_t p1 = uint64_t(0xCD9E8D57u) * ctr[2];
+            ctr = {uint32_t(p1 >> 32) ^ ctr[1] ^ k[0], uint32_t(p1),
+                   uint32_t(p0 >> 32) ^ ctr[3] ^ k[1], uint32_t(p0)};
+            k[0] += 0x9E3779B9u;
+            k[1] += 0xBB67AE85u;
+        }
+        return ctr;
+    }
+
+public:
+    // One stream per (seed, stream id, substream id)
+    CounterRng(uint64_t seed, uint32_t stream, uint32_t substream)
+        : key{uint32_t(seed), uint32_t(seed >> 32)}, counter{stream, substream, 0, 0}, block{}, used(4) {}
+
+    uint32_t next() {
+        if (used == 4) {
+            block = philox(counter, key);
+            if (++counter[2] == 0) counter[3]++;
+            used = 0;
+        }
+        return block[used++];
+    }
+
+    // Uniform in (0, 1), never exactly 0 or 1
+    double uniform() {
+        uint64_t bits = (uint64_t(next()) << 32 | next()) >> 11;
+        return (double(bits) + 0.5) * (1.0 / 9007199254740992.0);
+    }
+
+    double exponential(double mean) { return -mean * log(uniform()); }
+
+    double normal() {
+        double u1 = uniform(), u2 = uniform();
+        return sqrt(-2.0 * log(u1)) * cos(6.283185307179586 * u2);
+    }
+};
+
+/**
+ * Failure and repair process of one service type: failures arrive at random
+ * (exponential time between failures) and repairs take a lognormal time.
+ */
+struct FailureModel {
+    double meanDaysBetweenFailures;
+    double medianRepairHours;
+    double repairSpread;     // sigma of log(repair time)
+
+    double meanRepairHours() const { return medianRepairHours * exp(repairSpread * repairSpread / 2.0); }
+};
+
+struct ServiceReliability {
+    size_t service;                 // index in the city
+    string serviceType;
+    double expectedAvailability;    // share of the horizon the service was up, averaged over trials
+    double meanOutages;
+    double meanDowntimeHours;
+    double p50DowntimeHours;
+    double p95DowntimeHours;
+    double p99DowntimeHours;
+    double outageFreeShare;         // share of trials without a single outage
+};
+
+// Outages per service over the horizon, pooled over every service of one type and every trial
+struct OutageDistribution {
+    static constexpr size_t MAX_COUNT = 16;   // the last bucket holds MAX_COUNT or more outages
+
+    string serviceType;
+    size_t services;
+    double expectedAvailability;
+    array<uint64_t, MAX_COUNT + 1> outageCounts;
+
+    double shareWithOutages(size_t count) const {
+        uint64_t total = 0;
+        for (uint64_t c : outageCounts) total += c;
+        return total ? double(outageCounts[min(count, MAX_COUNT)]) / total : 0.0;
+    }
+};
+
+struct ReliabilityReport {
+    size_t trials;
+    int horizonDays;
+    uint64_t seed;
+    vector<ServiceReliability> services;      // ordered by service index
+    vector<OutageDistribution> serviceTypes;  // ordered by type name
+    double cityP50DowntimeHours;              // service-hours lost citywide per trial
+    double cityP95DowntimeHours;
+
+    void display() const {
+        cout << "\n===== SERVICE RELIABILITY (" << trials << " trials over " << horizonDays << " days) =====" << endl;
+        for (const auto& type : serviceTypes) {
+            cout << type.serviceType << ": " << type.services << " services, expected availability "
+                 << type.expectedAvailability * 100.0 << "%, no outage in "
+                 << type.shareWithOutages(0) * 100.0 << "% of service-trials" << endl;
+        }
+        cout << "Citywide service-hours lost per trial: median " << cityP50DowntimeHours
+             << ", 95th percentile " << cityP95DowntimeHours << endl;
+        cout << "=============================================" << endl;
+    }
+};
+
+/**
+ * Monte Carlo reliability of a city's services.
+ * Every service runs the same number of independent trials of its type's
+ * failure and repair process. Trial t of service s draws from the Philox
+ * stream (seed, s, t), so results are identical for any thread count.
+ */
+class ReliabilitySimulation {
+private:
+    const City& city;
+    map<string, FailureModel> models;
+    FailureModel defaultModel;
+    ThreadPool pool;
+
+    // Downtime hours of one trial; outages counts the failures that started within the horizon
+    static double runTrial(const FailureModel& model, double horizonHours, CounterRng& rng, size_t& outages) {
+        double meanUpHours = model.meanDaysBetweenFailures * 24.0;
+        double time = 0.0, downtime = 0.0;
+        outages = 0;
+        while (true) {
+            time += rng.exponential(meanUpHours);
+            if (time >= horizonHours) break;
+            double repair = model.medianRepairHours * exp(model.repairSpread * rng.normal());
+            downtime += min(repair, horizonHours - time);
+            outages++;
+            time += repair;
+        }
+        return downtime;
+    }
+
+    // Value at quantile q of values (reordered)
+    static double quantile(vector<double>& values, double q) {
+        if (values.empty()) return 0.0;
+        size_t k = min(values.size() - 1, size_t(q * values.size()));
+        nth_element(values.begin(), values.begin() + k, values.end());
+        return values[k];
+    }
+
+public:
+    // threadCount = 0 uses every hardware thread
+    ReliabilitySimulation(const City& c, size_t threadCount = 0)
+        : city(c), defaultModel{180.0, 4.0, 0.8}, pool(threadCount) {
+        models["Electricity"] = {120.0, 2.0, 0.8};
+        models["Water"] = {200.0, 4.0, 0.7};
+        models["Gas"] = {365.0, 6.0, 0.6};
+        models["Internet"] = {60.0, 3.0, 1.0};
+    }
+
+    void setFailureModel(const string& serviceType, const FailureModel& model) {
+        if (model.meanDaysBetweenFailures <= 0 || model.medianRepairHours <= 0 || model.repairSpread < 0) {
+            throw invalid_argument("Failure model needs positive failure and repair times");
+        }
+        models[serviceType] = model;
+    }
+
+    const FailureModel& getFailureModel(const string& serviceType) const {
+        auto it = models.find(serviceType);
+        return it != models.end() ? it->second : defaultModel;
+    }
+
+    // Simulate every active service; inactive services are left out of the report
+    ReliabilityReport run(size_t trials, int horizonDays, uint64_t seed = 12345) {
+        if (trials == 0 || horizonDays <= 0) {
+            throw invalid_argument("Reliability simulation needs at least one trial and one day");
+        }
+        if (trials > UINT32_MAX || city.getServiceCount() > UINT32_MAX) {
+            throw out_of_range("Too many trials or services for the random streams");
+        }
+
+        ReliabilityReport report{};
+        report.trials = trials;
+        report.horizonDays = horizonDays;
+        report.seed = seed;
+
+        vector<size_t> active;
+        for (size_t i = 0; i < city.getServiceCount(); i++) {
+            if (city.getService(i).getIsActive()) active.push_back(i);
+        }
+        report.services.resize(active.size());
+
+        double horizonHours = horizonDays * 24.0;
+        // Citywide totals and outage histograms are integers so merging chunks in any order gives the same result
+        vector<int64_t> cityDowntimeSeconds(trials, 0);
+        map<string, array<uint64_t, OutageDistribution::MAX_COUNT + 1>> histograms;
+        mutex mergeLock;
+
+        pool.parallelFor(0, active.size(), [&](size_t first, size_t last) {
+            vector<double> downtime(trials);
+            vector<int64_t> localCity(trials, 0);
+            map<string, array<uint64_t, OutageDistribution::MAX_COUNT + 1>> localHistograms;
+
+            for (size_t a = first; a < last; a++) {
+                const Services& service = city.getService(active[a]);
+                const FailureModel& model = getFailureModel(service.getServiceType());
+                auto& histogram = localHistograms.emplace(service.getServiceType(),
+                    array<uint64_t, OutageDistribution::MAX_COUNT + 1>{}).first->second;
+
+                double totalDowntime = 0.0;
+                size_t totalOutages = 0, outageFree = 0;
+                for (size_t t = 0; t < trials; t++) {
+                    CounterRng rng(seed, uint32_t(active[a]), uint32_t(t));
+                    size_t outages;
+                    downtime[t] = runTrial(model, horizonHours, rng, outages);
+                    totalDowntime += downtime[t];
+                    totalOutages += outages;
+                    if (outages == 0) outageFree++;
+                    histogram[min(outages, OutageDistribution::MAX_COUNT)]++;
+                    localCity[t] += llround(downtime[t] * 3600.0);
+                }
+
+                ServiceReliability& result = report.services[a];
+                result.service = active[a];
+                result.serviceType = service.getServiceType();
+                result.meanDowntimeHours = totalDowntime / trials;
+                result.expectedAvailability = 1.0 - result.meanDowntimeHours / horizonHours;
+                result.meanOutages = double(totalOutages) / trials;
+                result.outageFreeShare = double(outageFree) / trials;
+                result.p50DowntimeHours = quantile(downtime, 0.50);
+                result.p95DowntimeHours = quantile(downtime, 0.95);
+                result.p99DowntimeHours = quantile(downtime, 0.99);
+            }
+
+            lock_guard<mutex> lock(mergeLock);
+            for (size_t t = 0; t < trials; t++) cityDowntimeSeconds[t] += localCity[t];
+            for (const auto& entry : localHistograms) {
+                auto& total = histograms.emplace(entry.first, array<uint64_t, OutageDistribution::MAX_COUNT + 1>{}).first->second;
+                for (size_t k = 0; k <= OutageDistribution::MAX_COUNT; k++) total[k] += entry.second[k];
+            }
+        });
+
+        for (const auto& entry : histograms) {
+            OutageDistribution type{entry.first, 0, 0.0, entry.second};
+            for (const auto& result : report.services) {
+                if (result.serviceType != entry.first) continue;
+                type.services++;
+                type.expectedAvailability += result.expectedAvailability;
+            }
+            type.expectedAvailability /= type.services;
+            report.serviceTypes.push_back(type);
+        }
+
+        vector<double> cityHours(trials);
+        for (size_t t = 0; t < trials; t++) cityHours[t] = cityDowntimeSeconds[t] / 3600.0;
+        report.cityP50DowntimeHours = quantile(cityHours, 0.50);
+        report.cityP95DowntimeHours = quantile(cityHours, 0.95);
+        return report;
+    }
+
+    // Set each simulated service's reliability score to its expected availability
+    static void applyTo(City& target, const ReliabilityReport& report) {
+        const City& view = target;
+        for (const auto& result : report.services) {
+            if (result.service >= target.getServiceCount()) {
+                throw out_of_range("Reliability report does not match this city");
+            }
+            double score = min(100.0, max(0.0, result.expectedAvailability * 100.0));
+            if (view.getService(result.service).getReliabilityScore() != score) {
+                target.getService(result.service).setReliabilityScore(score);
+            }
+        }
+    }
+};
+
+#endif // RELIABILITYSIMULATION_H
@@ -0,0 +1,358 @@
+#ifndef SAMPLEDSIMULATION_H
+#define SAMPLEDSIMULATION_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <random>
+#include <cmath>
+#include <stdexcept>
+#include <algorithm>
+
+#include "City.h"
+
+using namespace std;
+
+/**
+ * A sampled estimate with the half-width of its confidence interval
+ */
+struct Estimate {
+    double value;
+    double margin;
+
+    double lower() const { return value - margin; }
+    double upper() const { return value + margin; }
+};
+
+/**
+ * Approximate state of the city at the end of one projected day
+ */
+struct ApproximateDay {
+    int day;
+    Estimate ecoScore;
+    Estimate airPollution;
+    Estimate waterPollution;
+    Estimate noisePollution;
+    Estimate solidWaste;
+};
+
+/**
+ * Approximate projection of City::simulateDays().
+ *
+ * Citizens, buildings, vehicles, housing schemes and services are split into strata
+ * by subtype and a random sample is drawn from every stratum. Only the sampled units
+ * are simulated, on private copies so the city itself is left untouched, and each
+ * unit's contribution to updateEcoScore() and to PollutionControl is scaled up by the
+ * size of its stratum. Confidence intervals come from the stratified variance
+ * with finite population correction.
+ *
+ * Units are stepped one at a time, so only the per-entity part of a day is
+ * modelled. Cities with pending events or any of the city-wide models that
+ * couple entities (commute routing, traffic, energy balance, utility networks,
+ * street noise, the pollution grid) are refused.
+ */
+class SampledSimulation {
+private:
+    enum class UnitKind { CITIZEN, BUILDING, VEHICLE, HOUSING, SERVICE };
+
+    // Number of metrics estimated per unit: eco score deduction + 4 pollution levels
+    static const int METRICS = 5;
+
+    struct Stratum {
+        string name;
+        size_t population;
+        vector<size_t> sampleUnits;   // indices into units
+    };
+
+    struct SampledUnit {
+        UnitKind kind;
+        double categorySize;          // entity count of the unit's category (averages in updateEcoScore)
+        unique_ptr<Citizen> citizen;  // private copies of mutable entities
+        unique_ptr<Building> building;
+        const Transport* vehicle;     // read-only entities are not copied
+        const HousingScheme* housing;
+        const Services* service;
+        PollutionDeposit cumulative;  // total deposited since the projection started
+        double average;               // current contribution to the category average
+    };
+
+    City& city;
+    double sampleFraction;
+    mt19937 rng;
+    vector<Stratum> strata;
+    vector<SampledUnit> units;
+    map<const Building*, unique_ptr<Building>> buildingCopies;
+    map<const Transport*, unique_ptr<Transport>> transportCopies;
+
+    // Private copy of a building or transport a sampled citizen points to
+    Building* privateBuilding(const Building* original) {
+        auto& copy = buildingCopies[original];
+        if (!copy) copy = original->clone();
+        return copy.get();
+    }
+
+    Transport* privateTransport(const Transport* original) {
+        auto& copy = transportCopies[original];
+        if (!copy) copy = original->clone();
+        return copy.get();
+    }
+
+    // Draw a simple random sample of the given members for one stratum
+    template<typename T>
+    void addStratum(const string& name, const vector<const T*>& members, double categorySize) {
+        Stratum stratum;
+        stratum.name = name;
+        stratum.population = members.size();
+
+        // At least two units per stratum so the within-stratum variance is defined
+        size_t sampleSize = static_cast<size_t>(ceil(sampleFraction * members.size()));
+        sampleSize = min(members.size(), max(sampleSize, size_t(2)));
+
+        // Partial Fisher-Yates shuffle
+        vector<size_t> order(members.size());
+        iota(order.begin(), order.end(), 0);
+        for (size_t i = 0; i < sampleSize; i++) {
+            uniform_int_distribution<size_t> pick(i, order.size() - 1);
+            swap(order[i], order[pick(rng)]);
+
+            stratum.sampleUnits.push_back(units.size());
+            units.push_back(makeUnit(*members[order[i]], categorySize));
+        }
+        strata.push_back(move(stratum));
+    }
+
+    static SampledUnit emptyUnit(UnitKind kind, double categorySize) {
+        return {kind, categorySize, nullptr, nullptr, nullptr, nullptr, nullptr, {0.0, 0.0, 0.0, 0.0}, 0.0};
+    }
+
+    SampledUnit makeUnit(const Citizen& citizen, double categorySize) {
+        SampledUnit unit = emptyUnit(UnitKind::CITIZEN, categorySize);
+        unit.citizen = make_unique<Citizen>(citizen);
+        if (unit.citizen->getBuilding()) unit.citizen->assignBuilding(privateBuilding(unit.citizen->getBuilding()));
+        if (unit.citizen->getTransport()) unit.citizen->chooseTransport(privateTransport(unit.citizen->getTransport()));
+        return unit;
+    }
+
+    SampledUnit makeUnit(const Building& building, double categorySize) {
+        SampledUnit unit = emptyUnit(UnitKind::BUILDING, categorySize);
+        unit.building = building.clone();
+        return unit;
+    }
+
+    SampledUnit makeUnit(const Transport& vehicle, double categorySize) {
+        SampledUnit unit = emptyUnit(UnitKind::VEHICLE, categorySize);
+        unit.vehicle = &vehicle;
+        return unit;
+    }
+
+    SampledUnit makeUnit(const HousingScheme& housing, double categorySize) {
+        SampledUnit unit = emptyUnit(UnitKind::HOUSING, categorySize);
+        unit.housing = &housing;
+        return unit;
+    }
+
+    SampledUnit makeUnit(const Services& service, double categorySize) {
+        SampledUnit unit = emptyUnit(UnitKind::SERVICE, categorySize);
+        unit.service = &service;
+        return unit;
+    }
+
+    // The first enabled part of City::simulateDay() that sampling does not model, or null
+    static const char* unsupportedFeature(const City& city) {
+        if (city.scheduler.getPendingCount() > 0) return "scheduled events";
+        if (city.commuteRouter) return "commute routing";
+        if (city.trafficAssignment) return "traffic assignment";
+        if (city.energyBalance) return "the energy balance";
+        if (city.waterNetwork) return "the water network";
+        if (city.gasNetwork) return "the gas network";
+        if (city.internetContention) return "internet contention";
+        if (city.streetNetwork) return "street noise";
+        if (city.pollutionControl->hasGrid()) return "the pollution grid";
+        return nullptr;
+    }
+
+    // Advance one sampled unit by a day: the per-entity steps of City::simulateDay()
+    void stepUnit(SampledUnit& unit) {
+        PollutionDeposit deposit = {0.0, 0.0, 0.0, 0.0};
+        switch (unit.kind) {
+            case UnitKind::CITIZEN:
+                unit.citizen->simulateDay();
+                deposit = PollutionControl::citizenDeposit(unit.citizen.get());
+                unit.average = City::citizenEcoImpact(*unit.citizen);
+                break;
+            case UnitKind::BUILDING:
+                unit.building->updateEcoScore();
+                deposit = PollutionControl::buildingDeposit(unit.building.get());
+                unit.average = unit.building->getEcoScoreImpact();
+                break;
+            case UnitKind::VEHICLE:
+                deposit = PollutionControl::transportDeposit(unit.vehicle);
+                unit.average = City::transportEcoImpact(*unit.vehicle);
+                break;
+            case UnitKind::HOUSING:
+                deposit = PollutionControl::housingDeposit(unit.housing);
+                unit.average = City::housingEcoImpact(*unit.housing);
+                break;
+            case UnitKind::SERVICE:
+                deposit = PollutionControl::serviceDeposit(unit.service);
+                unit.average = City::serviceEcoImpact(*unit.service);
+                break;
+        }
+        unit.cumulative.air += deposit.air;
+        unit.cumulative.water += deposit.water;
+        unit.cumulative.noise += deposit.noise;
+        unit.cumulative.solidWaste += deposit.solidWaste;
+    }
+
+    // Stratum labels for the building and housing kinds
+    static const char* kindName(BuildingKind kind) {
+        switch (kind) {
+            case BuildingKind::RESIDENTIAL: return "Residential";
+            case BuildingKind::COMMERCIAL: return "Commercial";
+            case BuildingKind::GREEN_BUILDING: return "Green";
+            case BuildingKind::INDUSTRIAL: return "Industrial";
+            case BuildingKind::RECREATIONAL: return "Recreational";
+            case BuildingKind::EDUCATIONAL: return "Educational";
+            default: return "Other";
+        }
+    }
+
+    static const char* kindName(HousingKind kind) {
+        switch (kind) {
+            case HousingKind::APARTMENT: return "Apartment";
+            case HousingKind::VILLA: return "Villa";
+            default: return "Other";
+        }
+    }
+
+    // The unit's share of each estimated total
+    static void unitMetrics(const SampledUnit& unit, double (&y)[METRICS]) {
+        const PollutionDeposit& c = unit.cumulative;
+        y[0] = unit.average / unit.categorySize +
+               City::pollutionEcoImpact(c.air, c.water, c.noise, c.solidWaste);
+        y[1] = c.air;
+        y[2] = c.water;
+        y[3] = c.noise;
+        y[4] = c.solidWaste;
+    }
+
+public:
+    SampledSimulation(City& c, double fraction, unsigned seed = 12345)
+        : city(c), sampleFraction(fraction), rng(seed) {
+        if (fraction <= 0.0 || fraction > 1.0) {
+            throw invalid_argument("Sample fraction must be in (0, 1]");
+        }
+        if (const char* feature = unsupportedFeature(city)) {
+            throw runtime_error(string("Sampled simulation does not model ") + feature);
+        }
+
+        // Members of cohorts must carry their current state before being copied
+        if (city.cohortMode) city.syncCohortMembers();
+
+        // Citizens are stratified by transport type, everything else by its own kind
+        map<string, vector<const Citizen*>> citizenStrata;
+        for (const auto& citizen : city.citizens) {
+            string key = citizen->getTransport() ? citizen->getTransport()->getType() : "None";
+            citizenStrata["Citizen/" + key].push_back(citizen.get());
+        }
+        for (const auto& [name, members] : citizenStrata) {
+            addStratum(name, members, city.citizens.size());
+        }
+
+        map<BuildingKind, vector<const Building*>> buildingStrata;
+        for (const auto& building : city.buildings) {
+            buildingStrata[building->getKind()].push_back(building.get());
+        }
+        for (const auto& [kind, members] : buildingStrata) {
+            addStratum(string("Building/") + kindName(kind), members, city.buildings.size());
+        }
+
+        map<string, vector<const Transport*>> vehicleStrata;
+        for (const auto& vehicle : city.vehicles) {
+            vehicleStrata["Transport/" + vehicle->getType()].push_back(vehicle.get());
+        }
+        for (const auto& [name, members] : vehicleStrata) {
+            addStratum(name, members, city.vehicles.size());
+        }
+
+        map<HousingKind, vector<const HousingScheme*>> housingStrata;
+        for (const auto& housing : city.housingSchemes) {
+            housingStrata[housing->getKind()].push_back(housing.get());
+        }
+        for (const auto& [kind, members] : housingStrata) {
+            addStratum(string("Housing/") + kindName(kind), members, city.housingSchemes.size());
+        }
+
+        map<string, vector<const Services*>> serviceStrata;
+        for (const auto& service : city.services) {
+            serviceStrata["Service/" + service->getServiceType()].push_back(service.get());
+        }
+        for (const auto& [name, members] : serviceStrata) {
+            addStratum(name, members, city.services.size());
+        }
+    }
+
+    // Project the city forward; z = 1.96 gives 95% confidence intervals
+    vector<ApproximateDay> run(int numDays, double z = 1.96) {
+        if (numDays <= 0) {
+            throw invalid_argument("Number of days must be positive");
+        }
+
+        const PollutionControl& pc = *city.pollutionControl;
+        double startLevels[METRICS] = {
+            City::pollutionEcoImpact(pc.getAirPollutionLevel(), pc.getWaterPollutionLevel(),
+                                     pc.getNoisePollutionLevel(), pc.getSolidWasteLevel()),
+            pc.getAirPollutionLevel(), pc.getWaterPollutionLevel(),
+            pc.getNoisePollutionLevel(), pc.getSolidWasteLevel()
+        };
+
+        vector<ApproximateDay> results;
+        for (int d = 1; d <= numDays; d++) {
+            for (auto& unit : units) {
+                stepUnit(unit);
+            }
+
+            // Stratified totals and their variances
+            double total[METRICS] = {0.0};
+            double variance[METRICS] = {0.0};
+            for (const auto& stratum : strata) {
+                size_t n = stratum.sampleUnits.size();
+                double N = stratum.population;
+                double sum[METRICS] = {0.0}, sumSq[METRICS] = {0.0};
+                for (size_t index : stratum.sampleUnits) {
+                    double y[METRICS];
+                    unitMetrics(units[index], y);
+                    for (int m = 0; m < METRICS; m++) {
+                        sum[m] += y[m];
+                        sumSq[m] += y[m] * y[m];
+                    }
+                }
+                for (int m = 0; m < METRICS; m++) {
+                    double mean = sum[m] / n;
+                    total[m] += N * mean;
+                    if (n > 1 && n < N) {
+                        double s2 = max(0.0, (sumSq[m] - n * mean * mean) / (n - 1));
+                        variance[m] += N * N * (1.0 - n / N) * s2 / n;
+                    }
+                }
+            }
+
+            ApproximateDay result;
+            result.day = city.day + d;
+            double score = 100.0 - startLevels[0] - total[0];
+            result.ecoScore = {max(0.0, min(100.0, score)), z * sqrt(variance[0])};
+            result.airPollution = {startLevels[1] + total[1], z * sqrt(variance[1])};
+            result.waterPollution = {startLevels[2] + total[2], z * sqrt(variance[2])};
+            result.noisePollution = {startLevels[3] + total[3], z * sqrt(variance[3])};
+            result.solidWaste = {startLevels[4] + total[4], z * sqrt(variance[4])};
+            results.push_back(result);
+        }
+        return results;
+    }
+
+    size_t getSampleSize() const { return units.size(); }
+    size_t getStrataCount() const { return strata.size(); }
+};
+
+#endif // SAMPLEDSIMULATION_H
@@ -0,0 +1,211 @@
+#ifndef SCENARIOSWEEP_H
+#define SCENARIOSWEEP_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+
+#include "City.h"
+#include "ElectricityManagement.h"
+#include "WaterManagement.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+/**
+ * One point of a parameter grid. Unset fields keep the base city's value.
+ */
+struct ScenarioVariant {
+    int id;
+    optional<double> budget;
+    optional<ElectricityPlan> electricityPlan;
+    optional<WaterTariffPlan> waterPlan;
+    optional<int> industriesWithPollutionControl; // first N industrial buildings get control installed
+    vector<int> measureDays;                      // sweep days on which implementPollutionMeasures() runs
+
+    string describe() const {
+        stringstream ss;
+        ss << "variant " << id;
+        if (budget) ss << " budget=" << *budget;
+        if (electricityPlan) ss << " electricityPlan=" << static_cast<int>(*electricityPlan);
+        if (waterPlan) ss << " waterPlan=" << static_cast<int>(*waterPlan);
+        if (industriesWithPollutionControl) ss << " controlledIndustries=" << *industriesWithPollutionControl;
+        if (!measureDays.empty()) {
+            ss << " measureDays=";
+            for (size_t i = 0; i < measureDays.size(); i++) {
+                ss << (i ? "/" : "") << measureDays[i];
+            }
+        }
+        return ss.str();
+    }
+};
+
+/**
+ * Values to sweep per parameter; the variants are the cartesian product
+ * of all non-empty dimensions.
+ */
+struct ParameterGrid {
+    vector<double> budgets;
+    vector<ElectricityPlan> electricityPlans;
+    vector<WaterTariffPlan> waterPlans;
+    vector<int> industriesWithPollutionControl;
+    vector<vector<int>> measureSchedules;
+
+    vector<ScenarioVariant> expand() const {
+        vector<ScenarioVariant> variants(1);
+        variants[0].id = 0;
+
+        // Multiply the current set of variants by one dimension
+        auto cross = [&variants](size_t count, const function<void(ScenarioVariant&, size_t)>& apply) {
+            if (count == 0) return;
+            vector<ScenarioVariant> next;
+            for (const auto& variant : variants) {
+                for (size_t i = 0; i < count; i++) {
+                    next.push_back(variant);
+                    apply(next.back(), i);
+                }
+            }
+            variants.swap(next);
+        };
+
+        cross(budgets.size(), [this](ScenarioVariant& v, size_t i) { v.budget = budgets[i]; });
+        cross(electricityPlans.size(), [this](ScenarioVariant& v, size_t i) { v.electricityPlan = electricityPlans[i]; });
+        cross(waterPlans.size(), [this](ScenarioVariant& v, size_t i) { v.waterPlan = waterPlans[i]; });
+        cross(industriesWithPollutionControl.size(),
+              [this](ScenarioVariant& v, size_t i) { v.industriesWithPollutionControl = industriesWithPollutionControl[i]; });
+        cross(measureSchedules.size(), [this](ScenarioVariant& v, size_t i) { v.measureDays = measureSchedules[i]; });
+
+        for (size_t i = 0; i < variants.size(); i++) {
+            variants[i].id = static_cast<int>(i);
+        }
+        return variants;
+    }
+};
+
+// One row of the results table: the state of one variant at the end of one day
+struct SweepRow {
+    int variant;
+    int day;
+    double ecoScore;
+    double budget;
+    double airPollution;
+    double waterPollution;
+    double noisePollution;
+    double solidWaste;
+};
+
+struct SweepResults {
+    vector<ScenarioVariant> variants;
+    vector<SweepRow> rows;   // ordered by variant, then day
+
+    void writeCsv(ostream& out) const {
+        out << "variant,day,ecoScore,budget,airPollution,waterPollution,noisePollution,solidWaste\n";
+        for (const auto& row : rows) {
+            out << row.variant << "," << row.day << "," << row.ecoScore << "," << row.budget << ","
+                << row.airPollution << "," << row.waterPollution << "," << row.noisePollution << ","
+                << row.solidWaste << "\n";
+        }
+    }
+};
+
+/**
+ * Runs every variant of a parameter grid against its own fork of a base city.
+ * Variants run concurrently on a work-stealing pool and their daily eco score,
+ * budget and pollution series are gathered into one results table.
+ */
+class ScenarioSweep {
+private:
+    const City& baseCity;
+    ParameterGrid grid;
+    ThreadPool pool;
+
+    static void applyVariant(City& city, const ScenarioVariant& variant) {
+        if (variant.budget) {
+            city.setBudget(*variant.budget);
+        }
+
+        // Entities are fetched through the city's const view first so only
+        // the ones a variant actually changes get copied out of the base city
+        const City& view = city;
+        for (size_t i = 0; i < city.getServiceCount(); i++) {
+            const Services& service = view.getService(i);
+            if (variant.electricityPlan && dynamic_cast<const ElectricityManagement*>(&service)) {
+                static_cast<ElectricityManagement&>(city.getService(i)).setCurrentPlan(*variant.electricityPlan);
+            }
+            if (variant.waterPlan && dynamic_cast<const WaterManagement*>(&service)) {
+                static_cast<WaterManagement&>(city.getService(i)).setCurrentPlan(*variant.waterPlan);
+            }
+        }
+
+        if (variant.industriesWithPollutionControl) {
+            int remaining = *variant.industriesWithPollutionControl;
+            for (size_t i = 0; i < city.getBuildingCount(); i++) {
+                auto* industrial = dynamic_cast<const IndustrialBuilding*>(&view.getBuilding(i));
+                if (!industrial) continue;
+                if (industrial->getHasPollutionControl() != (remaining > 0)) {
+                    static_cast<IndustrialBuilding&>(city.getBuilding(i)).setHasPollutionControl(remaining > 0);
+                }
+                remaining--;
+            }
+        }
+    }
+
+    static vector<SweepRow> runVariant(const City& base, const ScenarioVariant& variant, int numDays) {
+        unique_ptr<City> city = base.fork(base.getName() + "#" + to_string(variant.id));
+        // Variants run on several threads at once, so their console messages would interleave
+        city->setConsoleOutput(false);
+        applyVariant(*city, variant);
+
+        vector<SweepRow> rows;
+        rows.reserve(numDays);
+        for (int d = 1; d <= numDays; d++) {
+            city->simulateDay();
+            if (find(variant.measureDays.begin(), variant.measureDays.end(), d) != variant.measureDays.end()) {
+                city->implementPollutionMeasures();
+            }
+
+            const PollutionControl& pc = city->getPollutionControl();
+            rows.push_back({variant.id, city->getDay(), city->getEcoScore(), city->getBudget(),
+                            pc.getAirPollutionLevel(), pc.getWaterPollutionLevel(),
+                            pc.getNoisePollutionLevel(), pc.getSolidWasteLevel()});
+        }
+        return rows;
+    }
+
+public:
+    // threadCount = 0 uses every hardware thread
+    ScenarioSweep(const City& base, const ParameterGrid& parameters, size_t threadCount = 0)
+        : baseCity(base), grid(parameters), pool(threadCount) {}
+
+    SweepResults run(int numDays) {
+        if (numDays <= 0) {
+            throw invalid_argument("Number of days must be positive");
+        }
+
+        SweepResults results;
+        results.variants = grid.expand();
+
+        vector<future<vector<SweepRow>>> pending;
+        for (const auto& variant : results.variants) {
+            const City& base = baseCity;
+            pending.push_back(pool.submit([&base, variant, numDays] {
+                return runVariant(base, variant, numDays);
+            }));
+        }
+
+        // Collect in variant order so the table does not depend on scheduling
+        for (auto& result : pending) {
+            vector<SweepRow> rows = pool.wait(result);
+            results.rows.insert(results.rows.end(), rows.begin(), rows.end());
+        }
+        return results;
+    }
+};
+
+#endif // SCENARIOSWEEP_H
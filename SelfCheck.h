@@ -0,0 +1,49 @@
+#ifndef SELFCHECK_H
+#define SELFCHECK_H
+
+#include <iostream>
+#include <string>
+#include <random>
+#include <stdexcept>
+
+using namespace std;
+
+/**
+ * Scaffolding shared by the check programs.
+ * A check program hands its body to run(), which seeds the random generator
+ * from the optional command line argument, counts failed checks and turns
+ * them, or an escaping exception, into exit status 1.
+ */
+namespace SelfCheck {
+
+    inline int failures = 0;
+
+    inline void check(bool ok, const string& what) {
+        if (!ok) {
+            cerr << "FAILED: " << what << endl;
+            failures++;
+        }
+    }
+
+    // Runs body(rng) for: <name> [seed]
+    template<typename Body>
+    int run(const string& name, int argc, char* argv[], const Body& body) {
+        unsigned seed = 1;
+        try {
+            if (argc > 1) seed = static_cast<unsigned>(stoul(argv[1]));
+            mt19937 rng(seed);
+            body(rng);
+        } catch (const exception& e) {
+            cerr << "Error: " << e.what() << endl;
+            return 1;
+        }
+        if (failures > 0) {
+            cerr << failures << " check(s) failed" << endl;
+            return 1;
+        }
+        cout << name << ": all checks passed (seed " << seed << ")" << endl;
+        return 0;
+    }
+}
+
+#endif // SELFCHECK_H
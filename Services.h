@@ -6,12 +6,14 @@
 #include <vector>
 #include <stdexcept>
 #include <limits>
+#include <memory>
 
 using namespace std;
 
 // Forward declaration
 class PollutionControl;
 class City;
+struct Address;
 
 /**
  * Abstract base class for all city services
@@ -34,6 +36,10 @@ public:
     // Pure virtual functions to be implemented by derived classes
     virtual void supply() = 0;
     virtual void showStatus() = 0;
+    virtual unique_ptr<Services> clone() const = 0;
+    
+    // Where the service is delivered, if it has a fixed address
+    virtual const Address* getServiceAddress() const { return nullptr; }
     
     // Common functions for all services
     string getServiceType() const { return serviceType; }
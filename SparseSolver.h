@@ -0,0 +1,382 @@
+#ifndef SPARSESOLVER_H
+#define SPARSESOLVER_H
+
+#include <vector>
+#include <tuple>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+/**
+ * Square sparse matrix in compressed sparse row form
+ */
+struct SparseMatrix {
+    size_t rows = 0;
+    vector<size_t> rowStart;   // rows + 1 offsets into column/value
+    vector<uint32_t> column;   // 32-bit to keep the matrix-vector product's memory traffic down
+    vector<double> value;
+
+    // Assemble from (row, column, value) entries; duplicates are summed
+    static SparseMatrix fromTriplets(size_t n, vector<tuple<size_t, size_t, double>> entries) {
+        sort(entries.begin(), entries.end(), [](const tuple<size_t, size_t, double>& a, const tuple<size_t, size_t, double>& b) {
+            return get<0>(a) != get<0>(b) ? get<0>(a) < get<0>(b) : get<1>(a) < get<1>(b);
+        });
+
+        if (n > UINT32_MAX) {
+            throw length_error("Sparse matrix too large");
+        }
+        SparseMatrix m;
+        m.rows = n;
+        m.rowStart.assign(n + 1, 0);
+        for (size_t i = 0; i < entries.size(); i++) {
+            size_t r = get<0>(entries[i]), c = get<1>(entries[i]);
+            if (r >= n || c >= n) {
+                throw out_of_range("Sparse matrix entry outside the matrix");
+            }
+            if (i > 0 && get<0>(entries[i - 1]) == r && get<1>(entries[i - 1]) == c) {
+                m.value.back() += get<2>(entries[i]);
+                continue;
+            }
+            m.column.push_back(static_cast<uint32_t>(c));
+            m.value.push_back(get<2>(entries[i]));
+            m.rowStart[r + 1]++;
+        }
+        for (size_t r = 0; r < n; r++) {
+            m.rowStart[r + 1] += m.rowStart[r];
+        }
+        return m;
+    }
+
+    // y = A x
+    void multiply(const vector<double>& x, vector<double>& y) const {
+        y.resize(rows);
+        for (size_t r = 0; r < rows; r++) {
+            double sum = 0.0;
+            for (size_t k = rowStart[r]; k < rowStart[r + 1]; k++) {
+                sum += value[k] * x[column[k]];
+            }
+            y[r] = sum;
+        }
+    }
+
+    vector<double> diagonal() const {
+        vector<double> d(rows, 0.0);
+        for (size_t r = 0; r < rows; r++) {
+            for (size_t k = rowStart[r]; k < rowStart[r + 1]; k++) {
+                if (column[k] == r) d[r] += value[k];
+            }
+        }
+        return d;
+    }
+};
+
+/**
+ * Aggregation multigrid preconditioner.
+ * Each level groups every node with its strongly connected neighbours into
+ * one coarse node (piecewise-constant interpolation) and forms the Galerkin
+ * coarse matrix; the coarsest level is factored densely. apply() runs one
+ * V-cycle with a forward Gauss-Seidel sweep on the way down and a backward
+ * sweep on the way up, which keeps the preconditioner symmetric for CG.
+ * Setup is paid once per matrix; the iteration count then grows only slowly
+ * with network size, unlike plain Jacobi.
+ */
+class AggregationMultigrid {
+private:
+    struct Level {
+        SparseMatrix A;
+        vector<double> inverseDiagonal;
+        vector<size_t> aggregateOf;   // fine node -> coarse node
+        size_t coarseSize = 0;
+    };
+
+    // Piecewise-constant interpolation underestimates smooth errors; scaling the
+    // coarse correction compensates and keeps the V-cycle symmetric
+    static constexpr double OVER_CORRECTION = 1.8;
+
+    vector<Level> levels;
+    vector<double> cholesky;          // dense lower factor of the coarsest matrix, row-major
+    size_t coarsestSize = 0;
+    int coarseSweeps = 0;             // used instead of the factor when coarsening stalls
+
+    static vector<size_t> aggregate(const SparseMatrix& A, size_t& count) {
+        const size_t NONE = static_cast<size_t>(-1);
+        size_t n = A.rows;
+        vector<size_t> aggregateOf(n, NONE);
+        vector<double> strongest(n, 0.0);
+        for (size_t i = 0; i < n; i++) {
+            for (size_t k = A.rowStart[i]; k < A.rowStart[i + 1]; k++) {
+                if (A.column[k] != i) strongest[i] = max(strongest[i], fabs(A.value[k]));
+            }
+        }
+
+        // Seed aggregates from nodes whose strong neighbours are all free
+        count = 0;
+        for (size_t i = 0; i < n; i++) {
+            if (aggregateOf[i] != NONE) continue;
+            bool free = true;
+            for (size_t k = A.rowStart[i]; k < A.rowStart[i + 1] && free; k++) {
+                size_t j = A.column[k];
+                if (j != i && fabs(A.value[k]) >= 0.25 * strongest[i] && aggregateOf[j] != NONE) free = false;
+            }
+            if (!free) continue;
+            aggregateOf[i] = count;
+            for (size_t k = A.rowStart[i]; k < A.rowStart[i + 1]; k++) {
+                size_t j = A.column[k];
+                if (j != i && fabs(A.value[k]) >= 0.25 * strongest[i]) aggregateOf[j] = count;
+            }
+            count++;
+        }
+
+        // Leftovers join their most strongly connected aggregate, or stand alone
+        for (size_t i = 0; i < n; i++) {
+            if (aggregateOf[i] != NONE) continue;
+            double best = 0.0;
+            for (size_t k = A.rowStart[i]; k < A.rowStart[i + 1]; k++) {
+                size_t j = A.column[k];
+                if (j != i && aggregateOf[j] != NONE && fabs(A.value[k]) > best) {
+                    best = fabs(A.value[k]);
+                    aggregateOf[i] = aggregateOf[j];
+                }
+            }
+            if (aggregateOf[i] == NONE) aggregateOf[i] = count++;
+        }
+        return aggregateOf;
+    }
+
+    // x_i += (b_i - (A x)_i) / a_ii, row by row in the given direction
+    static void gaussSeidel(const Level& level, const vector<double>& b, vector<double>& x, bool forward) {
+        const SparseMatrix& A = level.A;
+        size_t n = A.rows;
+        for (size_t step = 0; step < n; step++) {
+            size_t i = forward ? step : n - 1 - step;
+            double sum = b[i];
+            for (size_t k = A.rowStart[i]; k < A.rowStart[i + 1]; k++) {
+                sum -= A.value[k] * x[A.column[k]];
+            }
+            x[i] += sum * level.inverseDiagonal[i];
+        }
+    }
+
+    void factorCoarsest(const SparseMatrix& A) {
+        size_t n = A.rows;
+        coarsestSize = n;
+        cholesky.assign(n * n, 0.0);
+        for (size_t i = 0; i < n; i++) {
+            for (size_t k = A.rowStart[i]; k < A.rowStart[i + 1]; k++) {
+                cholesky[i * n + A.column[k]] += A.value[k];
+            }
+        }
+        for (size_t j = 0; j < n; j++) {
+            double d = cholesky[j * n + j];
+            for (size_t k = 0; k < j; k++) d -= cholesky[j * n + k] * cholesky[j * n + k];
+            if (d <= 0) throw runtime_error("Matrix is not positive definite");
+            d = sqrt(d);
+            cholesky[j * n + j] = d;
+            for (size_t i = j + 1; i < n; i++) {
+                double v = cholesky[i * n + j];
+                for (size_t k = 0; k < j; k++) v -= cholesky[i * n + k] * cholesky[j * n + k];
+                cholesky[i * n + j] = v / d;
+            }
+        }
+    }
+
+    void solveCoarsest(const vector<double>& b, vector<double>& x) const {
+        size_t n = coarsestSize;
+        x = b;
+        for (size_t i = 0; i < n; i++) {
+            for (size_t k = 0; k < i; k++) x[i] -= cholesky[i * n + k] * x[k];
+            x[i] /= cholesky[i * n + i];
+        }
+        for (size_t i = n; i-- > 0;) {
+            for (size_t k = i + 1; k < n; k++) x[i] -= cholesky[k * n + i] * x[k];
+            x[i] /= cholesky[i * n + i];
+        }
+    }
+
+public:
+    // Per-solve scratch vectors, so one hierarchy can serve concurrent solves
+    struct Workspace {
+        vector<vector<double>> x, b, r;
+    };
+
+private:
+    void cycle(size_t depth, const vector<double>& b, vector<double>& x, Workspace& work) const {
+        const Level& level = levels[depth];
+        const SparseMatrix& A = level.A;
+        x.assign(A.rows, 0.0);
+
+        // Coarsest level: exact solve, or a fixed number of symmetric sweeps
+        if (depth + 1 == levels.size()) {
+            if (coarseSweeps == 0) {
+                solveCoarsest(b, x);
+            } else {
+                for (int s = 0; s < coarseSweeps; s++) {
+                    gaussSeidel(level, b, x, true);
+                    gaussSeidel(level, b, x, false);
+                }
+            }
+            return;
+        }
+
+        gaussSeidel(level, b, x, true);
+
+        // Restrict the residual by summing it over each aggregate
+        vector<double>& Ax = work.r[depth];
+        vector<double>& coarseB = work.b[depth + 1];
+        vector<double>& coarseX = work.x[depth + 1];
+        A.multiply(x, Ax);
+        coarseB.assign(level.coarseSize, 0.0);
+        for (size_t i = 0; i < A.rows; i++) {
+            coarseB[level.aggregateOf[i]] += b[i] - Ax[i];
+        }
+        cycle(depth + 1, coarseB, coarseX, work);
+        for (size_t i = 0; i < A.rows; i++) {
+            x[i] += OVER_CORRECTION * coarseX[level.aggregateOf[i]];
+        }
+
+        gaussSeidel(level, b, x, false);
+    }
+
+public:
+    explicit AggregationMultigrid(const SparseMatrix& A, size_t coarseLimit = 400) {
+        levels.emplace_back();
+        levels.back().A = A;
+        while (levels.back().A.rows > coarseLimit) {
+            Level& fine = levels.back();
+            fine.aggregateOf = aggregate(fine.A, fine.coarseSize);
+            if (fine.coarseSize * 5 > fine.A.rows * 4) {
+                // Coarsening has stalled (e.g. no strong connections left)
+                fine.aggregateOf.clear();
+                fine.coarseSize = 0;
+                break;
+            }
+
+            // Galerkin product P^T A P for piecewise-constant P
+            vector<tuple<size_t, size_t, double>> entries;
+            entries.reserve(fine.A.value.size());
+            for (size_t i = 0; i < fine.A.rows; i++) {
+                for (size_t k = fine.A.rowStart[i]; k < fine.A.rowStart[i + 1]; k++) {
+                    entries.emplace_back(fine.aggregateOf[i], fine.aggregateOf[fine.A.column[k]], fine.A.value[k]);
+                }
+            }
+            SparseMatrix coarse = SparseMatrix::fromTriplets(fine.coarseSize, move(entries));
+            levels.emplace_back();
+            levels.back().A = move(coarse);
+        }
+
+        for (auto& level : levels) {
+            level.inverseDiagonal = level.A.diagonal();
+            for (double& d : level.inverseDiagonal) {
+                if (d <= 0) throw runtime_error("Matrix is not positive definite");
+                d = 1.0 / d;
+            }
+        }
+
+        if (levels.back().A.rows <= coarseLimit) {
+            factorCoarsest(levels.back().A);
+        } else {
+            coarseSweeps = 20;
+        }
+    }
+
+    // z = M^-1 r (one V-cycle)
+    void apply(const vector<double>& r, vector<double>& z, Workspace& work) const {
+        work.x.resize(levels.size());
+        work.b.resize(levels.size());
+        work.r.resize(levels.size());
+        cycle(0, r, z, work);
+    }
+
+    size_t getLevelCount() const { return levels.size(); }
+};
+
+struct SolveResult {
+    int iterations;
+    double relativeResidual;
+    bool converged;
+};
+
+/**
+ * Preconditioned conjugate gradient for symmetric positive definite systems
+ * (the reduced Laplacians of pipe networks), with Jacobi preconditioning
+ * unless a multigrid hierarchy is supplied. x is used as the starting guess,
+ * so passing the previous solution warm-starts the solve. Convergence is
+ * relative to ||b|| or to a caller-supplied reference norm.
+ */
+class ConjugateGradient {
+private:
+    static double dot(const vector<double>& a, const vector<double>& b) {
+        double sum = 0.0;
+        for (size_t i = 0; i < a.size(); i++) sum += a[i] * b[i];
+        return sum;
+    }
+
+public:
+    static SolveResult solve(const SparseMatrix& A, const vector<double>& b, vector<double>& x,
+                             double tolerance = 1e-8, int maxIterations = 0,
+                             const AggregationMultigrid* multigrid = nullptr, double referenceNorm = 0.0) {
+        size_t n = A.rows;
+        if (b.size() != n) {
+            throw invalid_argument("Right-hand side does not match the matrix size");
+        }
+        if (maxIterations <= 0) {
+            maxIterations = static_cast<int>(max<size_t>(100, 10 * n));
+        }
+        x.resize(n, 0.0);
+        if (n == 0) return {0, 0.0, true};
+
+        vector<double> inverseDiagonal = A.diagonal();
+        for (double& d : inverseDiagonal) {
+            if (d <= 0) throw runtime_error("Matrix is not positive definite");
+            d = 1.0 / d;
+        }
+
+        // The residual is measured against ||b|| unless the caller knows a better scale
+        double bNorm = (referenceNorm > 0.0) ? referenceNorm : sqrt(dot(b, b));
+        if (bNorm == 0.0) bNorm = 1.0;
+
+        vector<double> r(n), z(n), p(n), Ap(n);
+        A.multiply(x, Ap);
+        for (size_t i = 0; i < n; i++) r[i] = b[i] - Ap[i];
+
+        double residual = sqrt(dot(r, r)) / bNorm;
+        if (residual <= tolerance) return {0, residual, true};
+
+        AggregationMultigrid::Workspace work;
+        auto precondition = [&]() {
+            if (multigrid) {
+                multigrid->apply(r, z, work);
+            } else {
+                for (size_t i = 0; i < n; i++) z[i] = r[i] * inverseDiagonal[i];
+            }
+        };
+
+        precondition();
+        p = z;
+        double rz = dot(r, z);
+
+        for (int iteration = 1; iteration <= maxIterations; iteration++) {
+            A.multiply(p, Ap);
+            double alpha = rz / dot(p, Ap);
+            for (size_t i = 0; i < n; i++) {
+                x[i] += alpha * p[i];
+                r[i] -= alpha * Ap[i];
+            }
+
+            residual = sqrt(dot(r, r)) / bNorm;
+            if (residual <= tolerance) return {iteration, residual, true};
+
+            precondition();
+            double rzNext = dot(r, z);
+            double beta = rzNext / rz;
+            rz = rzNext;
+            for (size_t i = 0; i < n; i++) p[i] = z[i] + beta * p[i];
+        }
+        return {maxIterations, residual, false};
+    }
+};
+
+#endif // SPARSESOLVER_H
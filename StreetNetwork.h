@@ -0,0 +1,163 @@
+#ifndef STREETNETWORK_H
+#define STREETNETWORK_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+
+#include "Address.h"
+
+using namespace std;
+
+struct Intersection {
+    string name;
+    double x;     // meters
+    double y;
+};
+
+// One block of a street between two intersections, carrying house numbers [firstHouse, lastHouse]
+struct StreetSegment {
+    int street;
+    int firstHouse;
+    int lastHouse;
+    size_t from;     // intersection at firstHouse
+    size_t to;       // intersection at lastHouse
+    double length;   // meters
+};
+
+/**
+ * Street graph of the city.
+ * Segments are blocks of a numbered street between two intersections; an
+ * address lies on the segment of its street whose house range covers it,
+ * at a position interpolated between the segment's ends.
+ */
+class StreetNetwork {
+private:
+    vector<Intersection> intersections;
+    unordered_map<string, size_t> intersectionIndex;
+    vector<StreetSegment> segments;
+    map<int, vector<size_t>> segmentsOfStreet;   // street -> segments ordered by firstHouse
+
+public:
+    static constexpr size_t NONE = numeric_limits<size_t>::max();
+
+    size_t addIntersection(const string& name, double x, double y) {
+        if (intersectionIndex.count(name)) {
+            throw invalid_argument("Intersection " + name + " already exists");
+        }
+        intersectionIndex[name] = intersections.size();
+        intersections.push_back({name, x, y});
+        return intersections.size() - 1;
+    }
+
+    size_t addSegment(int street, int firstHouse, int lastHouse, const string& from, const string& to) {
+        if (firstHouse > lastHouse) {
+            throw invalid_argument("Segment house range is reversed");
+        }
+        size_t a = getIntersection(from), b = getIntersection(to);
+        if (a == NONE || b == NONE) {
+            throw invalid_argument("Segment ends must be existing intersections");
+        }
+        if (a == b) {
+            throw invalid_argument("Segment must join two different intersections");
+        }
+
+        vector<size_t>& onStreet = segmentsOfStreet[street];
+        auto position = lower_bound(onStreet.begin(), onStreet.end(), firstHouse,
+            [this](size_t s, int house) { return segments[s].firstHouse < house; });
+        if ((position != onStreet.end() && segments[*position].firstHouse <= lastHouse) ||
+            (position != onStreet.begin() && segments[*(position - 1)].lastHouse >= firstHouse)) {
+            throw invalid_argument("Segment overlaps another block of street " + to_string(street));
+        }
+
+        double length = hypot(intersections[b].x - intersections[a].x, intersections[b].y - intersections[a].y);
+        segments.push_back({street, firstHouse, lastHouse, a, b, length});
+        onStreet.insert(position, segments.size() - 1);
+        return segments.size() - 1;
+    }
+
+    /**
+     * Rectangular street grid: streets 1..avenues run north-south, one block
+     * per cross street gap, and cross streets avenues+1..avenues+crossStreets
+     * run east-west. Every block carries housesPerBlock house numbers.
+     */
+    static StreetNetwork grid(int avenues, int crossStreets, int housesPerBlock, double blockLength) {
+        if (avenues <= 0 || crossStreets <= 0 || housesPerBlock <= 0 || blockLength <= 0) {
+            throw invalid_argument("Street grid dimensions must be positive");
+        }
+        StreetNetwork network;
+        auto name = [](int a, int c) { return to_string(a) + "x" + to_string(c); };
+        for (int a = 0; a < avenues; a++) {
+            for (int c = 0; c < crossStreets; c++) {
+                network.addIntersection(name(a, c), a * blockLength, c * blockLength);
+            }
+        }
+        for (int a = 0; a < avenues; a++) {
+            for (int c = 0; c + 1 < crossStreets; c++) {
+                network.addSegment(a + 1, c * housesPerBlock, (c + 1) * housesPerBlock - 1, name(a, c), name(a, c + 1));
+            }
+        }
+        for (int c = 0; c < crossStreets; c++) {
+            for (int a = 0; a + 1 < avenues; a++) {
+                network.addSegment(avenues + 1 + c, a * housesPerBlock, (a + 1) * housesPerBlock - 1,
+                                   name(a, c), name(a + 1, c));
+            }
+        }
+        return network;
+    }
+
+    size_t getIntersectionCount() const { return intersections.size(); }
+    size_t getSegmentCount() const { return segments.size(); }
+    const Intersection& getIntersection(size_t index) const { return intersections.at(index); }
+    const StreetSegment& getSegment(size_t index) const { return segments.at(index); }
+
+    size_t getIntersection(const string& name) const {
+        auto it = intersectionIndex.find(name);
+        return it != intersectionIndex.end() ? it->second : NONE;
+    }
+
+    // Segment carrying an address, or NONE if its street or house number is not on the network
+    size_t segmentOf(const Address& address) const {
+        auto street = segmentsOfStreet.find(address.streetNo);
+        if (street == segmentsOfStreet.end()) return NONE;
+        const vector<size_t>& onStreet = street->second;
+        auto after = upper_bound(onStreet.begin(), onStreet.end(), address.houseNo,
+            [this](int house, size_t s) { return house < segments[s].firstHouse; });
+        if (after == onStreet.begin()) return NONE;
+        size_t s = *(after - 1);
+        return (address.houseNo <= segments[s].lastHouse) ? s : NONE;
+    }
+
+    // Point of a house number along a segment
+    void pointOn(size_t segment, int houseNo, double& x, double& y) const {
+        const StreetSegment& s = segments[segment];
+        double t = (s.lastHouse > s.firstHouse) ? double(houseNo - s.firstHouse) / (s.lastHouse - s.firstHouse) : 0.5;
+        t = min(1.0, max(0.0, t));
+        x = intersections[s.from].x + t * (intersections[s.to].x - intersections[s.from].x);
+        y = intersections[s.from].y + t * (intersections[s.to].y - intersections[s.from].y);
+    }
+
+    void midpoint(size_t segment, double& x, double& y) const {
+        const StreetSegment& s = segments[segment];
+        x = (intersections[s.from].x + intersections[s.to].x) / 2.0;
+        y = (intersections[s.from].y + intersections[s.to].y) / 2.0;
+    }
+
+    // Shortest distance from a point to a segment
+    double distanceTo(size_t segment, double x, double y) const {
+        const StreetSegment& s = segments[segment];
+        double ax = intersections[s.from].x, ay = intersections[s.from].y;
+        double dx = intersections[s.to].x - ax, dy = intersections[s.to].y - ay;
+        double lengthSquared = dx * dx + dy * dy;
+        double t = (lengthSquared > 0) ? ((x - ax) * dx + (y - ay) * dy) / lengthSquared : 0.0;
+        t = min(1.0, max(0.0, t));
+        return hypot(ax + t * dx - x, ay + t * dy - y);
+    }
+};
+
+#endif // STREETNETWORK_H
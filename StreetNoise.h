@@ -0,0 +1,232 @@
+#ifndef STREETNOISE_H
+#define STREETNOISE_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <algorithm>
+#include <unordered_map>
+#include <stdexcept>
+
+#include "Address.h"
+#include "StreetNetwork.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+struct StreetNoiseReport {
+    int day;
+    vector<float> levelDb;     // per segment, at its midpoint
+    double meanLevelDb;
+    double maxLevelDb;
+    double loudThresholdDb;
+    size_t loudSegments;       // at or above the loud threshold
+
+    void display() const {
+        cout << "\n===== STREET NOISE FOR DAY " << day << " =====" << endl;
+        cout << levelDb.size() << " segments, mean " << meanLevelDb << " dB, loudest " << maxLevelDb << " dB" << endl;
+        cout << loudSegments << " segments at or above " << loudThresholdDb << " dB" << endl;
+        cout << "=============================================" << endl;
+    }
+};
+
+/**
+ * Traffic noise over a street network.
+ * Each segment is a line source whose daily noise energy is its weighted
+ * vehicle passages; it reaches a receiver attenuated by R0 / (distance + R0)
+ * (3 dB per doubling of distance) and not at all beyond the cutoff radius.
+ * The segments within reach of every segment are found once, when the engine
+ * is built, so a tick is one parallel pass over the segments and an exposure
+ * query only visits the candidates of the address's own segment.
+ */
+class StreetNoise {
+private:
+    shared_ptr<const StreetNetwork> network;
+    double radius;
+    vector<size_t> candidateStart;    // CSR: candidates of segment s are [candidateStart[s], candidateStart[s + 1])
+    vector<uint32_t> candidates;      // segments within radius of some point of s
+    vector<float> midpointWeight;     // attenuation from each candidate to the midpoint of s (0 if out of reach)
+    ThreadPool pool;
+
+    static constexpr size_t BLOCK = 1024;   // segments per partial result, fixed so totals do not depend on threads
+
+    static double segmentDistance(const StreetNetwork& net, size_t a, size_t b) {
+        const StreetSegment& sa = net.getSegment(a);
+        const StreetSegment& sb = net.getSegment(b);
+        const Intersection& a0 = net.getIntersection(sa.from);
+        const Intersection& a1 = net.getIntersection(sa.to);
+        const Intersection& b0 = net.getIntersection(sb.from);
+        const Intersection& b1 = net.getIntersection(sb.to);
+
+        // Crossing segments touch
+        auto side = [](const Intersection& p, const Intersection& q, const Intersection& r) {
+            return (q.x - p.x) * (r.y - p.y) - (q.y - p.y) * (r.x - p.x);
+        };
+        double d1 = side(a0, a1, b0), d2 = side(a0, a1, b1), d3 = side(b0, b1, a0), d4 = side(b0, b1, a1);
+        if (((d1 > 0 && d2 < 0) || (d1 < 0 && d2 > 0)) && ((d3 > 0 && d4 < 0) || (d3 < 0 && d4 > 0))) return 0.0;
+
+        return min(min(net.distanceTo(b, a0.x, a0.y), net.distanceTo(b, a1.x, a1.y)),
+                   min(net.distanceTo(a, b0.x, b0.y), net.distanceTo(a, b1.x, b1.y)));
+    }
+
+    // Candidate lists from a uniform bucket grid with cells one radius wide
+    void buildIndex() {
+        const StreetNetwork& net = *network;
+        size_t count = net.getSegmentCount();
+        if (count > UINT32_MAX) {
+            throw out_of_range("Too many street segments for the noise index");
+        }
+
+        auto cellOf = [this](double v) { return static_cast<long long>(floor(v / radius)); };
+        auto key = [](long long cx, long long cy) { return (static_cast<uint64_t>(cx) << 32) ^ static_cast<uint32_t>(cy); };
+        struct Box { long long x0, y0, x1, y1; };
+        vector<Box> boxes(count);
+        unordered_map<uint64_t, vector<uint32_t>> buckets;
+        for (size_t s = 0; s < count; s++) {
+            const StreetSegment& seg = net.getSegment(s);
+            const Intersection& p = net.getIntersection(seg.from);
+            const Intersection& q = net.getIntersection(seg.to);
+            boxes[s] = {cellOf(min(p.x, q.x)), cellOf(min(p.y, q.y)), cellOf(max(p.x, q.x)), cellOf(max(p.y, q.y))};
+            for (long long cx = boxes[s].x0; cx <= boxes[s].x1; cx++) {
+                for (long long cy = boxes[s].y0; cy <= boxes[s].y1; cy++) {
+                    buckets[key(cx, cy)].push_back(static_cast<uint32_t>(s));
+                }
+            }
+        }
+
+        vector<vector<uint32_t>> found(count);
+        vector<vector<float>> weights(count);
+        pool.parallelFor(0, count, [&](size_t first, size_t last) {
+            vector<uint32_t> seen;
+            for (size_t s = first; s < last; s++) {
+                seen.clear();
+                // A bounding box grown by one cell covers everything within the radius
+                for (long long cx = boxes[s].x0 - 1; cx <= boxes[s].x1 + 1; cx++) {
+                    for (long long cy = boxes[s].y0 - 1; cy <= boxes[s].y1 + 1; cy++) {
+                        auto bucket = buckets.find(key(cx, cy));
+                        if (bucket != buckets.end()) seen.insert(seen.end(), bucket->second.begin(), bucket->second.end());
+                    }
+                }
+                sort(seen.begin(), seen.end());
+                seen.erase(unique(seen.begin(), seen.end()), seen.end());
+
+                double mx, my;
+                net.midpoint(s, mx, my);
+                for (uint32_t n : seen) {
+                    if (segmentDistance(net, s, n) > radius) continue;
+                    double d = net.distanceTo(n, mx, my);
+                    found[s].push_back(n);
+                    weights[s].push_back(d <= radius ? static_cast<float>(attenuation(d)) : 0.0f);
+                }
+            }
+        }, 64);
+
+        candidateStart.assign(count + 1, 0);
+        for (size_t s = 0; s < count; s++) candidateStart[s + 1] = candidateStart[s] + found[s].size();
+        candidates.resize(candidateStart[count]);
+        midpointWeight.resize(candidateStart[count]);
+        for (size_t s = 0; s < count; s++) {
+            copy(found[s].begin(), found[s].end(), candidates.begin() + candidateStart[s]);
+            copy(weights[s].begin(), weights[s].end(), midpointWeight.begin() + candidateStart[s]);
+        }
+    }
+
+public:
+    static constexpr double REFERENCE_DISTANCE = 10.0;   // meters from the kerb to the facade
+    static constexpr double BASE_DB = 30.0;              // background level, and one weighted passage at the kerb
+    static constexpr double LOUD_DB = 65.0;
+
+    // Noise energy of one passage by vehicle type, relative to a car
+    static double vehicleWeight(const string& type) {
+        if (type == "Bicycle" || type == "Plane") return 0.0;   // silent, or not on the streets
+        if (type == "Bike") return 2.0;
+        if (type == "Bus") return 6.0;
+        if (type == "Train") return 12.0;
+        return 1.0;
+    }
+
+    static double attenuation(double distance) { return REFERENCE_DISTANCE / (distance + REFERENCE_DISTANCE); }
+    static double toDb(double energy) { return BASE_DB + 10.0 * log10(max(1.0, energy)); }
+
+    // threadCount = 0 uses every hardware thread
+    StreetNoise(shared_ptr<const StreetNetwork> streets, double cutoffRadius = 300.0, size_t threadCount = 0)
+        : network(move(streets)), radius(cutoffRadius), pool(threadCount) {
+        if (!network) {
+            throw invalid_argument("Street noise needs a street network");
+        }
+        if (radius <= 0) {
+            throw invalid_argument("Noise cutoff radius must be positive");
+        }
+        buildIndex();
+    }
+
+    const StreetNetwork& getNetwork() const { return *network; }
+    size_t getIndexSize() const { return candidates.size(); }
+
+    // Level at every segment's midpoint from the segments' weighted passages
+    StreetNoiseReport compute(int day, const vector<double>& energy) {
+        size_t count = network->getSegmentCount();
+        if (energy.size() != count) {
+            throw invalid_argument("Noise energy needs one entry per street segment");
+        }
+
+        StreetNoiseReport report{};
+        report.day = day;
+        report.loudThresholdDb = LOUD_DB;
+        report.levelDb.resize(count);
+        size_t blocks = (count + BLOCK - 1) / BLOCK;
+        vector<double> blockSum(blocks, 0.0), blockMax(blocks, BASE_DB);
+        vector<size_t> blockLoud(blocks, 0);
+
+        pool.parallelFor(0, blocks, [&](size_t first, size_t last) {
+            for (size_t b = first; b < last; b++) {
+                size_t end = min(count, (b + 1) * BLOCK);
+                for (size_t s = b * BLOCK; s < end; s++) {
+                    double received = 0.0;
+                    for (size_t k = candidateStart[s]; k < candidateStart[s + 1]; k++) {
+                        received += midpointWeight[k] * energy[candidates[k]];
+                    }
+                    double level = toDb(received);
+                    report.levelDb[s] = static_cast<float>(level);
+                    blockSum[b] += level;
+                    blockMax[b] = max(blockMax[b], level);
+                    if (level >= LOUD_DB) blockLoud[b]++;
+                }
+            }
+        });
+
+        double sum = 0.0;
+        report.maxLevelDb = BASE_DB;
+        for (size_t b = 0; b < blocks; b++) {
+            sum += blockSum[b];
+            report.maxLevelDb = max(report.maxLevelDb, blockMax[b]);
+            report.loudSegments += blockLoud[b];
+        }
+        report.meanLevelDb = count ? sum / count : BASE_DB;
+        return report;
+    }
+
+    // Level at one address from the segments' weighted passages
+    double exposureAt(const vector<double>& energy, const Address& address) const {
+        size_t s = network->segmentOf(address);
+        if (s == StreetNetwork::NONE) {
+            throw out_of_range("Address is not on the street network");
+        }
+        if (energy.size() != network->getSegmentCount()) {
+            throw invalid_argument("Noise energy needs one entry per street segment");
+        }
+        double x, y;
+        network->pointOn(s, address.houseNo, x, y);
+        double received = 0.0;
+        for (size_t k = candidateStart[s]; k < candidateStart[s + 1]; k++) {
+            double d = network->distanceTo(candidates[k], x, y);
+            if (d <= radius) received += attenuation(d) * energy[candidates[k]];
+        }
+        return toDb(received);
+    }
+};
+
+#endif // STREETNOISE_H
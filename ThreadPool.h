@@ -0,0 +1,197 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <atomic>
+#include <memory>
+#include <algorithm>
+#include <exception>
+
+using namespace std;
+
+/**
+ * Work-stealing thread pool.
+ * Every worker owns a task queue: it pops its own newest task first (LIFO) and,
+ * when that runs dry, steals the oldest task from another worker (FIFO).
+ * Threads waiting on a result help by running queued tasks, so tasks can
+ * safely submit and wait on subtasks.
+ */
+class ThreadPool {
+private:
+    struct TaskQueue {
+        deque<function<void()>> tasks;
+        mutex lock;
+    };
+
+    vector<unique_ptr<TaskQueue>> queues;
+    vector<thread> workers;
+    atomic<bool> stopping;
+    atomic<long> queued;
+    atomic<size_t> nextQueue;
+    mutex sleepLock;
+    condition_variable wakeUp;
+
+    // Pool and queue index of the calling thread (nullptr / -1 outside any pool)
+    static const ThreadPool*& currentPool() {
+        static thread_local const ThreadPool* pool = nullptr;
+        return pool;
+    }
+
+    static int& currentWorker() {
+        static thread_local int index = -1;
+        return index;
+    }
+
+    int workerIndex() const {
+        return (currentPool() == this) ? currentWorker() : -1;
+    }
+
+    // Take a task from our own queue, otherwise steal one
+    bool popTask(int self, function<void()>& task) {
+        if (self >= 0) {
+            TaskQueue& own = *queues[self];
+            lock_guard<mutex> lock(own.lock);
+            if (!own.tasks.empty()) {
+                task = move(own.tasks.back());
+                own.tasks.pop_back();
+                queued--;
+                return true;
+            }
+        }
+
+        size_t start = (self >= 0) ? size_t(self) + 1 : nextQueue.load();
+        for (size_t k = 0; k < queues.size(); k++) {
+            TaskQueue& victim = *queues[(start + k) % queues.size()];
+            lock_guard<mutex> lock(victim.lock);
+            if (!victim.tasks.empty()) {
+                task = move(victim.tasks.front());
+                victim.tasks.pop_front();
+                queued--;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void workerLoop(int index) {
+        currentPool() = this;
+        currentWorker() = index;
+
+        function<void()> task;
+        while (true) {
+            if (popTask(index, task)) {
+                task();
+                task = nullptr;
+                continue;
+            }
+            unique_lock<mutex> lock(sleepLock);
+            wakeUp.wait(lock, [this] { return stopping || queued > 0; });
+            if (stopping && queued <= 0) return;
+        }
+    }
+
+public:
+    // threadCount = 0 uses one worker per hardware thread
+    explicit ThreadPool(size_t threadCount = 0)
+        : stopping(false), queued(0), nextQueue(0) {
+        if (threadCount == 0) {
+            threadCount = max(1u, thread::hardware_concurrency());
+        }
+        for (size_t i = 0; i < threadCount; i++) {
+            queues.push_back(make_unique<TaskQueue>());
+        }
+        for (size_t i = 0; i < threadCount; i++) {
+            workers.emplace_back(&ThreadPool::workerLoop, this, int(i));
+        }
+    }
+
+    // Finishes the queued tasks, then joins the workers
+    ~ThreadPool() {
+        {
+            lock_guard<mutex> lock(sleepLock);
+            stopping = true;
+        }
+        wakeUp.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return workers.size(); }
+
+    // Queue a task; called from a worker it goes to that worker's own queue
+    template<typename F>
+    auto submit(F f) -> future<decltype(f())> {
+        typedef decltype(f()) R;
+        auto job = make_shared<packaged_task<R()>>(move(f));
+        future<R> result = job->get_future();
+
+        int self = workerIndex();
+        size_t target = (self >= 0) ? size_t(self) : nextQueue++ % queues.size();
+        {
+            lock_guard<mutex> lock(sleepLock);
+            queued++;
+        }
+        {
+            lock_guard<mutex> lock(queues[target]->lock);
+            queues[target]->tasks.push_back([job] { (*job)(); });
+        }
+        wakeUp.notify_one();
+        return result;
+    }
+
+    // Wait for a result, running queued tasks in the meantime
+    template<typename T>
+    T wait(future<T>& result) {
+        function<void()> task;
+        while (result.wait_for(chrono::seconds(0)) != future_status::ready) {
+            if (popTask(workerIndex(), task)) {
+                task();
+                task = nullptr;
+            } else {
+                this_thread::yield();
+            }
+        }
+        return result.get();
+    }
+
+    // Run body(chunkBegin, chunkEnd) over [begin, end) split into chunks of at least grain items
+    void parallelFor(size_t begin, size_t end, const function<void(size_t, size_t)>& body, size_t grain = 1) {
+        if (begin >= end) return;
+
+        size_t count = end - begin;
+        size_t chunks = min(count / max(grain, size_t(1)), size() * 4);
+        if (chunks <= 1) {
+            body(begin, end);
+            return;
+        }
+
+        vector<future<void>> pending;
+        size_t chunkSize = (count + chunks - 1) / chunks;
+        for (size_t first = begin; first < end; first += chunkSize) {
+            size_t last = min(end, first + chunkSize);
+            pending.push_back(submit([&body, first, last] { body(first, last); }));
+        }
+        // Every chunk must finish before body goes out of scope, even if one of them throws
+        exception_ptr failure;
+        for (auto& result : pending) {
+            try {
+                wait(result);
+            } catch (...) {
+                if (!failure) failure = current_exception();
+            }
+        }
+        if (failure) rethrow_exception(failure);
+    }
+};
+
+#endif // THREADPOOL_H
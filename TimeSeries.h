@@ -0,0 +1,428 @@
+#ifndef TIMESERIES_H
+#define TIMESERIES_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+#include <filesystem>
+#include <ostream>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+// Columns of the daily city series, in file order; the numbers are part of the file format
+enum class SeriesColumn : uint8_t {
+    DAY = 0,
+    BUDGET,
+    ECO_SCORE,
+    AIR_POLLUTION,
+    WATER_POLLUTION,
+    NOISE_POLLUTION,
+    SOLID_WASTE,
+    POPULATION,
+    BUILDING_IMPACT,   // per-category eco score deductions
+    CITIZEN_IMPACT,
+    TRANSPORT_IMPACT,
+    HOUSING_IMPACT,
+    SERVICES_IMPACT,
+    POLLUTION_IMPACT,
+    COUNT
+};
+
+struct SeriesColumnInfo {
+    const char* name;
+    char type;   // 'i' 64-bit integer, 'd' 64-bit real
+};
+
+inline const SeriesColumnInfo& seriesColumnInfo(SeriesColumn column) {
+    static const SeriesColumnInfo table[] = {
+        {"day", 'i'},
+        {"budget", 'd'},
+        {"eco_score", 'd'},
+        {"air_pollution", 'd'},
+        {"water_pollution", 'd'},
+        {"noise_pollution", 'd'},
+        {"solid_waste", 'd'},
+        {"population", 'i'},
+        {"building_impact", 'd'},
+        {"citizen_impact", 'd'},
+        {"transport_impact", 'd'},
+        {"housing_impact", 'd'},
+        {"services_impact", 'd'},
+        {"pollution_impact", 'd'},
+    };
+    return table[static_cast<size_t>(column)];
+}
+
+// One simulated day, as appended to the series
+struct DailyRecord {
+    int64_t day;
+    double budget;
+    double ecoScore;
+    double airPollution;
+    double waterPollution;
+    double noisePollution;
+    double solidWaste;
+    int64_t population;
+    double buildingImpact;
+    double citizenImpact;
+    double transportImpact;
+    double housingImpact;
+    double servicesImpact;
+    double pollutionImpact;
+};
+
+/**
+ * Appends days to a columnar series file.
+ * Days collect in per-column buffers and are written a chunk at a time: a
+ * chunk header with the row count and each column's minimum and maximum,
+ * then every column's values back to back. All cells are 8 bytes, so a
+ * reader can seek straight to one column of one chunk and skip chunks whose
+ * day range or value range is of no interest, with nothing to parse.
+ *
+ * File layout (little endian):
+ *   header = magic "CITYTS01", u32 columns, per column: u8 type, u8 name length, name
+ *   chunk  = u32 rows, u32 columns, per column: min, max; then per column: rows cells
+ * flush() writes the buffered days as a (shorter) chunk of their own.
+ */
+class TimeSeriesWriter {
+public:
+    static constexpr char MAGIC[8] = {'C', 'I', 'T', 'Y', 'T', 'S', '0', '1'};
+    static constexpr size_t COLUMNS = static_cast<size_t>(SeriesColumn::COUNT);
+
+private:
+    ofstream file;
+    size_t chunkRows;
+    vector<uint64_t> cells[COLUMNS];   // buffered values per column, as raw 8-byte patterns
+    uint64_t rows;
+
+    static uint64_t bits(int64_t v) { return static_cast<uint64_t>(v); }
+    static uint64_t bits(double v) {
+        uint64_t b;
+        memcpy(&b, &v, 8);
+        return b;
+    }
+    static double real(uint64_t b) {
+        double v;
+        memcpy(&v, &b, 8);
+        return v;
+    }
+
+    static void put32(string& out, uint32_t v) { out.append(reinterpret_cast<const char*>(&v), 4); }
+    static void put64(string& out, uint64_t v) { out.append(reinterpret_cast<const char*>(&v), 8); }
+
+    // Minimum and maximum of a buffered column, compared in the column's type
+    static pair<uint64_t, uint64_t> range(const vector<uint64_t>& column, char type) {
+        if (type == 'i') {
+            auto [lo, hi] = minmax_element(column.begin(), column.end(),
+                                           [](uint64_t a, uint64_t b) { return int64_t(a) < int64_t(b); });
+            return {*lo, *hi};
+        }
+        double lo = numeric_limits<double>::infinity(), hi = -lo;
+        for (uint64_t cell : column) {
+            double v = real(cell);
+            if (v < lo) lo = v;
+            if (v > hi) hi = v;
+        }
+        return {bits(lo), bits(hi)};
+    }
+
+public:
+    static string header() {
+        string out(MAGIC, sizeof(MAGIC));
+        put32(out, static_cast<uint32_t>(COLUMNS));
+        for (size_t c = 0; c < COLUMNS; c++) {
+            const SeriesColumnInfo& info = seriesColumnInfo(static_cast<SeriesColumn>(c));
+            out.push_back(info.type);
+            out.push_back(static_cast<char>(strlen(info.name)));
+            out += info.name;
+        }
+        return out;
+    }
+
+    // Length of the header and the complete chunks that follow it; a chunk cut short ends the
+    // series, while a chunk of another column count is corruption, as TimeSeriesReader treats it
+    static uint64_t completeLength(istream& in, uint64_t headerBytes) {
+        in.seekg(0, ios::end);
+        uint64_t size = in.tellg();
+        uint64_t position = headerBytes;
+        while (position + 8 <= size) {
+            uint32_t chunkRows = 0, chunkColumns = 0;
+            in.seekg(position);
+            in.read(reinterpret_cast<char*>(&chunkRows), 4);
+            in.read(reinterpret_cast<char*>(&chunkColumns), 4);
+            if (!in) break;
+            if (chunkColumns != COLUMNS) {
+                throw runtime_error("Corrupt time series chunk at byte " + to_string(position));
+            }
+            uint64_t end = position + 8 + uint64_t(COLUMNS) * 16 + uint64_t(COLUMNS) * chunkRows * 8;
+            if (end > size) break;
+            position = end;
+        }
+        return position;
+    }
+
+    // Appends to filename; an existing file must hold a series with the same columns, and a
+    // chunk left incomplete by a writer that did not finish is cut off first
+    explicit TimeSeriesWriter(const string& filename, size_t rowsPerChunk = 365)
+        : chunkRows(max(rowsPerChunk, size_t(1))), rows(0) {
+        string expected = header();
+        ifstream existing(filename, ios::binary);
+        if (existing.is_open() && existing.peek() != char_traits<char>::eof()) {
+            string found(expected.size(), '\0');
+            existing.read(&found[0], found.size());
+            if (!existing || found != expected) {
+                throw runtime_error(filename + " is not a city time series with the current columns");
+            }
+            uint64_t complete = completeLength(existing, expected.size());
+            existing.close();
+            if (complete < filesystem::file_size(filename)) filesystem::resize_file(filename, complete);
+        }
+        existing.close();
+
+        file.open(filename, ios::binary | ios::app);
+        if (!file.is_open()) {
+            throw runtime_error("Could not open time series file: " + filename);
+        }
+        if (file.tellp() == 0) file.write(expected.data(), expected.size());
+        for (auto& column : cells) column.reserve(chunkRows);
+    }
+
+    TimeSeriesWriter(const TimeSeriesWriter&) = delete;
+    TimeSeriesWriter& operator=(const TimeSeriesWriter&) = delete;
+
+    ~TimeSeriesWriter() { flush(); }
+
+    void append(const DailyRecord& record) {
+        const uint64_t row[COLUMNS] = {
+            bits(record.day), bits(record.budget), bits(record.ecoScore),
+            bits(record.airPollution), bits(record.waterPollution), bits(record.noisePollution), bits(record.solidWaste),
+            bits(record.population),
+            bits(record.buildingImpact), bits(record.citizenImpact), bits(record.transportImpact),
+            bits(record.housingImpact), bits(record.servicesImpact), bits(record.pollutionImpact),
+        };
+        for (size_t c = 0; c < COLUMNS; c++) cells[c].push_back(row[c]);
+        rows++;
+        if (cells[0].size() >= chunkRows) writeChunk();
+    }
+
+    // Write the buffered days as a chunk
+    void writeChunk() {
+        size_t count = cells[0].size();
+        if (count == 0) return;
+        string out;
+        out.reserve(8 + COLUMNS * 16 + COLUMNS * count * 8);
+        put32(out, static_cast<uint32_t>(count));
+        put32(out, static_cast<uint32_t>(COLUMNS));
+        for (size_t c = 0; c < COLUMNS; c++) {
+            auto [lo, hi] = range(cells[c], seriesColumnInfo(static_cast<SeriesColumn>(c)).type);
+            put64(out, lo);
+            put64(out, hi);
+        }
+        for (auto& column : cells) {
+            out.append(reinterpret_cast<const char*>(column.data()), column.size() * 8);
+            column.clear();
+        }
+        file.write(out.data(), out.size());
+    }
+
+    void flush() {
+        writeChunk();
+        file.flush();
+    }
+
+    uint64_t getRowCount() const { return rows; }
+};
+
+// Where a chunk sits in the file, with its row count and per-column value range
+struct SeriesChunk {
+    uint64_t offset;   // of the first column's cells
+    uint32_t rows;
+    vector<double> minimum;
+    vector<double> maximum;
+};
+
+/**
+ * Reads a series file written by TimeSeriesWriter.
+ * Opening reads only the header and the chunk headers; values are read a
+ * column of a chunk at a time, and a day range skips the chunks outside it.
+ * The reader follows the columns named in the file. A chunk cut short at
+ * the end of the file (a writer that did not flush) ends the series.
+ */
+class TimeSeriesReader {
+private:
+    mutable ifstream file;
+    vector<string> names;
+    vector<char> types;
+    vector<SeriesChunk> chunks;
+    uint64_t rowCount;
+
+    template<typename T>
+    void get(T& value) const {
+        file.read(reinterpret_cast<char*>(&value), sizeof(T));
+    }
+
+    static double decode(uint64_t cell, char type) {
+        if (type == 'i') return static_cast<double>(static_cast<int64_t>(cell));
+        double v;
+        memcpy(&v, &cell, 8);
+        return v;
+    }
+
+    void readCells(const SeriesChunk& chunk, size_t column, vector<uint64_t>& out) const {
+        out.resize(chunk.rows);
+        file.seekg(chunk.offset + uint64_t(column) * chunk.rows * 8);
+        file.read(reinterpret_cast<char*>(out.data()), out.size() * 8);
+        if (!file) {
+            throw runtime_error("Could not read time series chunk");
+        }
+    }
+
+    static void writeCell(ostream& out, uint64_t cell, char type) {
+        char buf[32];
+        if (type == 'i') snprintf(buf, sizeof(buf), "%lld", static_cast<long long>(static_cast<int64_t>(cell)));
+        else snprintf(buf, sizeof(buf), "%.15g", decode(cell, type));
+        out << buf;
+    }
+
+public:
+    explicit TimeSeriesReader(const string& filename) : rowCount(0) {
+        file.open(filename, ios::binary);
+        if (!file.is_open()) {
+            throw runtime_error("Could not open time series file: " + filename);
+        }
+        char magic[sizeof(TimeSeriesWriter::MAGIC)];
+        uint32_t columns = 0;
+        file.read(magic, sizeof(magic));
+        get(columns);
+        if (!file || memcmp(magic, TimeSeriesWriter::MAGIC, sizeof(magic)) != 0 || columns == 0) {
+            throw runtime_error(filename + " is not a city time series");
+        }
+        for (uint32_t c = 0; c < columns; c++) {
+            char type = 0;
+            uint8_t length = 0;
+            get(type);
+            get(length);
+            string name(length, '\0');
+            file.read(&name[0], length);
+            if (!file || (type != 'i' && type != 'd')) {
+                throw runtime_error(filename + " has a corrupt time series header");
+            }
+            names.push_back(name);
+            types.push_back(type);
+        }
+        if (names[0] != seriesColumnInfo(SeriesColumn::DAY).name) {
+            throw runtime_error(filename + " does not start with a day column");
+        }
+
+        file.seekg(0, ios::end);
+        uint64_t size = file.tellg();
+        uint64_t position = uint64_t(sizeof(TimeSeriesWriter::MAGIC)) + 4;
+        for (const string& name : names) position += 2 + name.size();
+        uint64_t rangeBytes = uint64_t(columns) * 16;
+        while (position + 8 + rangeBytes <= size) {
+            file.seekg(position);
+            uint32_t rows = 0, chunkColumns = 0;
+            get(rows);
+            get(chunkColumns);
+            if (chunkColumns != columns) {
+                throw runtime_error(filename + " has a corrupt time series chunk");
+            }
+            SeriesChunk chunk{position + 8 + rangeBytes, rows, vector<double>(columns), vector<double>(columns)};
+            if (chunk.offset + uint64_t(columns) * rows * 8 > size) break;
+            for (uint32_t c = 0; c < columns; c++) {
+                uint64_t lo = 0, hi = 0;
+                get(lo);
+                get(hi);
+                chunk.minimum[c] = decode(lo, types[c]);
+                chunk.maximum[c] = decode(hi, types[c]);
+            }
+            position = chunk.offset + uint64_t(columns) * rows * 8;
+            rowCount += rows;
+            chunks.push_back(move(chunk));
+        }
+        file.clear();
+    }
+
+    size_t getColumnCount() const { return names.size(); }
+    const string& getColumnName(size_t column) const { return names.at(column); }
+    uint64_t getRowCount() const { return rowCount; }
+    const vector<SeriesChunk>& getChunks() const { return chunks; }
+
+    size_t findColumn(const string& name) const {
+        auto it = find(names.begin(), names.end(), name);
+        if (it == names.end()) {
+            throw out_of_range("No time series column named " + name);
+        }
+        return it - names.begin();
+    }
+
+    // Values of a column for the days in [fromDay, toDay], in file order
+    vector<double> readColumn(size_t column, int64_t fromDay = numeric_limits<int64_t>::min(),
+                              int64_t toDay = numeric_limits<int64_t>::max()) const {
+        if (column >= names.size()) {
+            throw out_of_range("Time series column index out of range");
+        }
+        vector<double> values;
+        vector<uint64_t> days, cells;
+        for (const SeriesChunk& chunk : chunks) {
+            if (chunk.maximum[0] < fromDay || chunk.minimum[0] > toDay) continue;
+            readCells(chunk, column, cells);
+            if (chunk.minimum[0] >= fromDay && chunk.maximum[0] <= toDay) {
+                for (uint64_t cell : cells) values.push_back(decode(cell, types[column]));
+                continue;
+            }
+            readCells(chunk, 0, days);
+            for (size_t r = 0; r < chunk.rows; r++) {
+                int64_t day = static_cast<int64_t>(days[r]);
+                if (day >= fromDay && day <= toDay) values.push_back(decode(cells[r], types[column]));
+            }
+        }
+        return values;
+    }
+
+    vector<double> readColumn(SeriesColumn column, int64_t fromDay = numeric_limits<int64_t>::min(),
+                              int64_t toDay = numeric_limits<int64_t>::max()) const {
+        return readColumn(findColumn(seriesColumnInfo(column).name), fromDay, toDay);
+    }
+
+    // Write the days in [fromDay, toDay] as CSV with a header row
+    void exportCsv(ostream& out, int64_t fromDay = numeric_limits<int64_t>::min(),
+                   int64_t toDay = numeric_limits<int64_t>::max()) const {
+        for (size_t c = 0; c < names.size(); c++) {
+            out << (c ? "," : "") << names[c];
+        }
+        out << "\n";
+
+        vector<vector<uint64_t>> columns(names.size());
+        for (const SeriesChunk& chunk : chunks) {
+            if (chunk.maximum[0] < fromDay || chunk.minimum[0] > toDay) continue;
+            for (size_t c = 0; c < names.size(); c++) readCells(chunk, c, columns[c]);
+            for (size_t r = 0; r < chunk.rows; r++) {
+                int64_t day = static_cast<int64_t>(columns[0][r]);
+                if (day < fromDay || day > toDay) continue;
+                for (size_t c = 0; c < names.size(); c++) {
+                    if (c) out << ',';
+                    writeCell(out, columns[c][r], types[c]);
+                }
+                out << "\n";
+            }
+        }
+    }
+
+    void exportCsv(const string& csvFilename, int64_t fromDay = numeric_limits<int64_t>::min(),
+                   int64_t toDay = numeric_limits<int64_t>::max()) const {
+        ofstream out(csvFilename);
+        if (!out.is_open()) {
+            throw runtime_error("Could not open CSV file: " + csvFilename);
+        }
+        exportCsv(out, fromDay, toDay);
+    }
+};
+
+#endif // TIMESERIES_H
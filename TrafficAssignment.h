@@ -0,0 +1,381 @@
+#ifndef TRAFFICASSIGNMENT_H
+#define TRAFFICASSIGNMENT_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <cmath>
+#include <limits>
+#include <cstdint>
+#include <iostream>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+
+#include "Address.h"
+#include "StreetNetwork.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+// Peak-hour vehicles travelling between two intersections
+struct TrafficDemand {
+    uint32_t origin;
+    uint32_t destination;
+    double vehicles;
+};
+
+struct TrafficReport {
+    int day;
+    size_t iterations;
+    double relativeGap;         // share of travel time that shortest paths would still save
+    double peakVehicles;        // demand in the peak hour
+    vector<float> flow;         // peak-hour vehicles per segment
+    vector<float> delayRatio;   // congested over free-flow travel time per segment
+    size_t congestedSegments;   // flow above capacity
+    double meanTripDelayRatio;  // over the demand
+
+    void display() const {
+        cout << "\n===== TRAFFIC FOR DAY " << day << " =====" << endl;
+        cout << peakVehicles << " vehicles in the peak hour, trips take " << meanTripDelayRatio
+             << "x their free-flow time" << endl;
+        cout << congestedSegments << " of " << flow.size() << " segments over capacity" << endl;
+        cout << "Equilibrium after " << iterations << " iterations, relative gap " << relativeGap << endl;
+        cout << "=============================================" << endl;
+    }
+};
+
+/**
+ * Static user-equilibrium traffic assignment over a street network.
+ * Travel time on a segment follows the BPR volume-delay function
+ * t0 * (1 + alpha * (flow / capacity)^beta). Frank-Wolfe alternates an
+ * all-or-nothing assignment on the current times with a line search along
+ * the move towards it, until the relative gap is small. Each all-or-nothing
+ * pass is one shortest-path tree per origin, run in parallel over origins;
+ * flows are summed as fixed-point integers so they do not depend on threads.
+ */
+class TrafficAssignment {
+private:
+    struct Arc {
+        uint32_t to;
+        uint32_t segment;
+    };
+
+    shared_ptr<const StreetNetwork> network;
+    vector<size_t> arcStart;      // CSR: arcs leaving each intersection
+    vector<Arc> arcs;
+    vector<double> capacity;      // vehicles per hour, both directions together
+    vector<double> freeFlowTime;  // hours
+    double speedKmh;
+    double alpha;
+    double beta;
+    size_t maxIterations;
+    double gapTolerance;
+    shared_ptr<ThreadPool> pool;  // shared with copies of the engine
+
+    static constexpr double FLOW_UNIT = 1e6;   // fixed-point steps per vehicle
+    static constexpr size_t BLOCK = 4096;      // segments per partial sum, fixed so sums do not depend on threads
+
+    // Sum f(s) over every segment in block order
+    double sumSegments(const function<double(size_t)>& f) const {
+        size_t count = capacity.size();
+        size_t blocks = (count + BLOCK - 1) / BLOCK;
+        vector<double> partial(blocks, 0.0);
+        pool->parallelFor(0, blocks, [&](size_t first, size_t last) {
+            for (size_t b = first; b < last; b++) {
+                size_t end = min(count, (b + 1) * BLOCK);
+                for (size_t s = b * BLOCK; s < end; s++) partial[b] += f(s);
+            }
+        });
+        double total = 0.0;
+        for (double p : partial) total += p;
+        return total;
+    }
+
+    /**
+     * All-or-nothing: every origin's demand follows its shortest paths under
+     * the given times. Fills flow (per segment) and each demand's path time.
+     * demand is sorted by origin and originStart holds each origin's range.
+     */
+    void allOrNothing(const vector<TrafficDemand>& demand, const vector<size_t>& originStart,
+                      const vector<double>& time, vector<double>& flow, vector<double>& pathTime) const {
+        size_t nodes = arcStart.size() - 1;
+        size_t segments = capacity.size();
+        vector<int64_t> total(segments, 0);
+        mutex mergeLock;
+
+        pool->parallelFor(0, originStart.size() - 1, [&](size_t first, size_t last) {
+            vector<double> dist(nodes, numeric_limits<double>::infinity());
+            vector<uint32_t> viaSegment(nodes), viaNode(nodes);
+            vector<char> wanted(nodes, 0);
+            vector<int64_t> load(nodes, 0);
+            vector<uint32_t> settled;
+            vector<pair<double, uint32_t>> open;
+            vector<int64_t> local(segments, 0);
+            auto later = greater<pair<double, uint32_t>>();
+
+            for (size_t o = first; o < last; o++) {
+                uint32_t origin = demand[originStart[o]].origin;
+                size_t remaining = 0;
+                for (size_t k = originStart[o]; k < originStart[o + 1]; k++) {
+                    if (!wanted[demand[k].destination]) remaining++;
+                    wanted[demand[k].destination] = 1;
+                }
+
+                // Shortest-path tree from the origin, until every destination is settled
+                dist[origin] = 0.0;
+                open.push_back({0.0, origin});
+                while (!open.empty() && remaining > 0) {
+                    pop_heap(open.begin(), open.end(), later);
+                    pair<double, uint32_t> top = open.back();
+                    open.pop_back();
+                    if (top.first > dist[top.second]) continue;
+                    settled.push_back(top.second);
+                    if (wanted[top.second]) remaining--;
+                    for (size_t a = arcStart[top.second]; a < arcStart[top.second + 1]; a++) {
+                        double d = top.first + time[arcs[a].segment];
+                        if (d < dist[arcs[a].to]) {
+                            dist[arcs[a].to] = d;
+                            viaSegment[arcs[a].to] = arcs[a].segment;
+                            viaNode[arcs[a].to] = top.second;
+                            open.push_back({d, arcs[a].to});
+                            push_heap(open.begin(), open.end(), later);
+                        }
+                    }
+                }
+                open.clear();
+
+                // Load each destination's demand and pass it down the tree towards the origin
+                for (size_t k = originStart[o]; k < originStart[o + 1]; k++) {
+                    const TrafficDemand& trip = demand[k];
+                    pathTime[k] = dist[trip.destination];
+                    wanted[trip.destination] = 0;
+                    if (dist[trip.destination] != numeric_limits<double>::infinity()) {
+                        load[trip.destination] += llround(trip.vehicles * FLOW_UNIT);
+                    }
+                }
+                for (size_t i = settled.size(); i-- > 1;) {
+                    uint32_t node = settled[i];
+                    if (load[node] != 0) {
+                        local[viaSegment[node]] += load[node];
+                        load[viaNode[node]] += load[node];
+                        load[node] = 0;
+                    }
+                }
+                load[origin] = 0;
+
+                // Nodes reached but never settled still hold a distance
+                for (uint32_t node : settled) {
+                    for (size_t a = arcStart[node]; a < arcStart[node + 1]; a++) {
+                        dist[arcs[a].to] = numeric_limits<double>::infinity();
+                    }
+                    dist[node] = numeric_limits<double>::infinity();
+                }
+                settled.clear();
+            }
+
+            lock_guard<mutex> lock(mergeLock);
+            for (size_t s = 0; s < segments; s++) total[s] += local[s];
+        }, 4);
+
+        flow.resize(segments);
+        for (size_t s = 0; s < segments; s++) flow[s] = total[s] / FLOW_UNIT;
+    }
+
+public:
+    static constexpr double DEFAULT_CAPACITY = 1800.0;   // vehicles per hour
+    static constexpr double DEFAULT_SPEED_KMH = 40.0;
+    static constexpr double IDLING_SHARE = 0.6;          // part of fuel use that grows with time stuck in traffic
+
+    // threadCount = 0 uses every hardware thread
+    TrafficAssignment(shared_ptr<const StreetNetwork> streets, size_t threadCount = 0)
+        : network(move(streets)), speedKmh(DEFAULT_SPEED_KMH), alpha(0.15), beta(4.0),
+          maxIterations(50), gapTolerance(1e-4), pool(make_shared<ThreadPool>(threadCount)) {
+        if (!network) {
+            throw invalid_argument("Traffic assignment needs a street network");
+        }
+        size_t nodes = network->getIntersectionCount();
+        size_t segments = network->getSegmentCount();
+        if (nodes >= UINT32_MAX || segments >= UINT32_MAX) {
+            throw out_of_range("Street network is too large for traffic assignment");
+        }
+
+        arcStart.assign(nodes + 1, 0);
+        for (size_t s = 0; s < segments; s++) {
+            arcStart[network->getSegment(s).from + 1]++;
+            arcStart[network->getSegment(s).to + 1]++;
+        }
+        for (size_t v = 0; v < nodes; v++) arcStart[v + 1] += arcStart[v];
+        arcs.resize(arcStart[nodes]);
+        vector<size_t> next(arcStart.begin(), arcStart.end() - 1);
+        for (size_t s = 0; s < segments; s++) {
+            const StreetSegment& seg = network->getSegment(s);
+            arcs[next[seg.from]++] = {uint32_t(seg.to), uint32_t(s)};
+            arcs[next[seg.to]++] = {uint32_t(seg.from), uint32_t(s)};
+        }
+
+        capacity.assign(segments, DEFAULT_CAPACITY);
+        setFreeFlowSpeed(DEFAULT_SPEED_KMH);
+    }
+
+    const StreetNetwork& getNetwork() const { return *network; }
+
+    void setFreeFlowSpeed(double kmh) {
+        if (kmh <= 0) {
+            throw invalid_argument("Free-flow speed must be positive");
+        }
+        speedKmh = kmh;
+        freeFlowTime.resize(network->getSegmentCount());
+        for (size_t s = 0; s < freeFlowTime.size(); s++) {
+            freeFlowTime[s] = network->getSegment(s).length / 1000.0 / speedKmh;
+        }
+    }
+
+    // Capacity of every segment of a street, in vehicles per hour
+    void setStreetCapacity(int street, double vehiclesPerHour) {
+        if (vehiclesPerHour <= 0) {
+            throw invalid_argument("Street capacity must be positive");
+        }
+        bool found = false;
+        for (size_t s = 0; s < capacity.size(); s++) {
+            if (network->getSegment(s).street != street) continue;
+            capacity[s] = vehiclesPerHour;
+            found = true;
+        }
+        if (!found) {
+            throw invalid_argument("Street " + to_string(street) + " is not on the street network");
+        }
+    }
+
+    void setVolumeDelay(double a, double b) {
+        if (a < 0 || b < 1) {
+            throw invalid_argument("Volume-delay function needs alpha >= 0 and beta >= 1");
+        }
+        alpha = a;
+        beta = b;
+    }
+
+    void setConvergence(size_t iterations, double relativeGap) {
+        if (iterations == 0 || relativeGap < 0) {
+            throw invalid_argument("Assignment needs at least one iteration and a non-negative gap");
+        }
+        maxIterations = iterations;
+        gapTolerance = relativeGap;
+    }
+
+    double getCapacity(size_t segment) const { return capacity.at(segment); }
+
+    // BPR travel time of a segment in hours
+    double travelTime(size_t segment, double flow) const {
+        return freeFlowTime[segment] * (1.0 + alpha * pow(flow / capacity[segment], beta));
+    }
+
+    // Peak-hour vehicles (in car equivalents) one commuter adds by transport type
+    static double commuterVehicles(const string& transportType) {
+        if (transportType == "Car") return 1.0;
+        if (transportType == "Bike") return 0.5;
+        if (transportType == "Bus") return 3.0 / 40.0;   // a bus is three cars and carries forty riders
+        return 0.0;                                     // bicycles, trains and planes stay off the roads
+    }
+
+    // Emissions multiplier of a trip that takes delayRatio times its free-flow time
+    static double emissionFactor(double delayRatio) {
+        return 1.0 + IDLING_SHARE * max(0.0, delayRatio - 1.0);
+    }
+
+    // Intersection nearest to an address along its segment, or NONE if it is off the network
+    uint32_t nodeOf(const Address& address) const {
+        size_t s = network->segmentOf(address);
+        if (s == StreetNetwork::NONE) return numeric_limits<uint32_t>::max();
+        const StreetSegment& seg = network->getSegment(s);
+        bool nearStart = 2 * (address.houseNo - seg.firstHouse) <= seg.lastHouse - seg.firstHouse;
+        return uint32_t(nearStart ? seg.from : seg.to);
+    }
+
+    /**
+     * Assign the demand to equilibrium. tripDelayRatio, if given, receives each
+     * demand's congested over free-flow travel time, in the order of demand.
+     */
+    TrafficReport assign(const vector<TrafficDemand>& trips, int day, vector<double>* tripDelayRatio = nullptr) const {
+        size_t segments = capacity.size();
+        for (const auto& trip : trips) {
+            if (trip.origin >= arcStart.size() - 1 || trip.destination >= arcStart.size() - 1 || trip.vehicles < 0) {
+                throw invalid_argument("Traffic demand must join two intersections with non-negative vehicles");
+            }
+        }
+
+        // Group the demand by origin
+        vector<size_t> order(trips.size());
+        for (size_t k = 0; k < order.size(); k++) order[k] = k;
+        stable_sort(order.begin(), order.end(), [&trips](size_t a, size_t b) { return trips[a].origin < trips[b].origin; });
+        vector<TrafficDemand> demand;
+        vector<size_t> originStart;
+        demand.reserve(trips.size());
+        for (size_t k = 0; k < order.size(); k++) {
+            if (k == 0 || trips[order[k]].origin != trips[order[k - 1]].origin) originStart.push_back(k);
+            demand.push_back(trips[order[k]]);
+        }
+        originStart.push_back(demand.size());
+
+        TrafficReport report{};
+        report.day = day;
+        for (const auto& trip : demand) report.peakVehicles += trip.vehicles;
+
+        vector<double> time(freeFlowTime), flow, target;
+        vector<double> freeTime(demand.size()), pathTime(demand.size());
+        allOrNothing(demand, originStart, time, flow, freeTime);
+
+        for (size_t iteration = 1; iteration <= maxIterations; iteration++) {
+            report.iterations = iteration;
+            pool->parallelFor(0, segments, [&](size_t first, size_t last) {
+                for (size_t s = first; s < last; s++) time[s] = travelTime(s, flow[s]);
+            }, BLOCK);
+            allOrNothing(demand, originStart, time, target, pathTime);
+
+            double current = sumSegments([&](size_t s) { return flow[s] * time[s]; });
+            double shortest = 0.0;
+            for (size_t k = 0; k < demand.size(); k++) {
+                if (pathTime[k] != numeric_limits<double>::infinity()) shortest += demand[k].vehicles * pathTime[k];
+            }
+            report.relativeGap = current > 0 ? (current - shortest) / current : 0.0;
+            if (report.relativeGap <= gapTolerance) break;
+
+            // Step size: bisection on the derivative of the Beckmann objective along flow -> target
+            double low = 0.0, high = 1.0;
+            for (int k = 0; k < 30; k++) {
+                double step = (low + high) / 2.0;
+                double slope = sumSegments([&](size_t s) {
+                    double towards = target[s] - flow[s];
+                    return towards == 0.0 ? 0.0 : towards * travelTime(s, flow[s] + step * towards);
+                });
+                (slope > 0 ? high : low) = step;
+            }
+            double step = (low + high) / 2.0;
+            for (size_t s = 0; s < segments; s++) flow[s] += step * (target[s] - flow[s]);
+        }
+
+        report.flow.resize(segments);
+        report.delayRatio.resize(segments);
+        for (size_t s = 0; s < segments; s++) {
+            report.flow[s] = static_cast<float>(flow[s]);
+            report.delayRatio[s] = static_cast<float>(1.0 + alpha * pow(flow[s] / capacity[s], beta));
+            if (flow[s] > capacity[s]) report.congestedSegments++;
+        }
+
+        // Trip delays from the last shortest-path times, in the caller's order
+        double weighted = 0.0, vehicles = 0.0;
+        if (tripDelayRatio) tripDelayRatio->assign(trips.size(), 1.0);
+        for (size_t k = 0; k < demand.size(); k++) {
+            double ratio = 1.0;
+            if (freeTime[k] > 0 && pathTime[k] != numeric_limits<double>::infinity()) ratio = pathTime[k] / freeTime[k];
+            if (tripDelayRatio) (*tripDelayRatio)[order[k]] = ratio;
+            weighted += demand[k].vehicles * ratio;
+            vehicles += demand[k].vehicles;
+        }
+        report.meanTripDelayRatio = vehicles > 0 ? weighted / vehicles : 1.0;
+        return report;
+    }
+};
+
+#endif // TRAFFICASSIGNMENT_H
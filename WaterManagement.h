@@ -69,6 +69,14 @@ public:
         consumptionCubicMeters += cubicMeters;
     }
 
+    // Remove consumption that was covered without mains water (e.g. harvested rainwater)
+    void creditConsumption(double cubicMeters) {
+        if (cubicMeters < 0) {
+            throw invalid_argument("Water consumption credit cannot be negative.");
+        }
+        consumptionCubicMeters = max(0.0, consumptionCubicMeters - cubicMeters);
+    }
+
     // Calculate the bill based on tiered pricing
     double calculateBill() const {
         if (currentPlan == WaterTariffPlan::NO_SUPPLY) {
@@ -145,6 +153,12 @@ public:
         cout << "----------------------------------------------------" << endl;
     }
 
+    const Address* getServiceAddress() const override { return &address; }
+
+    unique_ptr<Services> clone() const override {
+        return make_unique<WaterManagement>(*this);
+    }
+
     virtual ~WaterManagement() override = default;
 };
 
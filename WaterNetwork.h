@@ -0,0 +1,114 @@
+#ifndef WATERNETWORK_H
+#define WATERNETWORK_H
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <unordered_map>
+#include <algorithm>
+
+#include "PipeNetwork.h"
+
+using namespace std;
+
+// Daily balance of one supply zone (all accounts and buildings sharing a pin code)
+struct WaterZoneResult {
+    string zone;
+    double demandM3;      // metered consumption since the previous tick
+    double harvestedM3;   // rainwater used instead of mains water
+    double suppliedM3;    // drawn from the mains
+    double headMeters;
+    bool lowPressure;     // below the minimum service head, or cut off from every reservoir
+};
+
+struct WaterNetworkReport {
+    int day;
+    vector<WaterZoneResult> zones;
+    vector<double> mainFlows;      // m^3/day per main, in the order the mains were added
+    double totalDemand;
+    double totalHarvested;
+    double totalSupplied;
+    size_t lowPressureZones;
+    SolveResult solver;
+
+    void display() const {
+        cout << "\n===== WATER NETWORK FOR DAY " << day << " =====" << endl;
+        for (const auto& z : zones) {
+            cout << "Zone " << (z.zone.empty() ? "(unassigned)" : z.zone) << ": demand " << z.demandM3
+                 << " m^3, harvested " << z.harvestedM3 << " m^3, supplied " << z.suppliedM3
+                 << " m^3, head " << z.headMeters << " m" << (z.lowPressure ? " LOW PRESSURE" : "") << endl;
+        }
+        cout << "Total supplied: " << totalSupplied << " m^3 (" << totalHarvested << " m^3 harvested), "
+             << lowPressureZones << " low-pressure zones, solved in " << solver.iterations << " iterations" << endl;
+        cout << "=============================================" << endl;
+    }
+};
+
+/**
+ * Water mains between supply zones and reservoirs.
+ * Zones are keyed by pin code. Each tick the zones' metered demand, less the
+ * rainwater harvested in the zone, is drawn from the network and the heads and
+ * main flows are solved; zones below the minimum head are flagged.
+ */
+class WaterNetwork : public PipeNetwork {
+private:
+    double minimumHead;
+
+public:
+    // Rainwater collected per square meter of harvesting green space per day
+    static constexpr double HARVEST_M3_PER_SQM = 0.003;
+
+    explicit WaterNetwork(double minimumServiceHead = 20.0) : minimumHead(minimumServiceHead) {}
+
+    size_t addReservoir(const string& name, double headMeters) { return addSource(name, headMeters); }
+    size_t addZone(const string& pin) { return addNode(pin); }
+
+    // conductance in m^3/day per meter of head difference
+    void addMain(const string& from, const string& to, double conductance) { addPipe(from, to, conductance); }
+
+    double getMinimumHead() const { return minimumHead; }
+
+    // Solve one tick; zones that appear only in the demand are added unconnected
+    WaterNetworkReport simulate(int day, const unordered_map<string, double>& zoneDemand,
+                                const unordered_map<string, double>& zoneHarvest) {
+        for (const auto& entry : zoneDemand) addZone(entry.first);
+
+        WaterNetworkReport report{};
+        report.day = day;
+
+        size_t n = getNodeCount();
+        vector<double> draw(n, 0.0);
+        for (size_t node = 0; node < n; node++) {
+            if (getIsSource(node)) continue;
+            WaterZoneResult zone{nodeNames[node], 0.0, 0.0, 0.0, 0.0, false};
+            auto demand = zoneDemand.find(zone.zone);
+            if (demand != zoneDemand.end()) zone.demandM3 = demand->second;
+            auto harvest = zoneHarvest.find(zone.zone);
+            if (harvest != zoneHarvest.end()) zone.harvestedM3 = min(harvest->second, zone.demandM3);
+            zone.suppliedM3 = zone.demandM3 - zone.harvestedM3;
+            draw[node] = zone.suppliedM3;
+            report.zones.push_back(zone);
+        }
+
+        Solution solution = solve(draw);
+        report.solver = solution.stats;
+        report.mainFlows = solution.flow;
+
+        size_t z = 0;
+        for (size_t node = 0; node < n; node++) {
+            if (getIsSource(node)) continue;
+            WaterZoneResult& zone = report.zones[z++];
+            zone.headMeters = solution.head[node];
+            zone.lowPressure = !solution.supplied[node] || zone.headMeters < minimumHead;
+            if (!solution.supplied[node]) zone.suppliedM3 = 0.0;
+
+            report.totalDemand += zone.demandM3;
+            report.totalHarvested += zone.harvestedM3;
+            report.totalSupplied += zone.suppliedM3;
+            if (zone.lowPressure) report.lowPressureZones++;
+        }
+        return report;
+    }
+};
+
+#endif // WATERNETWORK_H
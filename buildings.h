@@ -6,8 +6,22 @@
 #include <memory>
 #include <iostream>
 
+#include "Address.h"
+
 using namespace std;
 
+// Concrete kind of a building, so tallies need no dynamic_cast chain
+enum class BuildingKind {
+    GENERIC,
+    RESIDENTIAL,
+    COMMERCIAL,
+    GREEN_BUILDING,   // GREEN alone clashes with the colour macro in main.cpp
+    INDUSTRIAL,
+    RECREATIONAL,
+    EDUCATIONAL,
+    COUNT
+};
+
 /**
  * Building base class for all city structures
  */
@@ -16,6 +30,7 @@ private:
     string name;
     double ecoScoreImpact;
     int capacity;
+    Address address; // also decides the district the building belongs to (by pin)
     
 public:
     // Constructor
@@ -29,10 +44,12 @@ public:
     string getName() const { return name; }
     double getEcoScoreImpact() const { return ecoScoreImpact; }
     int getCapacity() const { return capacity; }
+    const Address& getAddress() const { return address; }
     
     // Setters
     void setEcoScoreImpact(double impact) { ecoScoreImpact = impact; }
     void setCapacity(int cap) { capacity = cap; }
+    void setAddress(const Address& addr) { address = addr; }
     
     // Virtual function to display building info
     virtual void displayInfo() const {
@@ -41,9 +58,26 @@ public:
         cout << "Capacity: " << capacity << endl;
     }
     
-    // Virtual function to update eco score
+    // Virtual function computing the eco score impact from the building's current state
+    virtual double computeEcoScoreImpact() const {
+        // Base implementation keeps the stored impact
+        return ecoScoreImpact;
+    }
+    
+    // Update eco score; the field is only written when the value changes,
+    // so buildings shared between forked cities are left untouched
     virtual void updateEcoScore() {
-        // Base implementation does nothing
+        double impact = computeEcoScoreImpact();
+        if (impact != ecoScoreImpact) {
+            ecoScoreImpact = impact;
+        }
+    }
+    
+    virtual BuildingKind getKind() const { return BuildingKind::GENERIC; }
+    
+    // Virtual copy constructor
+    virtual unique_ptr<Building> clone() const {
+        return make_unique<Building>(*this);
     }
 };
 
@@ -70,10 +104,16 @@ public:
         cout << "Current Residents: " << residents << endl;
     }
     
-    // Override update eco score
-    void updateEcoScore() override {
+    // Override eco score computation
+    double computeEcoScoreImpact() const override {
         // Each resident has some impact on eco score
-        setEcoScoreImpact(5.0 + (residents * 0.5));
+        return 5.0 + (residents * 0.5);
+    }
+    
+    BuildingKind getKind() const override { return BuildingKind::RESIDENTIAL; }
+    
+    unique_ptr<Building> clone() const override {
+        return make_unique<ResidentialBuilding>(*this);
     }
 };
 
@@ -105,10 +145,16 @@ public:
         cout << "Energy Usage: " << energyUsage << " kWh" << endl;
     }
     
-    // Override update eco score
-    void updateEcoScore() override {
+    // Override eco score computation
+    double computeEcoScoreImpact() const override {
         // Business count and energy usage impacts eco score
-        setEcoScoreImpact(10.0 + (businessCount * 2.0) + (energyUsage * 0.05));
+        return 10.0 + (businessCount * 2.0) + (energyUsage * 0.05);
+    }
+    
+    BuildingKind getKind() const override { return BuildingKind::COMMERCIAL; }
+    
+    unique_ptr<Building> clone() const override {
+        return make_unique<CommercialBuilding>(*this);
     }
 };
 
@@ -144,14 +190,20 @@ public:
         cout << "Green Space Area: " << greenSpaceArea << " sq. meters" << endl;
     }
     
-    // Override update eco score
-    void updateEcoScore() override {
+    // Override eco score computation
+    double computeEcoScoreImpact() const override {
         // Green features have positive impact (negative value means positive for environment)
         double impact = -50.0;
         impact -= (solarOutput * 0.5);
         if (rainwaterHarvesting) impact -= 20.0;
         impact -= (greenSpaceArea * 0.1);
-        setEcoScoreImpact(impact);
+        return impact;
+    }
+    
+    BuildingKind getKind() const override { return BuildingKind::GREEN_BUILDING; }
+    
+    unique_ptr<Building> clone() const override {
+        return make_unique<GreenBuilding>(*this);
     }
 };
 
@@ -183,13 +235,19 @@ public:
         cout << "Pollution Control: " << (hasPollutionControl ? "Installed" : "Not Installed") << endl;
     }
     
-    // Override update eco score
-    void updateEcoScore() override {
+    // Override eco score computation
+    double computeEcoScoreImpact() const override {
         // Pollution rate affects eco score
         double impact = 100.0;
         impact += pollutionRate;
         if (hasPollutionControl) impact *= 0.5; // Reduce impact by half if control measures are in place
-        setEcoScoreImpact(impact);
+        return impact;
+    }
+    
+    BuildingKind getKind() const override { return BuildingKind::INDUSTRIAL; }
+    
+    unique_ptr<Building> clone() const override {
+        return make_unique<IndustrialBuilding>(*this);
     }
 };
 
@@ -224,13 +282,19 @@ public:
         cout << "Visitor Capacity: " << visitorCapacity << endl;
     }
     
-    // Override update eco score
-    void updateEcoScore() override {
+    // Override eco score computation
+    double computeEcoScoreImpact() const override {
         // Green area has positive impact, but visitor capacity can increase negative impact
         double impact = -20.0;
         impact -= (greenArea * 0.01);
         impact += (visitorCapacity * 0.05);
-        setEcoScoreImpact(impact);
+        return impact;
+    }
+    
+    BuildingKind getKind() const override { return BuildingKind::RECREATIONAL; }
+    
+    unique_ptr<Building> clone() const override {
+        return make_unique<RecreationalBuilding>(*this);
     }
 };
 
@@ -265,12 +329,18 @@ public:
         cout << "Energy Efficiency: " << energyEfficiency << "/100" << endl;
     }
     
-    // Override update eco score
-    void updateEcoScore() override {
+    // Override eco score computation
+    double computeEcoScoreImpact() const override {
         // Students increase impact, but efficiency can decrease it
         double impact = students * 0.1;
         impact *= (1.0 - (energyEfficiency / 100.0)); // Higher efficiency means lower impact
-        setEcoScoreImpact(impact);
+        return impact;
+    }
+    
+    BuildingKind getKind() const override { return BuildingKind::EDUCATIONAL; }
+    
+    unique_ptr<Building> clone() const override {
+        return make_unique<EducationalBuilding>(*this);
     }
 };
 
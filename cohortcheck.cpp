@@ -0,0 +1,159 @@
+// Self-check for cohort mode: a city run with cohorts against the same city run
+// citizen by citizen, with citizens joining, being edited and commuting on streets
+//
+//   cohortcheck [seed]
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <set>
+#include <random>
+#include <cmath>
+#include <algorithm>
+
+#include "SelfCheck.h"
+#include "City.h"
+
+using namespace std;
+
+using SelfCheck::check;
+
+static bool same(double a, double b) {
+    return abs(a - b) <= 1e-9 * max(1.0, max(abs(a), abs(b)));
+}
+
+struct Profile {
+    int age;
+    double awareness;
+    double distance;
+    int building;
+    int vehicle;   // -1 walks
+};
+
+/**
+ * One of two identical cities; every change is applied to both, and the
+ * second one runs in cohort mode.
+ */
+struct Scenario {
+    vector<Profile> profiles;
+    vector<pair<Address, Address>> commutes;   // empty: nobody commutes
+    StreetNetwork streets;
+    int people;
+    int days;
+};
+
+static void addPerson(City& city, const Scenario& scenario, int person, mt19937& rng) {
+    const Profile& p = scenario.profiles[rng() % scenario.profiles.size()];
+    auto citizen = make_unique<Citizen>("P" + to_string(person), p.age, p.awareness, "Clerk", p.distance);
+    citizen->assignBuilding(&city.getBuilding(p.building));
+    if (p.vehicle >= 0) citizen->chooseTransport(&city.getTransport(p.vehicle));
+    if (!scenario.commutes.empty()) {
+        const auto& trip = scenario.commutes[rng() % scenario.commutes.size()];
+        citizen->setCommute(trip.first, trip.second);
+    }
+    city.addCitizen(move(citizen));
+}
+
+static unique_ptr<City> build(const Scenario& scenario, bool cohorts, unsigned seed) {
+    auto city = make_unique<City>(cohorts ? "Cohorts" : "Citizens", "Mayor", 1e6);
+    city->setLogLevel(LogLevel::WARNING);
+    city->addBuilding(make_unique<GreenBuilding>("Park", 40));
+    city->addBuilding(make_unique<ResidentialBuilding>("Tower", 300));
+    city->addBuilding(make_unique<CommercialBuilding>("Mall", 50));
+    city->addTransport(make_unique<Car>(12.0, 6.5, 9.0, "Petrol", 3, "Shared"));
+    city->addTransport(make_unique<Bus>(30.0, 25.0, 30.0, "Diesel", 2));
+    city->addTransport(make_unique<Train>(80.0, 0.0, 0.0, "Electric", 5));
+    city->addTransport(make_unique<Bicycle>(5.0));
+
+    // Both cities draw the same people from the same sequence
+    mt19937 rng(seed);
+    for (int person = 0; person < scenario.people; person++) addPerson(*city, scenario, person, rng);
+    if (!scenario.commutes.empty()) {
+        city->setStreetNetwork(scenario.streets);
+        city->enableCommuteRouting(2);
+    }
+    if (cohorts) city->enableCohortMode();
+
+    for (int day = 1; day <= scenario.days; day++) {
+        city->simulateDay();
+        // Newcomers join an existing cohort or start one
+        if (day % 7 == 3) {
+            for (int person = 0; person < 25; person++) addPerson(*city, scenario, scenario.people + day * 100 + person, rng);
+        }
+        // Editing a citizen takes it out of its cohort
+        if (day % 9 == 5) {
+            size_t index = rng() % city->getPopulation();
+            city->getCitizen(index).setDailyTravelDistance(1.0 + rng() % 40);
+        }
+    }
+    return city;
+}
+
+static void compare(const string& name, const Scenario& scenario, unsigned seed) {
+    unique_ptr<City> plain = build(scenario, false, seed);
+    unique_ptr<City> cohort = build(scenario, true, seed);
+    size_t cohortCount = cohort->getCohortCount();
+
+    check(same(plain->getEcoScore(), cohort->getEcoScore()), name + ": eco score");
+    check(same(plain->getBudget(), cohort->getBudget()), name + ": budget");
+    PollutionLevels a = plain->getPollutionControl().getLevels(), b = cohort->getPollutionControl().getLevels();
+    check(same(a.air, b.air) && same(a.water, b.water) && same(a.noise, b.noise) && same(a.solidWaste, b.solidWaste),
+          name + ": pollution levels");
+
+    CitySummary s = plain->getSummary(), t = cohort->getSummary();
+    check(same(s.averageCitizenEcoScore, t.averageCitizenEcoScore), name + ": average citizen eco score");
+    check(s.topCitizens == t.topCitizens, name + ": top citizens");
+
+    // Writing the cohorts back must give every citizen the state it has in the plain run
+    cohort->disableCohortMode();
+    check(plain->getPopulation() == cohort->getPopulation(), name + ": population");
+    set<CohortKey> distinct;
+    for (int i = 0; i < plain->getPopulation(); i++) {
+        const Citizen& x = static_cast<const City&>(*plain).getCitizen(i);
+        const Citizen& y = static_cast<const City&>(*cohort).getCitizen(i);
+        distinct.insert(makeCohortKey(x));
+        // The cohort key holds building and vehicle pointers, which differ between the cities
+        if (x.getEcoAwareness() != y.getEcoAwareness() || x.getDailyTravelDistance() != y.getDailyTravelDistance() ||
+            x.getEcoFriendlyDays() != y.getEcoFriendlyDays() || x.getHasGreenBadge() != y.getHasGreenBadge() ||
+            x.getTotalDistanceTraveled() != y.getTotalDistanceTraveled() || x.calculateEcoScore() != y.calculateEcoScore()) {
+            check(false, name + ": state of citizen " + to_string(i));
+        }
+    }
+
+    // Cohorts only split for edited citizens, so they stay close to the distinct states
+    size_t edits = scenario.days / 9 + 1;
+    check(cohortCount <= distinct.size() + edits, name + ": " + to_string(cohortCount) + " cohorts for " +
+          to_string(distinct.size()) + " distinct citizens");
+}
+
+static Scenario randomScenario(int people, int days, bool commuting, mt19937& rng) {
+    Scenario scenario;
+    scenario.people = people;
+    scenario.days = days;
+    int profiles = uniform_int_distribution<int>(3, 12)(rng);
+    for (int p = 0; p < profiles; p++) {
+        scenario.profiles.push_back({uniform_int_distribution<int>(18, 70)(rng), (rng() % 11) / 10.0,
+                                     double(1 + rng() % 30), int(rng() % 3), int(rng() % 5) - 1});
+    }
+    if (commuting) {
+        scenario.streets = StreetNetwork::grid(8, 8, 10, 150.0);
+        int pairs = uniform_int_distribution<int>(2, 20)(rng);
+        for (int k = 0; k < pairs; k++) {
+            auto address = [&rng]() {
+                // Streets 1..8 run north-south, 9..16 east-west; house 999 is off the network
+                return (rng() % 20 == 0) ? Address(1, 999) : Address(1 + rng() % 16, rng() % 70);
+            };
+            scenario.commutes.push_back({address(), address()});
+        }
+    }
+    return scenario;
+}
+
+int main(int argc, char* argv[]) {
+    return SelfCheck::run("cohortcheck", argc, argv, [](mt19937& rng) {
+        for (int trial = 0; trial < 4; trial++) {
+            compare("profiles " + to_string(trial), randomScenario(2000, 30, false, rng), rng());
+            compare("commutes " + to_string(trial), randomScenario(2000, 20, true, rng), rng());
+        }
+    });
+}
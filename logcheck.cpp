@@ -0,0 +1,124 @@
+// Self-check for log storage: block compression round trips, and LogStore
+// searches against a linear scan across open, spilled and compressed segments
+//
+//   logcheck [seed]
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <ctime>
+
+#include "SelfCheck.h"
+#include "BlockCompressor.h"
+#include "LogStore.h"
+
+using namespace std;
+
+using SelfCheck::check;
+
+static bool roundTrips(const string& data) {
+    string packed = BlockCompressor::compress(data.data(), data.size());
+    vector<char> out(data.size() + BlockCompressor::SLACK);
+    BlockCompressor::decompress(packed.data(), packed.size(), out.data(), data.size());
+    return string(out.data(), data.size()) == data;
+}
+
+static void checkCompressor(mt19937& rng) {
+    uniform_int_distribution<int> byte(0, 255), letter('a', 'e');
+    for (size_t size : {0, 1, 3, 4, 7, 8, 9, 15, 16, 17, 100, 4095, 65536, 200000}) {
+        string random(size, '\0'), repetitive(size, '\0'), runs(size, 'x');
+        for (size_t i = 0; i < size; i++) {
+            random[i] = static_cast<char>(byte(rng));
+            repetitive[i] = "Monitored building: Tower "[i % 26];
+            if (i % 97 < 3) runs[i] = static_cast<char>(letter(rng));
+        }
+        check(roundTrips(random), "random block of " + to_string(size) + " bytes");
+        check(roundTrips(repetitive), "repetitive block of " + to_string(size) + " bytes");
+        check(roundTrips(runs), "run-length block of " + to_string(size) + " bytes");
+    }
+
+    // Short alphabets give overlapping matches at every offset below the 8-byte word copy
+    for (int trial = 0; trial < 200; trial++) {
+        size_t size = uniform_int_distribution<size_t>(1, 5000)(rng);
+        int alphabet = uniform_int_distribution<int>(1, 4)(rng);
+        string data(size, '\0');
+        for (char& c : data) c = static_cast<char>('a' + uniform_int_distribution<int>(0, alphabet - 1)(rng));
+        check(roundTrips(data), "small-alphabet block, trial " + to_string(trial));
+    }
+
+    // A corrupt block throws instead of writing out of bounds
+    string packed = BlockCompressor::compress("abcdabcdabcdabcd", 16);
+    packed[0] = static_cast<char>(0x7F);
+    vector<char> out(16 + BlockCompressor::SLACK);
+    bool threw = false;
+    try {
+        BlockCompressor::decompress(packed.data(), packed.size(), out.data(), 16);
+    } catch (const runtime_error&) {
+        threw = true;
+    }
+    check(threw, "corrupt block is rejected");
+}
+
+static vector<pair<time_t, string>> linearFind(const vector<pair<time_t, string>>& lines, const string& term,
+                                               time_t from, time_t to) {
+    vector<pair<time_t, string>> found;
+    for (const auto& line : lines) {
+        if (line.first >= from && line.first <= to && line.second.find(term) != string::npos) found.push_back(line);
+    }
+    return found;
+}
+
+static void checkStore(mt19937& rng) {
+    static const char* words[] = {"Monitored", "building", "citizen", "Tower", "eco", "score", "day", "completed",
+                                  "WARNING", "Air", "pollution", "threshold", "exceeded", "bus", "route"};
+    LogStore store(256 << 10);
+    vector<pair<time_t, string>> lines;
+    time_t now = 1700000000;
+    for (int i = 0; i < 60000; i++) {
+        // Spill the first third plain, the second third compressed; the tail stays open in memory
+        if (i == 20000) store.setCompression(true);
+        if (i % 7 == 0) now += uniform_int_distribution<int>(0, 400)(rng);
+        string text;
+        int count = uniform_int_distribution<int>(1, 6)(rng);
+        for (int w = 0; w < count; w++) {
+            if (w) text += ' ';
+            text += words[rng() % (sizeof(words) / sizeof(words[0]))];
+            if (rng() % 3 == 0) text += to_string(rng() % 1000);
+        }
+        store.append(now, text);
+        lines.emplace_back(now, text);
+    }
+    check(store.getDiskUsage() > 0, "segments spilled to disk");
+    check(store.size() == lines.size(), "line count");
+
+    vector<pair<time_t, string>> all;
+    store.forEach([&all](time_t when, const string& text) { all.emplace_back(when, text); });
+    check(all == lines, "forEach returns every line in order");
+
+    vector<string> terms = {"", "a", "Tower", "eco score", "score 1", "WARNING Air", "42", "route7", "zzz", "ed d"};
+    for (int i = 0; i < 40; i++) {
+        const string& line = lines[rng() % lines.size()].second;
+        size_t start = rng() % line.size();
+        terms.push_back(line.substr(start, 1 + rng() % 12));
+    }
+    time_t first = lines.front().first, last = lines.back().first;
+    for (const string& term : terms) {
+        vector<pair<time_t, time_t>> ranges = {{first, last}, {first, first + (last - first) / 3},
+                                               {first + (last - first) / 2, last}, {last - 1000, last}};
+        for (const auto& range : ranges) {
+            vector<pair<time_t, string>> found;
+            store.find(term, range.first, range.second,
+                       [&found](time_t when, const string& text) { found.emplace_back(when, text); });
+            check(found == linearFind(lines, term, range.first, range.second),
+                  "find \"" + term + "\" in [" + to_string(range.first) + ", " + to_string(range.second) + "]");
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    return SelfCheck::run("logcheck", argc, argv, [](mt19937& rng) {
+        checkCompressor(rng);
+        checkStore(rng);
+    });
+}
@@ -0,0 +1,58 @@
+// Offline decoder for city binary logs: prints each record as a text log line,
+// marking records whose text was cut short when it was written
+//
+//   logdecode <log file> [text to search for]
+
+#include <iostream>
+#include <string>
+#include <ctime>
+#include <cstdio>
+
+#include "BinaryLog.h"
+
+using namespace std;
+
+// "YYYY-MM-DD HH:MM:SS.nnnnnnnnn" in local time
+static string formatTimestamp(int64_t wallNanoseconds) {
+    time_t seconds = static_cast<time_t>(wallNanoseconds / 1000000000);
+    long nanoseconds = static_cast<long>(wallNanoseconds % 1000000000);
+    if (nanoseconds < 0) {
+        seconds--;
+        nanoseconds += 1000000000;
+    }
+    struct tm tstruct;
+#ifdef _WIN32
+    localtime_s(&tstruct, &seconds);
+#else
+    localtime_r(&seconds, &tstruct);
+#endif
+    char buf[80];
+    strftime(buf, sizeof(buf), "%Y-%m-%d %X", &tstruct);
+    char fraction[16];
+    snprintf(fraction, sizeof(fraction), ".%09ld", nanoseconds);
+    return string(buf) + fraction;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2 || argc > 3) {
+        cerr << "Usage: " << argv[0] << " <log file> [text to search for]" << endl;
+        return 2;
+    }
+    string searchTerm = (argc == 3) ? argv[2] : "";
+
+    try {
+        BinaryLogReader reader(argv[1]);
+        LogRecord record;
+        while (reader.next(record)) {
+            string text = record.text();
+            if (!searchTerm.empty() && text.find(searchTerm) == string::npos) continue;
+            cout << "[" << formatTimestamp(record.wallNanoseconds) << "] " << text;
+            if (record.truncated()) cout << " [truncated]";
+            cout << "\n";
+        }
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
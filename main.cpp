@@ -33,6 +33,10 @@
 #include "City.h"
 #include "CityLogger.h"
 #include "Services.h"
+#include "SampledSimulation.h"
+#include "ScenarioSweep.h"
+#include "IntervalBilling.h"
+#include "ReliabilitySimulation.h"
 
 using namespace std;
 
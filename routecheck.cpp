@@ -0,0 +1,187 @@
+// Self-check for commute routing: contraction hierarchy routes against a plain
+// Dijkstra over the street network, on grids and on random networks
+//
+//   routecheck [seed]
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <queue>
+#include <random>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include "SelfCheck.h"
+#include "StreetNetwork.h"
+#include "CommuteRouter.h"
+
+using namespace std;
+
+using SelfCheck::check;
+
+static bool sameLength(double a, double b) {
+    return abs(a - b) <= 1e-9 * max(1.0, max(abs(a), abs(b)));
+}
+
+// Meters from a house to its segment's first intersection
+static double offsetOf(const StreetSegment& s, int house) {
+    double t = (s.lastHouse > s.firstHouse) ? double(house - s.firstHouse) / (s.lastHouse - s.firstHouse) : 0.5;
+    return min(1.0, max(0.0, t)) * s.length;
+}
+
+// Shortest distance in meters between two addresses, or infinity if not connected
+static double dijkstra(const StreetNetwork& network, const Address& from, const Address& to) {
+    const StreetSegment& a = network.getSegment(network.segmentOf(from));
+    const StreetSegment& b = network.getSegment(network.segmentOf(to));
+    if (&a == &b) return abs(offsetOf(a, from.houseNo) - offsetOf(b, to.houseNo));
+
+    vector<vector<pair<size_t, double>>> graph(network.getIntersectionCount());
+    for (size_t s = 0; s < network.getSegmentCount(); s++) {
+        const StreetSegment& seg = network.getSegment(s);
+        graph[seg.from].push_back({seg.to, seg.length});
+        graph[seg.to].push_back({seg.from, seg.length});
+    }
+    vector<double> dist(graph.size(), numeric_limits<double>::infinity());
+    typedef pair<double, size_t> Item;
+    priority_queue<Item, vector<Item>, greater<Item>> open;
+    double fromOffset = offsetOf(a, from.houseNo);
+    dist[a.from] = fromOffset;
+    dist[a.to] = a.length - fromOffset;
+    open.push({dist[a.from], a.from});
+    open.push({dist[a.to], a.to});
+    while (!open.empty()) {
+        Item top = open.top();
+        open.pop();
+        if (top.first > dist[top.second]) continue;
+        for (const auto& next : graph[top.second]) {
+            if (top.first + next.second < dist[next.first]) {
+                dist[next.first] = top.first + next.second;
+                open.push({dist[next.first], next.first});
+            }
+        }
+    }
+    double toOffset = offsetOf(b, to.houseNo);
+    return min(dist[b.from] + toOffset, dist[b.to] + b.length - toOffset);
+}
+
+// The route's segments must join up and add up to its length
+static bool consistent(const StreetNetwork& network, const Address& from, const Address& to, const CommuteRoute& route) {
+    size_t first = network.segmentOf(from), last = network.segmentOf(to);
+    const vector<uint32_t>& segments = route.segments;
+    if (!binary_search(segments.begin(), segments.end(), first) || !binary_search(segments.begin(), segments.end(), last)) {
+        return false;
+    }
+    if (first == last) return segments.size() == 1;
+
+    // Every segment must be reachable from the first through shared intersections
+    vector<char> reached(segments.size(), 0);
+    vector<size_t> stack = {size_t(lower_bound(segments.begin(), segments.end(), first) - segments.begin())};
+    reached[stack.back()] = 1;
+    while (!stack.empty()) {
+        const StreetSegment& s = network.getSegment(segments[stack.back()]);
+        stack.pop_back();
+        for (size_t i = 0; i < segments.size(); i++) {
+            const StreetSegment& t = network.getSegment(segments[i]);
+            if (!reached[i] && (t.from == s.from || t.from == s.to || t.to == s.from || t.to == s.to)) {
+                reached[i] = 1;
+                stack.push_back(i);
+            }
+        }
+    }
+    if (count(reached.begin(), reached.end(), 0) > 0) return false;
+
+    // Whole middle segments plus one end piece of each address segment
+    double middle = 0.0;
+    for (uint32_t s : segments) {
+        if (s != first && s != last) middle += network.getSegment(s).length;
+    }
+    const StreetSegment& a = network.getSegment(first);
+    const StreetSegment& b = network.getSegment(last);
+    double fromOffset = offsetOf(a, from.houseNo), toOffset = offsetOf(b, to.houseNo);
+    for (double start : {fromOffset, a.length - fromOffset}) {
+        for (double end : {toOffset, b.length - toOffset}) {
+            if (sameLength(middle + start + end, route.km * 1000.0)) return true;
+        }
+    }
+    return false;
+}
+
+static Address randomAddress(const StreetNetwork& network, mt19937& rng) {
+    const StreetSegment& s = network.getSegment(rng() % network.getSegmentCount());
+    return Address(s.street, uniform_int_distribution<int>(s.firstHouse, s.lastHouse)(rng));
+}
+
+static void checkRoutes(const string& name, shared_ptr<const StreetNetwork> network, size_t trips, mt19937& rng) {
+    if (network->getSegmentCount() == 0) return;
+    vector<pair<Address, Address>> batch;
+    for (size_t i = 0; i < trips; i++) batch.emplace_back(randomAddress(*network, rng), randomAddress(*network, rng));
+    batch.emplace_back(batch.front().first, batch.front().first);
+    batch.emplace_back(Address(-1, 0), batch.front().second);
+
+    CommuteRouter router(network, 4);
+    vector<shared_ptr<const CommuteRoute>> routes = router.route(batch);
+    check(routes.size() == batch.size(), name + ": one route per trip");
+    check(!routes.back()->found, name + ": address off the network is not routed");
+
+    for (size_t i = 0; i + 1 < batch.size(); i++) {
+        const Address& from = batch[i].first;
+        const Address& to = batch[i].second;
+        string trip = name + ": " + from.display(true) + " to " + to.display(true);
+        double expected = dijkstra(*network, from, to);
+        if (expected == numeric_limits<double>::infinity()) {
+            check(!routes[i]->found, trip + " is not connected");
+            continue;
+        }
+        check(routes[i]->found, trip + " is found");
+        if (!routes[i]->found) continue;
+        check(sameLength(routes[i]->km * 1000.0, expected), trip + " has the shortest length");
+        check(consistent(*network, from, to, *routes[i]), trip + " drives a connected path of that length");
+    }
+
+    // A second batch is answered from the cache with the same routes
+    size_t misses = router.getCacheMisses();
+    vector<shared_ptr<const CommuteRoute>> again = router.route(batch);
+    check(again == routes, name + ": cached routes are reused");
+    check(router.getCacheMisses() == misses, name + ": no routes recomputed");
+}
+
+/**
+ * Jittered lattice with a random share of blocks missing, some diagonals and
+ * some parallel streets; may fall apart into several pieces.
+ */
+static StreetNetwork randomNetwork(int width, int height, double keep, mt19937& rng) {
+    StreetNetwork network;
+    uniform_real_distribution<double> jitter(-40.0, 40.0), chance(0.0, 1.0);
+    auto name = [](int x, int y) { return to_string(x) + "x" + to_string(y); };
+    for (int x = 0; x < width; x++) {
+        for (int y = 0; y < height; y++) network.addIntersection(name(x, y), x * 100.0 + jitter(rng), y * 100.0 + jitter(rng));
+    }
+    int street = 1;
+    auto link = [&](const string& a, const string& b) {
+        int houses = uniform_int_distribution<int>(0, 20)(rng);
+        network.addSegment(street++, 0, houses, a, b);
+    };
+    for (int x = 0; x < width; x++) {
+        for (int y = 0; y < height; y++) {
+            if (x + 1 < width && chance(rng) < keep) link(name(x, y), name(x + 1, y));
+            if (y + 1 < height && chance(rng) < keep) link(name(x, y), name(x, y + 1));
+            if (x + 1 < width && y + 1 < height && chance(rng) < 0.1) link(name(x, y), name(x + 1, y + 1));
+            if (x + 1 < width && chance(rng) < 0.05) link(name(x + 1, y), name(x, y));
+        }
+    }
+    return network;
+}
+
+int main(int argc, char* argv[]) {
+    return SelfCheck::run("routecheck", argc, argv, [](mt19937& rng) {
+        checkRoutes("grid 1x2", make_shared<const StreetNetwork>(StreetNetwork::grid(1, 2, 10, 100.0)), 50, rng);
+        checkRoutes("grid 12x9", make_shared<const StreetNetwork>(StreetNetwork::grid(12, 9, 20, 120.0)), 2000, rng);
+        for (int trial = 0; trial < 20; trial++) {
+            int width = uniform_int_distribution<int>(2, 30)(rng), height = uniform_int_distribution<int>(2, 30)(rng);
+            double keep = (trial % 4 == 0) ? 0.55 : 0.85;
+            checkRoutes("random network " + to_string(trial),
+                        make_shared<const StreetNetwork>(randomNetwork(width, height, keep, rng)), 500, rng);
+        }
+    });
+}
@@ -0,0 +1,196 @@
+// Self-check for the pipe network solver: multigrid-preconditioned CG against
+// a dense solve and against plain Jacobi CG, on random grounded Laplacians
+//
+//   solvercheck [seed]
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <tuple>
+#include <random>
+#include <cmath>
+#include <algorithm>
+
+#include "SelfCheck.h"
+#include "SparseSolver.h"
+
+using namespace std;
+
+using SelfCheck::check;
+
+static double dot(const vector<double>& a, const vector<double>& b) {
+    double sum = 0.0;
+    for (size_t i = 0; i < a.size(); i++) sum += a[i] * b[i];
+    return sum;
+}
+
+// ||b - A x|| / ||b||, recomputed outside the solver
+static double residualOf(const SparseMatrix& A, const vector<double>& b, const vector<double>& x) {
+    vector<double> Ax;
+    A.multiply(x, Ax);
+    double sum = 0.0;
+    for (size_t i = 0; i < b.size(); i++) sum += (b[i] - Ax[i]) * (b[i] - Ax[i]);
+    return sqrt(sum / dot(b, b));
+}
+
+/**
+ * Reduced Laplacian of a pipe network: pipes with conductances spread over
+ * several orders of magnitude, and a few nodes tied to a fixed-pressure
+ * source, which keeps the matrix positive definite.
+ */
+static SparseMatrix laplacian(size_t n, const vector<pair<size_t, size_t>>& pipes, size_t sources, mt19937& rng) {
+    uniform_real_distribution<double> exponent(-3.0, 3.0);
+    vector<tuple<size_t, size_t, double>> entries;
+    for (const auto& pipe : pipes) {
+        double g = pow(10.0, exponent(rng));
+        entries.emplace_back(pipe.first, pipe.first, g);
+        entries.emplace_back(pipe.second, pipe.second, g);
+        entries.emplace_back(pipe.first, pipe.second, -g);
+        entries.emplace_back(pipe.second, pipe.first, -g);
+    }
+    for (size_t s = 0; s < sources; s++) {
+        size_t node = rng() % n;
+        entries.emplace_back(node, node, pow(10.0, exponent(rng)));
+    }
+    return SparseMatrix::fromTriplets(n, move(entries));
+}
+
+// Square grid with a share of its cross pipes missing; columns and the first row stay whole, so it is connected
+static SparseMatrix gridNetwork(size_t side, mt19937& rng) {
+    vector<pair<size_t, size_t>> pipes;
+    for (size_t y = 0; y < side; y++) {
+        for (size_t x = 0; x < side; x++) {
+            size_t node = y * side + x;
+            if (x + 1 < side && (y == 0 || rng() % 5 != 0)) pipes.push_back({node, node + 1});
+            if (y + 1 < side) pipes.push_back({node, node + side});
+        }
+    }
+    return laplacian(side * side, pipes, 1 + side * side / 100, rng);
+}
+
+// Random tree with extra loops, fed from a few random nodes
+static SparseMatrix looseNetwork(size_t n, mt19937& rng) {
+    vector<pair<size_t, size_t>> pipes;
+    for (size_t node = 1; node < n; node++) pipes.push_back({node, rng() % node});
+    for (size_t loop = 0; loop < n / 4; loop++) {
+        size_t a = rng() % n, b = rng() % n;
+        if (a != b) pipes.push_back({a, b});
+    }
+    return laplacian(n, pipes, 1 + n / 100, rng);
+}
+
+// Dense Gaussian elimination with partial pivoting, as the reference solution
+static vector<double> denseSolve(const SparseMatrix& A, vector<double> b) {
+    size_t n = A.rows;
+    vector<double> m(n * n, 0.0);
+    for (size_t r = 0; r < n; r++) {
+        for (size_t k = A.rowStart[r]; k < A.rowStart[r + 1]; k++) m[r * n + A.column[k]] = A.value[k];
+    }
+    for (size_t c = 0; c < n; c++) {
+        size_t pivot = c;
+        for (size_t r = c + 1; r < n; r++) {
+            if (abs(m[r * n + c]) > abs(m[pivot * n + c])) pivot = r;
+        }
+        if (pivot != c) {
+            for (size_t k = 0; k < n; k++) swap(m[c * n + k], m[pivot * n + k]);
+            swap(b[c], b[pivot]);
+        }
+        for (size_t r = c + 1; r < n; r++) {
+            double f = m[r * n + c] / m[c * n + c];
+            if (f == 0.0) continue;
+            for (size_t k = c; k < n; k++) m[r * n + k] -= f * m[c * n + k];
+            b[r] -= f * b[c];
+        }
+    }
+    vector<double> x(n);
+    for (size_t r = n; r-- > 0;) {
+        double sum = b[r];
+        for (size_t k = r + 1; k < n; k++) sum -= m[r * n + k] * x[k];
+        x[r] = sum / m[r * n + r];
+    }
+    return x;
+}
+
+static vector<double> randomVector(size_t n, mt19937& rng) {
+    uniform_real_distribution<double> value(-1.0, 1.0);
+    vector<double> v(n);
+    for (double& e : v) e = value(rng);
+    return v;
+}
+
+// CG must preserve symmetry and positivity of the preconditioner, or it may stall
+static void checkPreconditioner(const string& name, const AggregationMultigrid& multigrid, size_t n, mt19937& rng) {
+    AggregationMultigrid::Workspace work;
+    for (int trial = 0; trial < 5; trial++) {
+        vector<double> u = randomVector(n, rng), v = randomVector(n, rng), Mu, Mv;
+        multigrid.apply(u, Mu, work);
+        multigrid.apply(v, Mv, work);
+        double uMv = dot(u, Mv), vMu = dot(v, Mu);
+        check(abs(uMv - vMu) <= 1e-8 * max(1.0, sqrt(dot(Mu, Mu) * dot(v, v))), name + ": V-cycle is symmetric");
+        check(dot(u, Mu) > 0.0, name + ": V-cycle is positive");
+    }
+}
+
+static void checkAgainstDense(const string& name, const SparseMatrix& A, size_t coarseLimit, mt19937& rng) {
+    AggregationMultigrid multigrid(A, coarseLimit);
+    checkPreconditioner(name, multigrid, A.rows, rng);
+
+    vector<double> b = randomVector(A.rows, rng), x;
+    vector<double> exact = denseSolve(A, b);
+    SolveResult result = ConjugateGradient::solve(A, b, x, 1e-10, 0, &multigrid);
+    check(result.converged, name + ": converges");
+    // CG updates its residual by recurrence, which drifts from b - A x by rounding on ill-conditioned systems
+    check(residualOf(A, b, x) <= 1e-8, name + ": true residual is small");
+
+    double error = 0.0, norm = 0.0;
+    for (size_t i = 0; i < x.size(); i++) {
+        error = max(error, abs(x[i] - exact[i]));
+        norm = max(norm, abs(exact[i]));
+    }
+    // The system is ill-conditioned by design, so allow for its condition number
+    check(error <= 1e-4 * norm, name + ": matches the dense solve");
+}
+
+static void checkLarge(const string& name, const SparseMatrix& A, mt19937& rng) {
+    AggregationMultigrid multigrid(A);
+    check(multigrid.getLevelCount() > 1, name + ": builds a hierarchy");
+    checkPreconditioner(name, multigrid, A.rows, rng);
+
+    vector<double> b = randomVector(A.rows, rng), x, xJacobi;
+    SolveResult result = ConjugateGradient::solve(A, b, x, 1e-8, 0, &multigrid);
+    SolveResult jacobi = ConjugateGradient::solve(A, b, xJacobi, 1e-8);
+    check(result.converged && jacobi.converged, name + ": converges");
+    check(residualOf(A, b, x) <= 1e-6, name + ": true residual is small");
+    check(result.iterations < jacobi.iterations, name + ": multigrid needs fewer iterations than Jacobi (" +
+          to_string(result.iterations) + " against " + to_string(jacobi.iterations) + ")");
+
+    // A warm start from the solution needs no further iterations
+    SolveResult warm = ConjugateGradient::solve(A, b, x, 1e-8, 0, &multigrid);
+    check(warm.converged && warm.iterations == 0, name + ": warm start from the solution");
+}
+
+int main(int argc, char* argv[]) {
+    return SelfCheck::run("solvercheck", argc, argv, [](mt19937& rng) {
+        // Small coarse limits force deep hierarchies on systems the dense solve can still check
+        for (int trial = 0; trial < 12; trial++) {
+            size_t coarseLimit = (trial % 3 == 0) ? 400 : 4 + rng() % 30;
+            checkAgainstDense("grid " + to_string(trial), gridNetwork(5 + rng() % 16, rng), coarseLimit, rng);
+            checkAgainstDense("loose network " + to_string(trial), looseNetwork(2 + rng() % 400, rng), coarseLimit, rng);
+        }
+        checkLarge("grid 100x100", gridNetwork(100, rng), rng);
+        checkLarge("loose network of 10000", looseNetwork(10000, rng), rng);
+
+        // Solving an empty system, and rejecting a matrix that is not positive definite
+        SparseMatrix empty = SparseMatrix::fromTriplets(0, {});
+        vector<double> none;
+        check(ConjugateGradient::solve(empty, {}, none).converged, "empty system");
+        SparseMatrix floating = SparseMatrix::fromTriplets(2, {{0, 0, 1.0}, {0, 1, -1.0}, {1, 0, -1.0}});
+        bool threw = false;
+        try {
+            ConjugateGradient::solve(floating, {1.0, 1.0}, none);
+        } catch (const runtime_error&) {
+            threw = true;
+        }
+        check(threw, "matrix with a zero diagonal is rejected");
+    });
+}
@@ -4,6 +4,8 @@
 #include <iostream>
 #include <vector>
 #include <string>
+#include <memory>
+#include <stdexcept>
 
 using namespace std;
 
@@ -16,6 +18,7 @@ protected:
     int engineSize;
     string vehicle;
     double carbonEmissions = 0.0;
+    double congestionFactor = 1.0;   // emissions multiplier from time spent in traffic
 
 protected:
     double getEmissionFactor() const {
@@ -26,12 +29,32 @@ protected:
         return 1.0;
     }
 
+    // Only write when the value changes, so vehicles shared between forked cities stay untouched
+    void setCarbonEmissions(double emissions) {
+        if (emissions != carbonEmissions) {
+            carbonEmissions = emissions;
+        }
+    }
+
 public:
     Transport(double d, double fA, double fC, string tof, int eS, string veh)
         : distance(d), fuelAmount(fA), fuelCost(fC), typeOfFuel(tof), engineSize(eS), vehicle(veh) {}
 
+    // Emissions for the vehicle's current distance, fuel and congestion
+    virtual double computeCarbonEmissions() const {
+        return fuelAmount * getEmissionFactor() * distance * congestionFactor;
+    }
+
+    // Recompute and print the vehicle's emissions
     virtual void calculateCarbonEmissions() = 0;
+
+    // Recompute without printing
+    void updateCarbonEmissions() {
+        setCarbonEmissions(computeCarbonEmissions());
+    }
+
     virtual void calculateTotalFuelCost() = 0;
+    virtual unique_ptr<Transport> clone() const = 0;
 
     virtual void displayInfo() {
         calculateCarbonEmissions();
@@ -48,9 +71,19 @@ public:
     double getCarbonEmissions() const {
         return carbonEmissions;
     }
+
+    double getCongestionFactor() const { return congestionFactor; }
+
+    void setCongestionFactor(double factor) {
+        if (factor <= 0) {
+            throw invalid_argument("Congestion factor must be positive");
+        }
+        congestionFactor = factor;
+        setCarbonEmissions(computeCarbonEmissions());
+    }
     
     // Getter for vehicle type
-    string getType() const { return vehicle; }
+    const string& getType() const { return vehicle; }
     
     virtual ~Transport() {}
 };
@@ -59,8 +92,12 @@ class Bicycle : public Transport {
 public:
     Bicycle(double d) : Transport(d, 0.0, 0.0, "None", 0, "Bicycle") {}
 
+    double computeCarbonEmissions() const override {
+        return 0.0;
+    }
+
     void calculateCarbonEmissions() override {
-        carbonEmissions = 0.0;
+        setCarbonEmissions(computeCarbonEmissions());
         cout << "Carbon emissions for bicycle: " << carbonEmissions << " kg CO2 (zero emissions)\n";
     }
 
@@ -74,6 +111,10 @@ public:
         Transport::displayInfo();
         cout << "Eco-friendly transport as a bicycle uses no fuel !!\n";
     }
+
+    unique_ptr<Transport> clone() const override {
+        return make_unique<Bicycle>(*this);
+    }
 };
 
 class Car : public Transport {
@@ -85,7 +126,7 @@ public:
         : Transport(d, fA, fC, tof, eS, "Car"), ownerName(owner) {}
 
     void calculateCarbonEmissions() override {
-        carbonEmissions = fuelAmount * getEmissionFactor() * distance;
+        setCarbonEmissions(computeCarbonEmissions());
         cout << "Carbon emissions for car: " << carbonEmissions << " kg CO2\n";
     }
 
@@ -101,6 +142,10 @@ public:
             cout << "Owner: " << ownerName << "\n";
         }
     }
+
+    unique_ptr<Transport> clone() const override {
+        return make_unique<Car>(*this);
+    }
 };
 
 class Bus : public Transport {
@@ -112,7 +157,7 @@ public:
         : Transport(d, fA, fC, tof, eS, "Bus"), governmentDepartment(govDept) {}
 
     void calculateCarbonEmissions() override {
-        carbonEmissions = fuelAmount * getEmissionFactor() * distance;
+        setCarbonEmissions(computeCarbonEmissions());
     }
 
     void calculateTotalFuelCost() override {
@@ -125,6 +170,10 @@ public:
         Transport::displayInfo();
         cout << "Operated by: " << governmentDepartment << "\n";
     }
+
+    unique_ptr<Transport> clone() const override {
+        return make_unique<Bus>(*this);
+    }
 };
 
 class Train : public Transport {
@@ -136,7 +185,7 @@ public:
         : Transport(d, fA, fC, tof, eS, "Train"), railwayCompany(company) {}
 
     void calculateCarbonEmissions() override {
-        carbonEmissions = fuelAmount * getEmissionFactor() * distance;
+        setCarbonEmissions(computeCarbonEmissions());
     }
 
     void calculateTotalFuelCost() override {
@@ -149,6 +198,10 @@ public:
         Transport::displayInfo();
         cout << "Railway Company: " << railwayCompany << "\n";
     }
+
+    unique_ptr<Transport> clone() const override {
+        return make_unique<Train>(*this);
+    }
 };
 
 class Plane : public Transport {
@@ -160,7 +213,7 @@ public:
         : Transport(d, fA, fC, tof, eS, "Plane"), airline(airlineName) {}
 
     void calculateCarbonEmissions() override {
-        carbonEmissions = fuelAmount * getEmissionFactor() * distance;
+        setCarbonEmissions(computeCarbonEmissions());
     }
 
     void calculateTotalFuelCost() override {
@@ -175,6 +228,10 @@ public:
             cout << "Airline: " << airline << "\n";
         }
     }
+
+    unique_ptr<Transport> clone() const override {
+        return make_unique<Plane>(*this);
+    }
 };
 
 class Bike : public Transport {
@@ -186,7 +243,7 @@ public:
         : Transport(d, fA, fC, tof, eS, "Bike"), ownerName(owner) {}
 
     void calculateCarbonEmissions() override {
-        carbonEmissions = fuelAmount * getEmissionFactor() * distance;
+        setCarbonEmissions(computeCarbonEmissions());
     }
 
     void calculateTotalFuelCost() override {
@@ -201,6 +258,10 @@ public:
             cout << "Owner: " << ownerName << "\n";
         }
     }
+
+    unique_ptr<Transport> clone() const override {
+        return make_unique<Bike>(*this);
+    }
 };
 
 // Function to handle vehicle creation and menu interaction
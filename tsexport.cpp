@@ -0,0 +1,29 @@
+// Exports a city time series file as CSV
+//
+//   tsexport <series file> [first day [last day]]
+
+#include <iostream>
+#include <string>
+#include <limits>
+
+#include "TimeSeries.h"
+
+using namespace std;
+
+int main(int argc, char* argv[]) {
+    if (argc < 2 || argc > 4) {
+        cerr << "Usage: " << argv[0] << " <series file> [first day [last day]]" << endl;
+        return 2;
+    }
+
+    try {
+        int64_t fromDay = (argc >= 3) ? stoll(argv[2]) : numeric_limits<int64_t>::min();
+        int64_t toDay = (argc == 4) ? stoll(argv[3]) : numeric_limits<int64_t>::max();
+        TimeSeriesReader reader(argv[1]);
+        reader.exportCsv(cout, fromDay, toDay);
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}